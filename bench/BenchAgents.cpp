@@ -0,0 +1,103 @@
+// Wandering agents stepped by AgentSim over a generated maze at each worker
+// count, agent-ticks per second against threads
+// Before timing, creating and destroying agents is checked to keep every
+// handle on its own components; after each run the agents have to end up
+// where the single threaded run left them, clear of every wall
+// Usage: BenchAgents [agents] [ticks] [rooms] [maxThreads]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "Agents.hpp"
+#include "BenchMaze.hpp"
+#include "MazeGen.hpp"
+#include "Simulation.hpp"
+
+static int CheckStore() {
+	int failures = 0;
+	AgentStore store;
+	std::vector<AgentHandle> handles;
+	for(int i = 0; i < 1000; i++) {
+		Player player;
+		player.origin = Vec3f((float)i, 0.f, 0.f);
+		handles.push_back(store.Create(player, i));
+	}
+
+	// Every third one, then refill: the survivors keep their own origin
+	for(int i = 0; i < 1000; i += 3) {
+		store.Destroy(handles[i]);
+	}
+	for(int i = 0; i < 1000; i++) {
+		int slot = store.Slot(handles[i]);
+		if((i % 3 == 0) != (slot < 0) || (slot >= 0 && store.transforms.x[slot] != (float)i)) {
+			failures++;
+		}
+	}
+	AgentHandle reused = store.Create(Player(), 0);
+	if(store.Alive(handles[0]) || !store.Alive(reused) || store.Count() != 1000 - 334 + 1) {
+		failures++;
+	}
+	return failures;
+}
+
+int main(int argc, char **argv) {
+	int numAgents = argc > 1 ? atoi(argv[1]) : 16384;
+	int ticks = argc > 2 ? atoi(argv[2]) : 240;
+	int rooms = argc > 3 ? atoi(argv[3]) : 256;
+	int maxThreads = argc > 4 ? atoi(argv[4]) : (int)std::max(4u, std::thread::hardware_concurrency());
+
+	int storeFailures = CheckStore();
+	std::cout << "agent store: " << (storeFailures ? "FAILED" : "ok") << std::endl;
+
+	MazeGenConfig config;
+	config.roomsX = config.roomsY = rooms;
+	TileGrid level;
+	GenerateMaze(config, level);
+	std::cout << level.width << "x" << level.height << " maze, " << numAgents << " agents, " << ticks << " ticks, "
+		<< std::thread::hardware_concurrency() << " cores" << std::endl;
+
+	int failures = 0;
+	std::vector<float> expected;
+	const float dt = 1.f / SIM_TICK_RATE;
+	for(int threads = 1; threads <= maxThreads; threads *= 2) {
+		AgentSim agents;
+		agents.Init(&level, threads);
+		agents.Spawn(numAgents, 1);
+
+		double thinkMs = 0.0, moveMs = 0.0;
+		long long queries = 0;
+		auto start = std::chrono::steady_clock::now();
+		for(int tick = 0; tick < ticks; tick++) {
+			agents.Tick(dt);
+			thinkMs += agents.stats.thinkMs;
+			moveMs += agents.stats.moveMs;
+			queries += agents.stats.collision.queries;
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		const AgentTransforms &transforms = agents.store.transforms;
+		std::vector<float> result;
+		for(int i = 0; i < agents.store.Count(); i++) {
+			result.push_back(transforms.x[i]);
+			result.push_back(transforms.y[i]);
+		}
+		if(expected.empty()) {
+			expected = result;
+		}
+		bool same = result == expected;
+		int overlaps = 0;
+		for(int i = 0; i < agents.store.Count(); i++) {
+			overlaps += BenchWallOverlaps(level, agents.store.transforms.x[i], agents.store.transforms.y[i]);
+		}
+		failures += !same + (overlaps > 0);
+
+		std::cout << "  " << threads << " threads: " << ms / ticks << " ms per tick (think " << thinkMs / ticks << ", move "
+			<< moveMs / ticks << "), " << (double)agents.store.Count() * ticks / (ms / 1000.0) / 1e6 << " M agent-ticks/s, "
+			<< queries / (ms / 1000.0) / 1e6 << " M queries/s" << (same ? "" : ", DIFFERS from 1 thread")
+			<< (overlaps ? ", agents overlap walls" : "") << std::endl;
+	}
+
+	return storeFailures || failures ? 1 : 0;
+}
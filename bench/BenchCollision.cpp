@@ -0,0 +1,156 @@
+// Swept circle collision against the walls of a generated maze
+// Thousands of players run through the maze with their own turning input,
+// every tick moving through StepPlayer and MoveCircle; queries are the
+// sweeps, several per tick for a player sliding along walls
+// Before timing, grid DDA sweeps are checked against sweeping every wall
+// in the bounding box of the motion, and after it no player may overlap a
+// wall; any mismatch fails the run
+// Usage: BenchCollision [rooms] [players] [ticks]
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "BenchMaze.hpp"
+#include "Collision.hpp"
+#include "MazeGen.hpp"
+#include "Profiler.hpp"
+#include "Simulation.hpp"
+
+#define NUM_SWEEP_CHECKS 200000
+#define LONG_SWEEP 32.f
+
+// Every wall in the box around the motion
+static bool ReferenceSweep(const TileGrid &level, float x, float y, float radius, float dx, float dy, SweepHit &hit) {
+	hit = SweepHit();
+	int x0 = (int)floorf(std::min(x, x + dx) - radius + 0.5f), x1 = (int)floorf(std::max(x, x + dx) + radius + 0.5f);
+	int y0 = (int)floorf(std::min(y, y + dy) - radius + 0.5f), y1 = (int)floorf(std::max(y, y + dy) + radius + 0.5f);
+	for(int cy = y0; cy <= y1; cy++) {
+		for(int cx = x0; cx <= x1; cx++) {
+			if(level.IsWall(cx, cy)) {
+				SweepCircleCell(x, y, radius, dx, dy, cx, cy, hit);
+			}
+		}
+	}
+	return hit.hit;
+}
+
+// Somewhere in a room, clear of the walls
+static void RandomStart(int rooms, unsigned int &state, float &x, float &y) {
+	x = 2 * (int)(BenchRandom(state) * rooms) + 1 + (BenchRandom(state) - 0.5f) * (1.f - 2 * PLAYER_RADIUS);
+	y = 2 * (int)(BenchRandom(state) * rooms) + 1 + (BenchRandom(state) - 0.5f) * (1.f - 2 * PLAYER_RADIUS);
+}
+
+static int CheckSweeps(const TileGrid &level, int rooms) {
+	int failures = 0;
+	unsigned int state = 11;
+	CollisionStats stats;
+	for(int i = 0; i < NUM_SWEEP_CHECKS; i++) {
+		float x, y;
+		RandomStart(rooms, state, x, y);
+		float angle = BenchRandom(state) * 6.2831853f, length = BenchRandom(state) * 6.f;
+		float dx = cosf(angle) * length, dy = sinf(angle) * length;
+		if(i % 8 == 0) {
+			dy = 0.f;		// Axis aligned sweeps run along the cell edges
+		}
+
+		SweepHit hit, expected;
+		SweepCircle(level, x, y, PLAYER_RADIUS, dx, dy, hit, stats);
+		ReferenceSweep(level, x, y, PLAYER_RADIUS, dx, dy, expected);
+		if(hit.hit != expected.hit || fabsf(hit.t - expected.t) > 1e-5f) {
+			if(failures < 5) {
+				std::cout << "  sweep from (" << x << ", " << y << ") by (" << dx << ", " << dy << "): " << hit.t
+					<< ", expected " << (expected.hit ? expected.t : 1.f) << std::endl;
+			}
+			failures++;
+		}
+	}
+	return failures;
+}
+
+// Overlap of any wall next to each player
+int main(int argc, char **argv) {
+	int rooms = argc > 1 ? atoi(argv[1]) : 512;
+	int numPlayers = argc > 2 ? atoi(argv[2]) : 4096;
+	int ticks = argc > 3 ? atoi(argv[3]) : 600;
+
+	MazeGenConfig config;
+	config.roomsX = config.roomsY = rooms;
+	TileGrid level;
+	GenerateMaze(config, level);
+	std::cout << level.width << "x" << level.height << " maze, " << numPlayers << " players, " << ticks << " ticks" << std::endl;
+
+	int sweepFailures = CheckSweeps(level, rooms);
+	std::cout << "sweeps against every wall in the box: " << (sweepFailures ? "FAILED" : "ok") << " (" << sweepFailures
+		<< " mismatches)" << std::endl;
+
+	unsigned int state = 7;
+	std::vector<Player> players(numPlayers);
+	std::vector<PlayerInput> inputs(numPlayers);
+	for(int i = 0; i < numPlayers; i++) {
+		RandomStart(rooms, state, players[i].origin.x, players[i].origin.y);
+		players[i].yaw = BenchRandom(state) * 6.2831853f;
+		inputs[i].forward = 1.f;
+	}
+
+	const float dt = 1.f / SIM_TICK_RATE;
+	CollisionStats stats;
+	double ms = 0.0;
+	for(int tick = 0; tick < ticks; tick++) {
+		// New turning about twice a second
+		for(PlayerInput &input : inputs) {
+			if(BenchRandom(state) < 2.f * dt) {
+				input.turn = BenchRandom(state) * 2.f - 1.f;
+				input.right = BenchRandom(state) < 0.2f ? 1.f : 0.f;
+			}
+		}
+		ms += TimeMs([&]() {
+			for(int i = 0; i < numPlayers; i++) {
+				StepPlayer(players[i], inputs[i], dt, &level, stats);
+			}
+		});
+	}
+
+	int overlaps = 0;
+	for(const Player &player : players) {
+		overlaps += BenchWallOverlaps(level, player.origin.x, player.origin.y);
+	}
+	std::cout << "players overlapping walls: " << (overlaps ? "FAILED" : "ok") << " (" << overlaps << ")" << std::endl;
+
+	std::cout << "  ticks:  " << ms / ticks << " ms per tick, " << stats.queries / (ms / 1000.0) / 1e6 << " M queries/s, "
+		<< (double)stats.queries / ((double)ticks * numPlayers) << " queries per move, "
+		<< (double)stats.cellsVisited / stats.queries << " cells and " << (double)stats.wallsTested / stats.queries
+		<< " walls per query, " << 100.0 * stats.hits / stats.queries << "% hit" << std::endl;
+
+	// Long sweeps, the DDA stops at the first wall while the box grows with the motion
+	std::vector<float> sweeps;
+	for(int i = 0; i < 100000; i++) {
+		float x, y;
+		RandomStart(rooms, state, x, y);
+		float angle = BenchRandom(state) * 6.2831853f;
+		sweeps.insert(sweeps.end(), { x, y, cosf(angle) * LONG_SWEEP, sinf(angle) * LONG_SWEEP });
+	}
+	double check = 0.0, referenceCheck = 0.0;
+	CollisionStats longStats;
+	double ddaMs = TimeMs([&]() {
+		for(size_t i = 0; i < sweeps.size(); i += 4) {
+			SweepHit hit;
+			SweepCircle(level, sweeps[i], sweeps[i + 1], PLAYER_RADIUS, sweeps[i + 2], sweeps[i + 3], hit, longStats);
+			check += hit.t;
+		}
+	});
+	double referenceMs = TimeMs([&]() {
+		for(size_t i = 0; i < sweeps.size(); i += 4) {
+			SweepHit hit;
+			ReferenceSweep(level, sweeps[i], sweeps[i + 1], PLAYER_RADIUS, sweeps[i + 2], sweeps[i + 3], hit);
+			referenceCheck += hit.t;
+		}
+	});
+	std::cout << "  " << LONG_SWEEP << " cell sweeps: dda " << 1e6 * ddaMs / (sweeps.size() / 4) << " ns ("
+		<< (double)longStats.cellsVisited / longStats.queries << " cells), box " << 1e6 * referenceMs / (sweeps.size() / 4)
+		<< " ns (checksums " << check << ", " << referenceCheck << ")" << std::endl;
+
+	return sweepFailures || overlaps ? 1 : 0;
+}
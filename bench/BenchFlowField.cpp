@@ -0,0 +1,204 @@
+// Goal flow field for many agents against a path search per agent, on a
+// generated maze with some walls knocked out and doors in the corridors
+// The field is built at each worker count and checked against a plain
+// queue BFS; door toggles are repaired incrementally and checked against a
+// full rebuild; following the field from every agent has to take exactly
+// its distance in steps, and the searches have to give walkable paths;
+// any mismatch fails the run
+// The searches move in eight directions where the field moves in four, so
+// they only compare in cost
+// Usage: BenchFlowField [rooms] [agents] [doors] [maxThreads]
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "BenchMaze.hpp"
+#include "FlowField.hpp"
+#include "MazeGen.hpp"
+#include "Pathfind.hpp"
+#include "Profiler.hpp"
+
+#define BRAID_PERCENT 10
+#define SEARCHED_AGENTS 32
+
+static std::vector<uint32_t> ReferenceDistances(const FlowField &field, const TileGrid &level, const std::vector<PathCell> &goals) {
+	std::vector<uint32_t> distance((size_t)level.width * level.height, FLOW_UNREACHABLE);
+	std::vector<PathCell> queue;
+	for(const PathCell &goal : goals) {
+		if(!field.Blocked(goal.x, goal.y)) {
+			distance[(size_t)goal.y * level.width + goal.x] = 0;
+			queue.push_back(goal);
+		}
+	}
+	static const int steps[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+	for(size_t i = 0; i < queue.size(); i++) {
+		PathCell c = queue[i];
+		uint32_t d = distance[(size_t)c.y * level.width + c.x];
+		for(const int *step : steps) {
+			int nx = c.x + step[0], ny = c.y + step[1];
+			if(!field.Blocked(nx, ny) && distance[(size_t)ny * level.width + nx] == FLOW_UNREACHABLE) {
+				distance[(size_t)ny * level.width + nx] = d + 1;
+				queue.push_back({ nx, ny });
+			}
+		}
+	}
+	return distance;
+}
+
+static int CompareFields(const FlowField &a, const FlowField &b, const TileGrid &level) {
+	int mismatches = 0;
+	for(int y = 0; y < level.height; y++) {
+		for(int x = 0; x < level.width; x++) {
+			mismatches += a.Distance(x, y) != b.Distance(x, y) || a.Direction(x, y) != b.Direction(x, y);
+		}
+	}
+	return mismatches;
+}
+
+// Steps taken following the field from (x, y), -1 if it does not lead to a goal
+static long long Follow(const FlowField &field, int x, int y) {
+	static const int steps[][2] = { { 0, 0 }, { 0, 0 }, { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+	long long limit = field.Distance(x, y);
+	for(long long taken = 0; taken <= limit; taken++) {
+		FlowDirection direction = field.Direction(x, y);
+		if(direction == FLOW_GOAL) {
+			return taken;
+		}
+		if(direction == FLOW_NONE) {
+			break;
+		}
+		x += steps[direction][0];
+		y += steps[direction][1];
+	}
+	return -1;
+}
+
+int main(int argc, char **argv) {
+	int rooms = argc > 1 ? atoi(argv[1]) : 1024;
+	int numAgents = argc > 2 ? atoi(argv[2]) : 4096;
+	int numDoors = argc > 3 ? atoi(argv[3]) : 64;
+	int maxThreads = argc > 4 ? atoi(argv[4]) : (int)std::max(4u, std::thread::hardware_concurrency());
+
+	MazeGenConfig config;
+	config.roomsX = config.roomsY = rooms;
+	TileGrid level;
+	GenerateMaze(config, level);
+
+	// Loops, so a closed door reroutes instead of cutting the maze in two
+	BenchBraid(level, BRAID_PERCENT);
+	MazeRng rng(3);
+	std::vector<PathCell> doors;
+	while((int)doors.size() < numDoors) {
+		int x = rng.Below(level.width - 2) + 1, y = rng.Below(level.height - 2) + 1;
+		if((x + y) % 2 == 1 && level.At(x, y) == LEVEL_AIR) {
+			level.Set(x, y, LEVEL_DOOR);
+			doors.push_back({ x, y });
+		}
+	}
+
+	std::vector<PathCell> goals;
+	int gx, gy;
+	FindTile(level, LEVEL_GOAL, gx, gy);
+	goals.push_back({ gx, gy });
+
+	std::vector<PathCell> agents;
+	while((int)agents.size() < numAgents) {
+		int x = rng.Below(level.width), y = rng.Below(level.height);
+		if(level.At(x, y) == LEVEL_AIR) {
+			agents.push_back({ x, y });
+		}
+	}
+	std::cout << level.width << "x" << level.height << " maze, " << numAgents << " agents, " << numDoors << " doors, "
+		<< std::thread::hardware_concurrency() << " cores" << std::endl;
+
+	int failures = 0;
+
+	// Full builds, the same field at every thread count
+	FlowField field;
+	field.Init(&level, 1);
+	double buildMs = TimeMs([&]() { field.Build(goals); });
+
+	std::vector<uint32_t> expected = ReferenceDistances(field, level, goals);
+	int mismatches = 0;
+	for(int y = 0; y < level.height; y++) {
+		for(int x = 0; x < level.width; x++) {
+			mismatches += field.Distance(x, y) != expected[(size_t)y * level.width + x];
+		}
+	}
+	failures += mismatches;
+	std::cout << "distances against a queue BFS: " << (mismatches ? "FAILED" : "ok") << " (" << field.levels << " levels)"
+		<< std::endl;
+	std::cout << "  build, 1 thread: " << buildMs << " ms" << std::endl;
+
+	for(int threads = 2; threads <= maxThreads; threads *= 2) {
+		FlowField parallel;
+		parallel.Init(&level, threads);
+		double ms = TimeMs([&]() { parallel.Build(goals); });
+		int differences = CompareFields(field, parallel, level);
+		failures += differences;
+		std::cout << "  build, " << threads << " threads: " << ms << " ms" << (differences ? ", DIFFERS from 1 thread" : "")
+			<< std::endl;
+	}
+
+	// Every agent walks the field to the goal, a lookup per step
+	int wrong = 0;
+	long long totalSteps = 0;
+	double lookupMs = TimeMs([&]() {
+		for(const PathCell &agent : agents) {
+			long long steps = Follow(field, agent.x, agent.y);
+			wrong += steps != (field.Distance(agent.x, agent.y) == FLOW_UNREACHABLE ? -1 : (long long)field.Distance(agent.x, agent.y));
+			totalSteps += steps > 0 ? steps : 0;
+		}
+	});
+	failures += wrong;
+	std::cout << "following the field: " << (wrong ? "FAILED" : "ok") << ", " << 1e6 * lookupMs / totalSteps << " ns per step"
+		<< std::endl;
+
+	// Doors: every one opened, then every other one closed again
+	FlowField rebuilt;
+	rebuilt.Init(&level, 1);
+	double toggleMs = 0.0;
+	long long recomputed = 0;
+	int toggles = 0, doorMismatches = 0;
+	for(int pass = 0; pass < 2; pass++) {
+		for(size_t i = pass; i < doors.size(); i += 1 + pass) {
+			toggleMs += TimeMs([&]() { recomputed += field.SetDoor(doors[i].x, doors[i].y, pass == 0); });
+			toggles++;
+		}
+		for(const PathCell &door : doors) {
+			rebuilt.SetDoor(door.x, door.y, field.DoorOpen(door.x, door.y));
+		}
+		rebuilt.Build(goals);
+		doorMismatches += CompareFields(field, rebuilt, level);
+	}
+	failures += doorMismatches;
+	std::cout << "door toggles against a rebuild: " << (doorMismatches ? "FAILED" : "ok") << ", " << toggleMs / toggles
+		<< " ms and " << recomputed / toggles << " cells per toggle, rebuild " << buildMs << " ms" << std::endl;
+
+	// A search per agent instead, a few of them timed and scaled up
+	for(int algorithm = PATH_ASTAR; algorithm <= PATH_JPS; algorithm++) {
+		Pathfinder finder;
+		finder.Init(&level);
+		std::vector<PathCell> path;
+		int searched = std::min(numAgents, SEARCHED_AGENTS);
+		double ms = TimeMs([&]() {
+			for(int i = 0; i < searched; i++) {
+				finder.Find((PathAlgorithm)algorithm, agents[i].x, agents[i].y, gx, gy, path);
+			}
+		});
+
+		// Checked apart from the timing
+		int bad = 0;
+		for(int i = 0; i < searched; i++) {
+			bool found = finder.Find((PathAlgorithm)algorithm, agents[i].x, agents[i].y, gx, gy, path);
+			bad += found && !BenchCheckPath(level, path, finder.Cost(), agents[i].x, agents[i].y, gx, gy);
+		}
+		failures += bad;
+		std::cout << "  " << (algorithm == PATH_JPS ? "jps" : "a* ") << " per agent: " << ms / searched << " ms, "
+			<< ms / searched * numAgents << " ms for every agent" << (bad ? ", BAD PATHS" : "") << std::endl;
+	}
+	std::cout << "  flow field: " << buildMs << " ms build + " << lookupMs << " ms walking every agent to the goal" << std::endl;
+
+	return failures ? 1 : 0;
+}
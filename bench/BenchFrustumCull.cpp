@@ -0,0 +1,165 @@
+// CPU cost of submitting the grid with and without frustum culling, against
+// maze size. Submission is modelled on the per-cell draw path (model-view,
+// MVP and normal matrix per draw) and on building the instance list
+// The hierarchical result is checked against testing every cell on its own
+// Usage: BenchFrustumCull [maxSize]
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "GridCuller.hpp"
+#include "MazeGen.hpp"
+
+// Column-major 4x4 matrices, laid out like glm
+struct Mat4 {
+	float m[16];
+};
+
+static Mat4 Multiply(const Mat4 &a, const Mat4 &b) {
+	Mat4 r;
+	for(int c = 0; c < 4; c++) {
+		for(int row = 0; row < 4; row++) {
+			float sum = 0.f;
+			for(int k = 0; k < 4; k++) {
+				sum += a.m[k * 4 + row] * b.m[c * 4 + k];
+			}
+			r.m[c * 4 + row] = sum;
+		}
+	}
+	return r;
+}
+
+static Mat4 Perspective(float fovy, float aspect, float zNear, float zFar) {
+	Mat4 r = {};
+	float f = 1.f / tanf(fovy / 2.f);
+	r.m[0] = f / aspect;
+	r.m[5] = f;
+	r.m[10] = -(zFar + zNear) / (zFar - zNear);
+	r.m[11] = -1.f;
+	r.m[14] = -2.f * zFar * zNear / (zFar - zNear);
+	return r;
+}
+
+static Mat4 LookAt(const float *eye, const float *center, const float *up) {
+	float f[3] = { center[0] - eye[0], center[1] - eye[1], center[2] - eye[2] };
+	float fl = sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+	for(float &v : f) v /= fl;
+	float s[3] = { f[1] * up[2] - f[2] * up[1], f[2] * up[0] - f[0] * up[2], f[0] * up[1] - f[1] * up[0] };
+	float sl = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+	for(float &v : s) v /= sl;
+	float u[3] = { s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0] };
+
+	Mat4 r = {};
+	for(int i = 0; i < 3; i++) {
+		r.m[i * 4 + 0] = s[i];
+		r.m[i * 4 + 1] = u[i];
+		r.m[i * 4 + 2] = -f[i];
+	}
+	r.m[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+	r.m[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+	r.m[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+	r.m[15] = 1.f;
+	return r;
+}
+
+// What DrawModel computes on the CPU for one draw
+static float SubmitCell(const Mat4 &view, const Mat4 &proj, int x, int y, float z) {
+	Mat4 model = {};
+	model.m[0] = model.m[5] = model.m[10] = model.m[15] = 1.f;
+	model.m[12] = (float)x;
+	model.m[13] = (float)y;
+	model.m[14] = z;
+	Mat4 modelView = Multiply(view, model);
+	Mat4 mvp = Multiply(proj, modelView);
+
+	// Inverse transpose of the upper 3x3
+	const float *a = modelView.m;
+	float det = a[0] * (a[5] * a[10] - a[9] * a[6]) - a[4] * (a[1] * a[10] - a[9] * a[2]) + a[8] * (a[1] * a[6] - a[5] * a[2]);
+	return mvp.m[15] + 1.f / det;
+}
+
+struct Camera {
+	const char	*name;
+	float		eye[3];
+	float		center[3];
+	float		zFar;
+};
+
+int main(int argc, char **argv) {
+	int maxSize = argc > 1 ? atoi(argv[1]) : 2048;
+	const GridCullBounds bounds = { -1.5f, 0.5f };
+	const float up[3] = { 0.f, 0.f, 1.f };
+
+	bool ok = true;
+	for(int size = 64; size <= maxSize; size *= 2) {
+		MazeGenConfig config;
+		config.roomsX = config.roomsY = size / 2;
+		TileGrid level;
+		GenerateMaze(config, level);
+
+		// The fixed camera of BeginRendering, and an eye-level one inside the maze
+		float mid = level.width / 2.f;
+		Camera cameras[] = {
+			{ "app camera", { 5.f, 0.f, 0.f }, { 0.f, 0.f, 0.f }, 10.f },
+			{ "in maze, far 64", { mid, mid, 0.2f }, { mid + 1.f, mid + 0.5f, 0.1f }, 64.f }
+		};
+
+		std::cout << level.width << "x" << level.height << std::endl;
+		for(const Camera &camera : cameras) {
+			Mat4 view = LookAt(camera.eye, camera.center, up);
+			Mat4 proj = Perspective(45.f * 3.14159265f / 180.f, 1200.f / 900.f, 1.f, camera.zFar);
+			Frustum frustum;
+			frustum.Extract(Multiply(proj, view).m);
+
+			auto submit = [&](int y, int x0, int x1) {
+				float sink = 0.f;
+				for(int x = x0; x < x1; x++) {
+					if(level.At(x, y) == LEVEL_WALL) {
+						sink += SubmitCell(view, proj, x, y, 0.f);
+					}
+					sink += SubmitCell(view, proj, x, y, -1.f);
+				}
+				return sink;
+			};
+
+			float sink = 0.f;
+			auto start = std::chrono::steady_clock::now();
+			for(int y = 0; y < level.height; y++) {
+				sink += submit(y, 0, level.width);
+			}
+			double allMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			std::vector<CellSpan> spans;
+			CullStats stats;
+			start = std::chrono::steady_clock::now();
+			CullGrid(frustum, bounds, 0, 0, level.width, level.height, spans, stats);
+			double cullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			for(const CellSpan &span : spans) {
+				sink += submit(span.y, span.x0, span.x1);
+			}
+			double culledMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			// Brute force reference
+			long long reference = 0;
+			for(int y = 0; y < level.height; y++) {
+				for(int x = 0; x < level.width; x++) {
+					float boxMin[3] = { x - 0.5f, y - 0.5f, bounds.zMin };
+					float boxMax[3] = { x + 0.5f, y + 0.5f, bounds.zMax };
+					reference += frustum.TestBox(boxMin, boxMax) != CULL_OUTSIDE;
+				}
+			}
+			bool match = reference == stats.cellsVisible
+				&& (long long)stats.cellsVisible + stats.cellsCulled == (long long)level.width * level.height;
+			ok = ok && match;
+
+			std::cout << "  " << camera.name << ": all cells " << allMs << " ms, culled " << culledMs
+				<< " ms (cull " << cullMs << " ms); " << stats.nodesTested << " nodes, " << stats.cellsTested
+				<< " cells tested, " << stats.cellsCulled << " culled, " << stats.cellsVisible << " drawn"
+				<< (match ? "" : ", MISMATCH") << (sink == 12345.f ? " " : "") << std::endl;
+		}
+	}
+
+	return ok ? 0 : 1;
+}
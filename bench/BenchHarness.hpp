@@ -0,0 +1,206 @@
+#ifndef BENCH_HARNESS_INCLUDED
+#define BENCH_HARNESS_INCLUDED
+
+// Repetitions, warmup and summary statistics for microbenchmarks, with the
+// results written as JSON so runs can be diffed commit to commit
+// Options: --reps n, --warmup n, --filter substring, --json file, --revision id
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Linear congruential floats in [0, 1), the same sequence on every platform
+inline float BenchRandom(unsigned int &state) {
+	state = state * 1664525u + 1013904223u;
+	return (state >> 8) / 16777216.f;
+}
+
+// The same sequence spread over [-1, 1)
+inline float BenchRandomSigned(unsigned int &state) {
+	return BenchRandom(state) * 2.f - 1.f;
+}
+
+// Keeps the compiler from dropping a result that is never read
+template <typename T>
+inline void BenchKeep(const T &value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult {
+	std::string			group;
+	std::string			name;
+	std::string			unit;
+	double				items = 0;		// Units of work per repetition
+	std::vector<double>	samplesMs;
+
+	double	minMs = 0;
+	double	medianMs = 0;
+	double	meanMs = 0;
+	double	stddevMs = 0;
+	double	maxMs = 0;
+
+	// Relative spread, above a few percent the machine was busy
+	double Cv() const { return meanMs > 0 ? stddevMs / meanMs : 0; }
+
+	// Throughput at the median
+	double ItemsPerSecond() const { return medianMs > 0 ? items / (medianMs / 1000.0) : 0; }
+};
+
+class BenchHarness {
+public:
+	BenchHarness(int argc, char **argv) {
+		for(int i = 1; i < argc; i++) {
+			bool hasValue = i + 1 < argc;
+			if(!strcmp(argv[i], "--reps") && hasValue) {
+				m_reps = std::max(1, atoi(argv[++i]));
+			}
+			else if(!strcmp(argv[i], "--warmup") && hasValue) {
+				m_warmup = std::max(0, atoi(argv[++i]));
+			}
+			else if(!strcmp(argv[i], "--filter") && hasValue) {
+				m_filter = argv[++i];
+			}
+			else if(!strcmp(argv[i], "--json") && hasValue) {
+				m_jsonFile = argv[++i];
+			}
+			else if(!strcmp(argv[i], "--revision") && hasValue) {
+				m_revision = argv[++i];
+			}
+			else {
+				std::cerr << "Usage: " << argv[0] << " [--reps n] [--warmup n] [--filter substring] [--json file] [--revision id]"
+					<< std::endl;
+				exit(-1);
+			}
+		}
+	}
+
+	// Times body, which does items units of work, over the warmup and then
+	// the measured repetitions; skipped if group/name misses the filter
+	template <typename Fn>
+	void Run(const char *group, const char *name, double items, const char *unit, Fn body) {
+		std::string fullName = std::string(group) + "/" + name;
+		if(!m_filter.empty() && fullName.find(m_filter) == std::string::npos) {
+			return;
+		}
+
+		for(int i = 0; i < m_warmup; i++) {
+			body();
+		}
+
+		BenchResult result;
+		result.group = group;
+		result.name = name;
+		result.unit = unit;
+		result.items = items;
+		for(int i = 0; i < m_reps; i++) {
+			auto start = std::chrono::steady_clock::now();
+			body();
+			result.samplesMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		Summarize(result);
+
+		std::cout << std::left << std::setw(36) << fullName << std::right << std::fixed << std::setprecision(4)
+			<< std::setw(12) << result.medianMs << " ms" << std::setw(12) << result.minMs << " ms  cv "
+			<< std::setprecision(1) << std::setw(5) << result.Cv() * 100.0 << "%  " << std::setprecision(3)
+			<< std::scientific << result.ItemsPerSecond() << " " << unit << "/s" << std::defaultfloat << std::endl;
+		m_results.push_back(result);
+	}
+
+	// A correctness check failed, the run still finishes but exits non-zero
+	void Fail(const std::string &message) {
+		std::cout << "FAILED: " << message << std::endl;
+		m_failures++;
+	}
+
+	// Writes the JSON results if asked to, and returns the exit code
+	int Finish() {
+		if(!m_jsonFile.empty() && !WriteJson()) {
+			std::cerr << "Failed to write " << m_jsonFile << std::endl;
+			return 1;
+		}
+		return m_failures ? 1 : 0;
+	}
+
+private:
+	static void Summarize(BenchResult &result) {
+		std::vector<double> sorted = result.samplesMs;
+		std::sort(sorted.begin(), sorted.end());
+		size_t n = sorted.size();
+
+		result.minMs = sorted.front();
+		result.maxMs = sorted.back();
+		result.medianMs = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+
+		double sum = 0;
+		for(double s : sorted) {
+			sum += s;
+		}
+		result.meanMs = sum / n;
+
+		double squares = 0;
+		for(double s : sorted) {
+			squares += (s - result.meanMs) * (s - result.meanMs);
+		}
+		result.stddevMs = n > 1 ? sqrt(squares / (n - 1)) : 0;
+	}
+
+	static std::string Quote(const std::string &s) {
+		std::string out = "\"";
+		for(char c : s) {
+			if(c == '"' || c == '\\') {
+				out += '\\';
+			}
+			out += c;
+		}
+		return out + "\"";
+	}
+
+	bool WriteJson() const {
+		std::ofstream out(m_jsonFile, std::ios::trunc);
+		if(!out.is_open()) {
+			return false;
+		}
+
+		out << std::setprecision(9);
+		out << "{\n";
+		out << "  \"revision\": " << Quote(m_revision) << ",\n";
+		out << "  \"compiler\": " << Quote(__VERSION__) << ",\n";
+		out << "  \"reps\": " << m_reps << ",\n";
+		out << "  \"warmup\": " << m_warmup << ",\n";
+		out << "  \"failures\": " << m_failures << ",\n";
+		out << "  \"results\": [";
+		for(size_t i = 0; i < m_results.size(); i++) {
+			const BenchResult &r = m_results[i];
+			out << (i ? "," : "") << "\n    {\n";
+			out << "      \"group\": " << Quote(r.group) << ", \"name\": " << Quote(r.name) << ",\n";
+			out << "      \"unit\": " << Quote(r.unit) << ", \"items\": " << r.items << ",\n";
+			out << "      \"min_ms\": " << r.minMs << ", \"median_ms\": " << r.medianMs << ", \"mean_ms\": " << r.meanMs
+				<< ", \"stddev_ms\": " << r.stddevMs << ", \"max_ms\": " << r.maxMs << ",\n";
+			out << "      \"cv\": " << r.Cv() << ", \"items_per_second\": " << r.ItemsPerSecond() << ",\n";
+			out << "      \"samples_ms\": [";
+			for(size_t s = 0; s < r.samplesMs.size(); s++) {
+				out << (s ? ", " : "") << r.samplesMs[s];
+			}
+			out << "]\n    }";
+		}
+		out << "\n  ]\n}\n";
+
+		return (bool)out;
+	}
+
+	int							m_reps = 15;
+	int							m_warmup = 3;
+	std::string					m_filter;
+	std::string					m_jsonFile;
+	std::string					m_revision = "unknown";
+	std::vector<BenchResult>	m_results;
+	int							m_failures = 0;
+};
+
+#endif
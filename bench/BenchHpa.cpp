@@ -0,0 +1,185 @@
+// Hierarchical pathfinding against flat A* and jump point search on
+// generated mazes, perfect and braided: graph build time, query latency
+// and how much longer the refined paths come out
+// Every path is checked to be walkable, without cut corners and to cost
+// what the search says; the graph has to survive a save and load, and
+// incremental updates after walls open and close have to give the same
+// graph as building it again; any mismatch fails the run
+// Usage: BenchHpa [rooms] [queries] [clusterSize]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "BenchMaze.hpp"
+#include "Hpa.hpp"
+#include "MazeGen.hpp"
+
+#define BRAID_PERCENT 30
+#define NUM_TOGGLES 200
+#define GRAPH_FILE "/tmp/BenchHpa.hpa"
+#define REBUILT_FILE "/tmp/BenchHpa.rebuilt.hpa"
+
+static std::string ReadFile(const char *fileName) {
+	std::ifstream in(fileName, std::ios::binary);
+	std::stringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+static double MsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Latency {
+	double	total = 0.0;
+	double	max = 0.0;
+
+	void Add(double ms) {
+		total += ms;
+		max = std::max(max, ms);
+	}
+};
+
+static int RunLevel(const char *name, TileGrid &level, int rooms, int numQueries, int clusterSize) {
+	int failures = 0;
+	std::cout << name << std::endl;
+
+	auto start = std::chrono::steady_clock::now();
+	Hpa hpa;
+	hpa.Build(&level, clusterSize, 0);
+	std::cout << "  build: " << MsSince(start) << " ms, " << hpa.NumClusters() << " clusters, " << hpa.NumNodes()
+		<< " nodes" << std::endl;
+
+	// Spawn to goal first, then random rooms
+	std::vector<int> queries;
+	int gx, gy;
+	FindTile(level, LEVEL_GOAL, gx, gy);
+	queries.insert(queries.end(), { 1, 1, gx, gy });
+	MazeRng rng(5);
+	for(int i = 1; i < numQueries; i++) {
+		queries.insert(queries.end(), { 2 * (int)rng.Below(rooms) + 1, 2 * (int)rng.Below(rooms) + 1,
+			2 * (int)rng.Below(rooms) + 1, 2 * (int)rng.Below(rooms) + 1 });
+	}
+
+	// Flat searches, A*'s costs are the optimum
+	std::vector<uint64_t> optimal;
+	Pathfinder finder;
+	finder.Init(&level);
+	std::vector<PathCell> path;
+	for(int algorithm = PATH_ASTAR; algorithm <= PATH_JPS; algorithm++) {
+		Latency latency;
+		for(size_t q = 0; q < queries.size(); q += 4) {
+			start = std::chrono::steady_clock::now();
+			bool found = finder.Find((PathAlgorithm)algorithm, queries[q], queries[q + 1], queries[q + 2], queries[q + 3], path);
+			latency.Add(MsSince(start));
+			if(algorithm == PATH_ASTAR) {
+				optimal.push_back(found ? finder.Cost() : 0);
+			}
+		}
+		std::cout << "  " << (algorithm == PATH_JPS ? "jps" : "a* ") << ": " << latency.total / numQueries << " ms mean, "
+			<< latency.max << " ms max" << std::endl;
+	}
+
+	// Hierarchical, checked against the optimum
+	std::vector<uint64_t> costs;
+	Latency latency;
+	double ratio = 0.0, worstRatio = 1.0;
+	int bad = 0;
+	for(size_t q = 0; q < queries.size(); q += 4) {
+		start = std::chrono::steady_clock::now();
+		bool found = hpa.Find(queries[q], queries[q + 1], queries[q + 2], queries[q + 3], path);
+		latency.Add(MsSince(start));
+
+		uint64_t best = optimal[q / 4];
+		costs.push_back(found ? hpa.Cost() : 0);
+		if(found != (best != 0) || (found && !BenchCheckPath(level, path, hpa.Cost(), queries[q], queries[q + 1],
+			queries[q + 2], queries[q + 3])) || (found && hpa.Cost() < best)) {
+			bad++;
+			continue;
+		}
+		double r = best ? (double)hpa.Cost() / best : 1.0;
+		ratio += r;
+		worstRatio = std::max(worstRatio, r);
+	}
+	failures += bad;
+	const HpaStats &stats = hpa.stats;
+	std::cout << "  hpa: " << latency.total / numQueries << " ms mean, " << latency.max << " ms max; "
+		<< (double)stats.abstractExpanded / stats.queries << " nodes and " << (double)stats.refineExpanded / stats.queries
+		<< " cells expanded per query; path length " << ratio / numQueries << "x optimal mean, " << worstRatio << "x worst"
+		<< (bad ? ", BAD PATHS" : "") << std::endl;
+
+	// Round trip through a file
+	Hpa loaded;
+	bool roundTrip = hpa.Save(GRAPH_FILE) && loaded.Load(GRAPH_FILE, &level);
+	for(size_t q = 0; roundTrip && q < queries.size(); q += 4) {
+		bool found = loaded.Find(queries[q], queries[q + 1], queries[q + 2], queries[q + 3], path);
+		roundTrip = (found ? loaded.Cost() : 0) == costs[q / 4];
+	}
+
+	// A node count past the cluster's capacity is refused, not loaded as empty
+	std::string corrupt = ReadFile(GRAPH_FILE);
+	uint32_t tooMany = UINT32_MAX;
+	corrupt.replace(sizeof(HpaHeader), sizeof(tooMany), (const char *)&tooMany, sizeof(tooMany));
+	std::ofstream(GRAPH_FILE, std::ios::binary | std::ios::trunc) << corrupt;
+	roundTrip = roundTrip && !Hpa().Load(GRAPH_FILE, &level);
+	std::cout << "  save and load: " << (roundTrip ? "ok" : "FAILED") << std::endl;
+	failures += !roundTrip;
+
+	// Walls between rooms open and close, like doors, one Update each
+	Latency update;
+	int rebuilt = 0;
+	for(int i = 0; i < NUM_TOGGLES; i++) {
+		int x = 2 * (int)rng.Below(rooms - 1) + 2, y = 2 * (int)rng.Below(rooms) + 1;
+		if(rng.Coin()) {
+			std::swap(x, y);
+		}
+		level.Set(x, y, level.IsWall(x, y) ? LEVEL_AIR : LEVEL_WALL);
+		start = std::chrono::steady_clock::now();
+		rebuilt += hpa.Update(x, y, x + 1, y + 1);
+		update.Add(MsSince(start));
+	}
+
+	Hpa fresh;
+	fresh.Build(&level, clusterSize, 0);
+	bool same = hpa.Save(GRAPH_FILE) && fresh.Save(REBUILT_FILE) && ReadFile(GRAPH_FILE) == ReadFile(REBUILT_FILE);
+	for(size_t q = 0; same && q < queries.size(); q += 4) {
+		bool found = hpa.Find(queries[q], queries[q + 1], queries[q + 2], queries[q + 3], path);
+		same = !found || BenchCheckPath(level, path, hpa.Cost(), queries[q], queries[q + 1], queries[q + 2], queries[q + 3]);
+	}
+	std::cout << "  update: " << update.total / NUM_TOGGLES << " ms mean, " << update.max << " ms max, "
+		<< (double)rebuilt / NUM_TOGGLES << " clusters per toggle; " << (same ? "matches a full build" : "DIFFERS FROM A FULL BUILD")
+		<< std::endl;
+	failures += !same;
+
+	remove(GRAPH_FILE);
+	remove(REBUILT_FILE);
+	return failures;
+}
+
+int main(int argc, char **argv) {
+	int rooms = argc > 1 ? atoi(argv[1]) : 1024;
+	int numQueries = argc > 2 ? atoi(argv[2]) : 50;
+	int clusterSize = argc > 3 ? atoi(argv[3]) : HPA_CLUSTER_SIZE;
+
+	MazeGenConfig config;
+	config.roomsX = config.roomsY = rooms;
+	TileGrid level;
+	GenerateMaze(config, level);
+	std::cout << level.width << "x" << level.height << " (" << (long long)level.width * level.height / 1000000.0
+		<< " M cells), clusters of " << clusterSize << std::endl;
+
+	int failures = RunLevel("perfect maze", level, rooms, numQueries, clusterSize);
+
+	// Again from the untouched maze
+	GenerateMaze(config, level);
+	BenchBraid(level, BRAID_PERCENT);
+	failures += RunLevel("braided maze", level, rooms, numQueries, clusterSize);
+
+	std::cout << (failures ? "FAILED" : "paths ok") << std::endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+// Input recorded under an uneven frame rate, with stalls long enough to
+// drop ticks, then replayed on other frame rates and as fast as it goes
+// Every replay has to end where the recording did, bit for bit, with the
+// agents in the same places, and the log has to survive a save and load;
+// any mismatch fails the run
+// Usage: BenchInputLog [seconds] [agents] [rooms]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "InputLog.hpp"
+#include "MazeGen.hpp"
+#include "Pvs.hpp"
+#include "Simulation.hpp"
+
+#define LOG_FILE "/tmp/BenchInputLog.mzin"
+#define STALL_MS 400		// Every so often, past SIM_MAX_TICKS_PER_ADVANCE
+
+static std::vector<float> AgentPositions(const AgentSim &agents) {
+	std::vector<float> positions;
+	for(int i = 0; i < agents.store.Count(); i++) {
+		positions.push_back(agents.store.transforms.x[i]);
+		positions.push_back(agents.store.transforms.y[i]);
+	}
+	return positions;
+}
+
+// Keys pressed and released now and then, like someone walking the maze
+static PlayerInput RandomInput(MazeRng &rng) {
+	PlayerInput input;
+	input.forward = (float)rng.Below(3) - 1.f;
+	input.right = rng.Below(4) == 0 ? (float)rng.Below(3) - 1.f : 0.f;
+	input.turn = rng.Below(2) == 0 ? (float)rng.Below(3) - 1.f : 0.f;
+	input.look = rng.Below(8) == 0 ? (float)rng.Below(3) - 1.f : 0.f;
+	return input;
+}
+
+// Steps the whole log in frames of frameTicks ticks
+static bool Replay(const InputLog &log, const TileGrid &level, int numAgents, double frameTicks,
+	std::vector<float> &agentPositions, double &ms) {
+	AgentSim agents;
+	agents.Init(&level, 1);
+	agents.Spawn(numAgents, 7);
+
+	Simulation sim;
+	sim.Init(log.StartPlayer(), &level, &agents, log.tickSeconds);
+	sim.Replay(&log);
+
+	auto start = std::chrono::steady_clock::now();
+	long long frames = 0;
+	for(double t = 0.0; !sim.ReplayFinished(); frames++) {
+		t += frameTicks * log.tickSeconds;
+		sim.Advance(t);
+	}
+	ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Every frame steps all the ticks that came due, give or take rounding
+	agentPositions = AgentPositions(agents);
+	return (uint64_t)sim.Ticks() == log.numTicks && log.EndsAt(sim.Current()) && frames <= log.numTicks / frameTicks + 1;
+}
+
+int main(int argc, char **argv) {
+	double seconds = argc > 1 ? atof(argv[1]) : 120.0;
+	int numAgents = argc > 2 ? atoi(argv[2]) : 200;
+	int rooms = argc > 3 ? atoi(argv[3]) : 32;
+	int failures = 0;
+
+	MazeGenConfig config;
+	config.roomsX = config.roomsY = rooms;
+	TileGrid level;
+	GenerateMaze(config, level);
+
+	// Recorded on uneven frames of 1 to 40 ms, stalling every 500th
+	AgentSim agents;
+	agents.Init(&level, 1);
+	agents.Spawn(numAgents, 7);
+	Player spawn;
+	spawn.origin = Vec3f(1.f, 1.f, 0.f);
+
+	Simulation sim;
+	sim.Init(spawn, &level, &agents);
+	InputLog log;
+	log.Begin(sim.TickSeconds(), HashLevelWalls(level), spawn);
+	sim.Record(&log);
+
+	MazeRng rng(3);
+	double t = 0.0;
+	for(int frame = 0; t < seconds; frame++) {
+		if(rng.Below(20) == 0) {
+			sim.SetInput(RandomInput(rng));
+		}
+		t += (frame % 500 == 499 ? STALL_MS : 1 + rng.Below(40)) / 1000.0;
+		sim.Advance(t);
+	}
+	log.Finish(sim.Ticks(), sim.Current());
+	std::vector<float> recordedAgents = AgentPositions(agents);
+	std::cout << log.numTicks << " ticks recorded (" << sim.DroppedTicks() << " dropped in stalls), " << log.changes.size()
+		<< " input changes; player ends at " << sim.Current().origin.x << ", " << sim.Current().origin.y << std::endl;
+
+	// Round trip
+	InputLog loaded;
+	bool saved = log.Save(LOG_FILE) && loaded.Load(LOG_FILE);
+	bool same = saved && loaded.numTicks == log.numTicks && loaded.changes.size() == log.changes.size()
+		&& loaded.levelHash == log.levelHash && loaded.tickSeconds == log.tickSeconds;
+	for(size_t i = 0; same && i < log.changes.size(); i++) {
+		const PlayerInput &a = log.changes[i].input, &b = loaded.changes[i].input;
+		same = log.changes[i].tick == loaded.changes[i].tick && a.forward == b.forward && a.right == b.right
+			&& a.turn == b.turn && a.look == b.look;
+	}
+	std::ifstream in(LOG_FILE, std::ios::binary | std::ios::ate);
+	long long bytes = in.tellg();
+	std::cout << "log: " << bytes << " bytes, " << (double)(bytes - sizeof(InputLogHeader)) / std::max<size_t>(1, log.changes.size())
+		<< " per change, " << bytes / (log.numTicks * log.tickSeconds / 60.0) << " per minute; save and load "
+		<< (same ? "ok" : "FAILED") << std::endl;
+	failures += !same;
+
+	// Cut short, it has to be refused
+	in.close();
+	std::vector<char> data(bytes);
+	std::ifstream(LOG_FILE, std::ios::binary).read(data.data(), bytes);
+	std::ofstream(LOG_FILE, std::ios::binary | std::ios::trunc).write(data.data(), bytes - 3);
+	InputLog truncated;
+	bool refused = log.changes.empty() || !truncated.Load(LOG_FILE);
+	failures += !refused;
+	if(!refused) {
+		std::cout << "  a truncated log loaded" << std::endl;
+	}
+	remove(LOG_FILE);
+
+	// One tick per frame, a 60 Hz frame rate, the most a live run steps per
+	// call, and the whole log in one call, which a replay must not cut short
+	const double frameTicks[] = { 1.0, SIM_TICK_RATE / 60.0, SIM_MAX_TICKS_PER_ADVANCE, (double)loaded.numTicks };
+	for(double ticks : frameTicks) {
+		std::vector<float> replayedAgents;
+		double ms = 0.0;
+		bool ends = Replay(loaded, level, numAgents, ticks, replayedAgents, ms);
+		bool agentsMatch = replayedAgents == recordedAgents;
+		std::cout << "  replay, " << ticks << " ticks per frame: " << ms << " ms, "
+			<< log.numTicks * log.tickSeconds / (ms / 1000.0) << "x real time; "
+			<< (ends && agentsMatch ? "matches" : !ends ? "PLAYER DIVERGED" : "AGENTS DIVERGED") << std::endl;
+		failures += !ends || !agentsMatch;
+	}
+
+	std::cout << (failures ? "FAILED" : "replays ok") << std::endl;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+// Batch SoA math kernels at each SIMD level against the per-element
+// Vec3f/Quaternion/Color operators
+// Before timing, Quaternion::RotateVector is checked against a double
+// precision rotation matrix, products against rotating twice, and every
+// kernel against the per-element operators, tails included; any mismatch
+// fails the run
+// Usage: BenchMath [count]
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "Math.hpp"
+#include "Profiler.hpp"
+
+#define NUM_ROTATION_CHECKS 100000
+
+static Quaternion RandomRotation(unsigned int &state) {
+	Vec3f axis(BenchRandomSigned(state), BenchRandomSigned(state), BenchRandomSigned(state));
+	if(axis.Normalize() == 0.f) {
+		axis = Vec3f(0.f, 0.f, 1.f);
+	}
+	return Quaternion(axis, BenchRandomSigned(state) * 3.14159265f);
+}
+
+// v rotated by the matrix of q, in double precision
+static void ReferenceRotate(const Quaternion &q, const Vec3f &v, double *out) {
+	double w = q.w, x = q.x, y = q.y, z = q.z;
+	double n = sqrt(w * w + x * x + y * y + z * z);
+	w /= n; x /= n; y /= n; z /= n;
+
+	double m[3][3] = {
+		{ 1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y) },
+		{ 2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x) },
+		{ 2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y) }
+	};
+	for(int i = 0; i < 3; i++) {
+		out[i] = m[i][0] * v.x + m[i][1] * v.y + m[i][2] * v.z;
+	}
+}
+
+static bool Near(double a, double b, double scale) {
+	return fabs(a - b) <= 1e-5 * (1.0 + scale);
+}
+
+static int CheckRotateVector() {
+	int failures = 0;
+
+	// Known rotations
+	struct Case {
+		Vec3f axis;
+		float angle;
+		Vec3f v;
+		Vec3f expected;
+	};
+	const float halfPi = 1.57079633f;
+	const Case cases[] = {
+		{ Vec3f(0, 0, 1), 0.f, Vec3f(1, 2, 3), Vec3f(1, 2, 3) },
+		{ Vec3f(0, 0, 1), halfPi, Vec3f(1, 0, 0), Vec3f(0, 1, 0) },
+		{ Vec3f(0, 0, 1), halfPi, Vec3f(0, 1, 0), Vec3f(-1, 0, 0) },
+		{ Vec3f(1, 0, 0), halfPi, Vec3f(0, 1, 0), Vec3f(0, 0, 1) },
+		{ Vec3f(0, 1, 0), halfPi, Vec3f(0, 0, 1), Vec3f(1, 0, 0) },
+		{ Vec3f(1, 0, 0), 2.f * halfPi, Vec3f(0, 1, 2), Vec3f(0, -1, -2) }
+	};
+	for(const Case &c : cases) {
+		Vec3f r = Quaternion(c.axis, c.angle).RotateVector(c.v);
+		if(!Near(r.x, c.expected.x, 1) || !Near(r.y, c.expected.y, 1) || !Near(r.z, c.expected.z, 1)) {
+			std::cout << "  RotateVector(" << c.v.x << ", " << c.v.y << ", " << c.v.z << ") = (" << r.x << ", " << r.y << ", "
+				<< r.z << "), expected (" << c.expected.x << ", " << c.expected.y << ", " << c.expected.z << ")" << std::endl;
+			failures++;
+		}
+	}
+
+	// Random rotations against the matrix form
+	unsigned int state = 3;
+	for(int i = 0; i < NUM_ROTATION_CHECKS; i++) {
+		Quaternion q = RandomRotation(state);
+		Vec3f v(BenchRandomSigned(state) * 100.f, BenchRandomSigned(state) * 100.f, BenchRandomSigned(state) * 100.f);
+		Vec3f r = q.RotateVector(v);
+
+		double expected[3];
+		ReferenceRotate(q, v, expected);
+		double scale = v.Length();
+		if(!Near(r.x, expected[0], scale) || !Near(r.y, expected[1], scale) || !Near(r.z, expected[2], scale)) {
+			failures++;
+		}
+
+		// A product rotates by its right factor first
+		Quaternion q2 = RandomRotation(state);
+		Vec3f composed = (q * q2).RotateVector(v), twice = q.RotateVector(q2.RotateVector(v));
+		if(!Near(composed.x, twice.x, scale) || !Near(composed.y, twice.y, scale) || !Near(composed.z, twice.z, scale)) {
+			failures++;
+		}
+	}
+	return failures;
+}
+
+// Batch kernels against the per-element operators at the active level
+static int CheckKernels() {
+	int failures = 0;
+	unsigned int state = 9;
+
+	const size_t counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 1000 };
+	for(size_t n : counts) {
+		std::vector<float> x(n), y(n), z(n), ox(n), oy(n), oz(n);
+		for(size_t i = 0; i < n; i++) {
+			x[i] = BenchRandomSigned(state) * 10.f;
+			y[i] = BenchRandomSigned(state) * 10.f;
+			z[i] = BenchRandomSigned(state) * 10.f;
+		}
+		if(n > 2) {
+			x[2] = y[2] = z[2] = 0.f;		// Zero length survives normalizing
+		}
+
+		Quaternion q = RandomRotation(state);
+		RotateVectors(q, { x.data(), y.data(), z.data() }, { ox.data(), oy.data(), oz.data() }, n);
+		for(size_t i = 0; i < n; i++) {
+			Vec3f r = q.RotateVector(Vec3f(x[i], y[i], z[i]));
+			failures += !Near(ox[i], r.x, 10) || !Near(oy[i], r.y, 10) || !Near(oz[i], r.z, 10);
+		}
+
+		// In place, on a copy
+		std::vector<float> nx = x, ny = y, nz = z;
+		NormalizeVectors({ nx.data(), ny.data(), nz.data() }, n);
+		for(size_t i = 0; i < n; i++) {
+			Vec3f v(x[i], y[i], z[i]);
+			v.Normalize();
+			failures += !Near(nx[i], v.x, 1) || !Near(ny[i], v.y, 1) || !Near(nz[i], v.z, 1);
+		}
+
+		// The rotated vectors double as the second set of colors
+		float t = (BenchRandomSigned(state) + 1.f) / 2.f;
+		std::vector<float> r(n), g(n), b(n);
+		BlendColors({ x.data(), y.data(), z.data() }, { ox.data(), oy.data(), oz.data() }, t, { r.data(), g.data(), b.data() }, n);
+		for(size_t i = 0; i < n; i++) {
+			Color from(x[i], y[i], z[i]), to(ox[i], oy[i], oz[i]);
+			Color c = from + (to - from) * t;
+			failures += !Near(r[i], c.r, 10) || !Near(g[i], c.g, 10) || !Near(b[i], c.b, 10);
+		}
+	}
+	return failures;
+}
+
+int main(int argc, char **argv) {
+	size_t n = argc > 1 ? atoi(argv[1]) : (1 << 20);
+	SimdLevel best = ActiveSimdLevel();
+
+	int rotateFailures = CheckRotateVector();
+	std::cout << "RotateVector: " << (rotateFailures ? "FAILED" : "ok") << " (" << rotateFailures << " mismatches)" << std::endl;
+
+	int kernelFailures = 0;
+	for(int level = SIMD_SCALAR; level <= best; level++) {
+		SetSimdLevel((SimdLevel)level);
+		int failures = CheckKernels();
+		std::cout << "kernels, " << SimdLevelName((SimdLevel)level) << ": " << (failures ? "FAILED" : "ok") << std::endl;
+		kernelFailures += failures;
+	}
+
+	unsigned int state = 1;
+	std::vector<Vec3f> points(n);
+	std::vector<Color> colorsA(n), colorsB(n);
+	std::vector<float> x(n), y(n), z(n), ox(n), oy(n), oz(n);
+	std::vector<float> r0(n), g0(n), b0(n), r1(n), g1(n), b1(n);
+	for(size_t i = 0; i < n; i++) {
+		points[i] = Vec3f(BenchRandomSigned(state), BenchRandomSigned(state), BenchRandomSigned(state));
+		x[i] = points[i].x;
+		y[i] = points[i].y;
+		z[i] = points[i].z;
+		colorsA[i] = Color(r0[i] = BenchRandomSigned(state), g0[i] = BenchRandomSigned(state), b0[i] = BenchRandomSigned(state));
+		colorsB[i] = Color(r1[i] = BenchRandomSigned(state), g1[i] = BenchRandomSigned(state), b1[i] = BenchRandomSigned(state));
+	}
+	Quaternion q = RandomRotation(state);
+	std::vector<Vec3f> rotated(n);
+	std::vector<Color> blended(n);
+
+	std::cout << n << " elements, ms" << std::endl;
+	std::cout << "  operators:  rotate " << TimeMs([&]() {
+		for(size_t i = 0; i < n; i++) {
+			rotated[i] = q.RotateVector(points[i]);
+		}
+	}) << ", normalize " << TimeMs([&]() {
+		for(size_t i = 0; i < n; i++) {
+			rotated[i].Normalize();
+		}
+	}) << ", blend " << TimeMs([&]() {
+		for(size_t i = 0; i < n; i++) {
+			blended[i] = colorsA[i] + (colorsB[i] - colorsA[i]) * 0.25f;
+		}
+	}) << std::endl;
+
+	for(int level = SIMD_SCALAR; level <= best; level++) {
+		SetSimdLevel((SimdLevel)level);
+		std::cout << "  " << SimdLevelName((SimdLevel)level) << " batch: rotate " << TimeMs([&]() {
+			RotateVectors(q, { x.data(), y.data(), z.data() }, { ox.data(), oy.data(), oz.data() }, n);
+		}) << ", normalize " << TimeMs([&]() {
+			NormalizeVectors({ ox.data(), oy.data(), oz.data() }, n);
+		}) << ", blend " << TimeMs([&]() {
+			BlendColors({ r0.data(), g0.data(), b0.data() }, { r1.data(), g1.data(), b1.data() }, 0.25f,
+				{ ox.data(), oy.data(), oz.data() }, n);
+		}) << std::endl;
+	}
+
+	return rotateFailures || kernelFailures ? 1 : 0;
+}
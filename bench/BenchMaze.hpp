@@ -0,0 +1,83 @@
+#ifndef BENCH_MAZE_INCLUDED
+#define BENCH_MAZE_INCLUDED
+
+// Level helpers shared by the maze benchmarks
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Collision.hpp"
+#include "MazeGen.hpp"
+#include "Pathfind.hpp"
+
+// Opens a share of the walls between two rooms, then the pillars that were
+// left standing alone
+inline void BenchBraid(TileGrid &level, int percent) {
+	MazeRng rng(99);
+	for(int y = 1; y < level.height - 1; y++) {
+		for(int x = 1; x < level.width - 1; x++) {
+			if(level.At(x, y) == LEVEL_WALL && (x + y) % 2 == 1 && (int)rng.Below(100) < percent) {
+				level.Set(x, y, LEVEL_AIR);
+			}
+		}
+	}
+	for(int y = 2; y < level.height - 2; y += 2) {
+		for(int x = 2; x < level.width - 2; x += 2) {
+			if(!level.IsWall(x - 1, y) && !level.IsWall(x + 1, y) && !level.IsWall(x, y - 1) && !level.IsWall(x, y + 1)) {
+				level.Set(x, y, LEVEL_AIR);
+			}
+		}
+	}
+}
+
+inline bool BenchWalkable(const TileGrid &level, int x, int y) {
+	return level.InBounds(x, y) && !level.IsWall(x, y);
+}
+
+// Whether path runs from (sx, sy) to (gx, gy) through open cells, one step at
+// a time without cutting corners, and costs expectedCost
+inline bool BenchCheckPath(const TileGrid &level, const std::vector<PathCell> &path, uint64_t expectedCost,
+	int sx, int sy, int gx, int gy) {
+	if(path.empty() || path.front().x != sx || path.front().y != sy || path.back().x != gx || path.back().y != gy) {
+		return false;
+	}
+	uint64_t cost = 0;
+	for(size_t i = 0; i < path.size(); i++) {
+		const PathCell &c = path[i];
+		if(!BenchWalkable(level, c.x, c.y)) {
+			return false;
+		}
+		if(i == 0) {
+			continue;
+		}
+		int dx = c.x - path[i - 1].x, dy = c.y - path[i - 1].y;
+		if(abs(dx) > 1 || abs(dy) > 1 || (dx == 0 && dy == 0)) {
+			return false;
+		}
+		if(dx && dy && (!BenchWalkable(level, c.x - dx, c.y) || !BenchWalkable(level, c.x, c.y - dy))) {
+			return false;
+		}
+		cost += dx && dy ? PATH_COST_DIAGONAL : PATH_COST_STRAIGHT;
+	}
+	return cost == expectedCost;
+}
+
+// Walls a player circle at (x, y) sinks into, past a small tolerance
+inline int BenchWallOverlaps(const TileGrid &level, float x, float y) {
+	int overlaps = 0;
+	int cellX = (int)floorf(x + 0.5f), cellY = (int)floorf(y + 0.5f);
+	for(int cy = cellY - 1; cy <= cellY + 1; cy++) {
+		for(int cx = cellX - 1; cx <= cellX + 1; cx++) {
+			if(!level.IsWall(cx, cy)) {
+				continue;
+			}
+			float ox = x - std::max(cx - 0.5f, std::min(x, cx + 0.5f));
+			float oy = y - std::max(cy - 0.5f, std::min(y, cy + 0.5f));
+			overlaps += ox * ox + oy * oy < (PLAYER_RADIUS - 1e-4f) * (PLAYER_RADIUS - 1e-4f);
+		}
+	}
+	return overlaps;
+}
+
+#endif
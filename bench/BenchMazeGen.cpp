@@ -0,0 +1,132 @@
+// Maze generation throughput per algorithm and thread count
+// Every maze is checked to be perfect (connected, no loops) and to come out
+// the same whatever the thread count
+// Usage: BenchMazeGen [rooms]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "MazeGen.hpp"
+#include "SceneFile.hpp"
+
+static uint64_t HashLevel(const TileGrid &level) {
+	uint64_t hash = 1469598103934665603ull;
+	for(int y = 0; y < level.height; y++) {
+		for(int x = 0; x < level.width; x++) {
+			hash = (hash ^ level.At(x, y)) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+// A perfect maze over n rooms has exactly n - 1 passages and reaches every room
+static bool IsPerfect(const TileGrid &level) {
+	int roomsX = level.width / 2, roomsY = level.height / 2;
+	long long open = 0;
+	for(int y = 0; y < level.height; y++) {
+		open += level.width - level.CountWallsInRow(y, 0, level.width);
+	}
+	long long numRooms = (long long)roomsX * roomsY;
+	if(open - numRooms != numRooms - 1) {
+		return false;
+	}
+
+	std::vector<uint8_t> seen((size_t)level.width * level.height, 0);
+	std::vector<int> queue;
+	queue.push_back(level.width + 1);
+	seen[level.width + 1] = 1;
+	long long reached = 0;
+	while(!queue.empty()) {
+		int cell = queue.back();
+		queue.pop_back();
+		int x = cell % level.width, y = cell / level.width;
+		reached += (x & 1) && (y & 1);
+
+		const int dx[4] = { 1, -1, 0, 0 }, dy[4] = { 0, 0, 1, -1 };
+		for(int d = 0; d < 4; d++) {
+			int nx = x + dx[d], ny = y + dy[d];
+			int next = ny * level.width + nx;
+			if(level.InBounds(nx, ny) && !level.IsWall(nx, ny) && !seen[next]) {
+				seen[next] = 1;
+				queue.push_back(next);
+			}
+		}
+	}
+	return reached == numRooms;
+}
+
+int main(int argc, char **argv) {
+	int rooms = argc > 1 ? atoi(argv[1]) : 1024;
+	int cores = std::max(1u, std::thread::hardware_concurrency());
+
+	std::vector<int> threadCounts = { 1, 2, 4 };
+	for(int n = 8; n <= cores; n *= 2) {
+		threadCounts.push_back(n);
+	}
+
+	std::cout << rooms << "x" << rooms << " rooms, " << MAZE_BAND_ROOMS << "-row bands, "
+		<< cores << " cores" << std::endl;
+
+	bool ok = true;
+	for(int a = 0; a < NUM_MAZE_ALGORITHMS; a++) {
+		MazeGenConfig config;
+		config.algorithm = (MazeAlgorithm)a;
+		config.roomsX = config.roomsY = rooms;
+		config.seed = 1234;
+
+		std::cout << MazeAlgorithmName(config.algorithm) << std::endl;
+		uint64_t firstHash = 0;
+		for(int threads : threadCounts) {
+			config.threads = threads;
+
+			TileGrid level;
+			auto start = std::chrono::steady_clock::now();
+			GenerateMaze(config, level);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			uint64_t hash = HashLevel(level);
+			firstHash = firstHash ? firstHash : hash;
+			bool perfect = IsPerfect(level);
+			ok = ok && perfect && hash == firstHash;
+
+			std::cout << "  " << threads << " threads: " << seconds * 1000.0 << " ms, "
+				<< (double)level.width * level.height / seconds / 1e6 << " Mcells/s"
+				<< (perfect ? "" : ", NOT PERFECT") << (hash == firstHash ? "" : ", DIFFERS") << std::endl;
+		}
+	}
+
+	// Streaming straight to disk, read back to check it matches the in-memory maze
+	const char *fileName = "/tmp/maze_bench_eller.txt";
+	MazeGenConfig config;
+	config.algorithm = MAZE_ELLER;
+	config.roomsX = config.roomsY = rooms;
+	config.seed = 1234;
+	config.bandRooms = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	WriteEllerSceneFile(fileName, rooms, rooms, config.seed);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	TileGrid streamed, generated;
+	GenerateMaze(config, generated);
+	SceneFileReader reader;
+	bool same = reader.Open(fileName) && reader.width == generated.width && reader.height == generated.height;
+	std::vector<char> row(generated.width);
+	for(int y = 0; same && y < generated.height; y++) {
+		same = reader.ReadRow(row.data());
+		for(int x = 0; same && x < generated.width; x++) {
+			same = TileFromChar(row[x]) == generated.At(x, y);
+		}
+	}
+	ok = ok && same;
+	remove(fileName);
+
+	std::cout << "eller streamed to scenefile: " << seconds * 1000.0 << " ms, "
+		<< (double)generated.width * generated.height / seconds / 1e6 << " Mcells/s"
+		<< (same ? "" : ", DIFFERS from GenerateMaze") << std::endl;
+
+	return ok ? 0 : 1;
+}
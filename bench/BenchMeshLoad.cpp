@@ -0,0 +1,99 @@
+// Startup benchmark: text vs. binary model loading
+// Headers whose ranges wrap around past the end of the file have to be
+// refused; any that loads fails the run
+// Run from the repository root after `make meshes`
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "Mesh.hpp"
+
+#define REPETITIONS 20
+#define CORRUPT_FILE "/tmp/BenchMeshLoad.mesh"
+
+// Reads every float so lazily mapped pages are counted too,
+// as they would be by the GPU upload
+static float Touch(const Mesh &mesh) {
+	float sum = 0.f;
+	for(int i = 0; i < mesh.numVerts * MESH_VERTEX_FLOATS; i++) {
+		sum += mesh.vertices[i];
+	}
+	return sum;
+}
+
+template <typename LoadFn>
+static double TimeLoad(LoadFn load, float &checksum) {
+	double best = 1e30;
+	for(int i = 0; i < REPETITIONS; i++) {
+		auto start = std::chrono::steady_clock::now();
+		Mesh mesh;
+		if(!load(mesh)) {
+			return -1.0;
+		}
+		checksum = Touch(mesh);
+		mesh.Release();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if(ms < best) {
+			best = ms;
+		}
+	}
+	return best;
+}
+
+// Loads fileName with its header changed by corrupt, true if it was refused
+template <typename CorruptFn>
+static bool Refused(const std::string &fileName, CorruptFn corrupt) {
+	std::ifstream in(fileName, std::ios::binary);
+	std::stringstream contents;
+	contents << in.rdbuf();
+	std::string data = contents.str();
+	if(data.size() < sizeof(MeshHeader)) {
+		return false;
+	}
+
+	MeshHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	corrupt(header);
+	memcpy(&data[0], &header, sizeof(header));
+	std::ofstream(CORRUPT_FILE, std::ios::binary | std::ios::trunc) << data;
+
+	Mesh mesh;
+	bool loaded = mesh.LoadBinary(CORRUPT_FILE);
+	mesh.Release();
+	return !loaded;
+}
+
+int main() {
+	static const char *modelNames[] = { "models/cube", "models/knot" };
+
+	for(const char *modelName : modelNames) {
+		std::string txt = std::string(modelName) + ".txt";
+		std::string bin = std::string(modelName) + ".mesh";
+
+		float textSum = 0.f, binSum = 0.f;
+		double textMs = TimeLoad([&](Mesh &m) { return m.LoadText(txt.c_str()); }, textSum);
+		double binMs = TimeLoad([&](Mesh &m) { return m.LoadBinary(bin.c_str()); }, binSum);
+
+		if(textMs < 0.0 || binMs < 0.0) {
+			std::cerr << "missing " << txt << " or " << bin << " (run `make meshes`)" << std::endl;
+			return 1;
+		}
+		if(textSum != binSum) {
+			std::cerr << modelName << ": text and binary payloads differ" << std::endl;
+			return 1;
+		}
+
+		std::cout << modelName << ": text " << textMs << " ms, binary " << binMs << " ms ("
+			<< textMs / binMs << "x), best of " << REPETITIONS << std::endl;
+	}
+
+	// Offsets just short of 2^64, so offset + size wraps to a small number
+	bool refused = Refused("models/knot.mesh", [](MeshHeader &h) { h.dataOffset = 0 - (uint64_t)MESH_DATA_ALIGN; })
+		&& Refused("models/knot.mesh", [](MeshHeader &h) { h.indexOffset = 0 - (uint64_t)h.indexSize; });
+	std::cout << "wrapping header ranges: " << (refused ? "ok" : "FAILED") << std::endl;
+
+	return refused ? 0 : 1;
+}
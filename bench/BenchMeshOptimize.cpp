@@ -0,0 +1,162 @@
+// Vertex welding and cache ordering of the models, plus a shuffled grid
+// whose triangle order starts out hostile to the cache
+// Reports the unique vertex ratio and the ACMR (vertices transformed per
+// triangle with a FIFO cache) before and after at a few cache sizes
+// Every indexed mesh is checked to draw the same triangles, with the same
+// winding, as the soup it came from
+// Run from the repository root
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "Mesh.hpp"
+#include "MeshOptimize.hpp"
+
+#define GRID_SIZE 128
+
+typedef std::array<float, MESH_VERTEX_FLOATS * 3> Triangle;
+
+// Rotated to start at its smallest vertex so the winding is kept but the
+// starting corner doesn't matter
+static Triangle Canonical(const float *a, const float *b, const float *c) {
+	const float *corners[3] = { a, b, c };
+	int first = 0;
+	for(int i = 1; i < 3; i++) {
+		if(std::lexicographical_compare(corners[i], corners[i] + MESH_VERTEX_FLOATS, corners[first], corners[first] + MESH_VERTEX_FLOATS)) {
+			first = i;
+		}
+	}
+
+	Triangle t;
+	for(int i = 0; i < 3; i++) {
+		const float *corner = corners[(first + i) % 3];
+		for(int k = 0; k < MESH_VERTEX_FLOATS; k++) {
+			t[i * MESH_VERTEX_FLOATS + k] = corner[k] == 0.f ? 0.f : corner[k];
+		}
+	}
+	return t;
+}
+
+static bool SameTriangles(const std::vector<float> &soup, const std::vector<float> &vertices, const std::vector<uint32_t> &indices) {
+	if(indices.size() * MESH_VERTEX_FLOATS != soup.size()) {
+		return false;
+	}
+
+	std::vector<Triangle> expected, actual;
+	for(size_t i = 0; i < soup.size(); i += MESH_VERTEX_FLOATS * 3) {
+		expected.push_back(Canonical(&soup[i], &soup[i + MESH_VERTEX_FLOATS], &soup[i + MESH_VERTEX_FLOATS * 2]));
+	}
+	for(size_t i = 0; i < indices.size(); i += 3) {
+		for(int k = 0; k < 3; k++) {
+			if((size_t)indices[i + k] * MESH_VERTEX_FLOATS >= vertices.size()) {
+				return false;
+			}
+		}
+		actual.push_back(Canonical(&vertices[(size_t)indices[i] * MESH_VERTEX_FLOATS],
+			&vertices[(size_t)indices[i + 1] * MESH_VERTEX_FLOATS], &vertices[(size_t)indices[i + 2] * MESH_VERTEX_FLOATS]));
+	}
+	std::sort(expected.begin(), expected.end());
+	std::sort(actual.begin(), actual.end());
+	return expected == actual;
+}
+
+// A size x size grid of quads as a soup, triangles in a scrambled order
+static void ShuffledGrid(int size, std::vector<float> &soup) {
+	std::vector<Triangle> triangles;
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			// Texcoords run across the whole grid so neighbouring quads share corners
+			float u0 = (float)x / size, v0 = (float)y / size, u1 = (float)(x + 1) / size, v1 = (float)(y + 1) / size;
+			float corners[4][MESH_VERTEX_FLOATS] = {
+				{ (float)x, (float)y, 0, u0, v0, 0, 0, 1 }, { (float)x + 1, (float)y, 0, u1, v0, 0, 0, 1 },
+				{ (float)x + 1, (float)y + 1, 0, u1, v1, 0, 0, 1 }, { (float)x, (float)y + 1, 0, u0, v1, 0, 0, 1 }
+			};
+			Triangle a, b;
+			const int quad[6] = { 0, 1, 2, 0, 2, 3 };
+			for(int i = 0; i < 3; i++) {
+				memcpy(&a[i * MESH_VERTEX_FLOATS], corners[quad[i]], sizeof(corners[0]));
+				memcpy(&b[i * MESH_VERTEX_FLOATS], corners[quad[i + 3]], sizeof(corners[0]));
+			}
+			triangles.push_back(a);
+			triangles.push_back(b);
+		}
+	}
+
+	unsigned int state = 17;
+	for(size_t i = triangles.size() - 1; i > 0; i--) {
+		state = state * 1664525u + 1013904223u;
+		std::swap(triangles[i], triangles[(state >> 8) % (i + 1)]);
+	}
+
+	soup.clear();
+	for(const Triangle &t : triangles) {
+		soup.insert(soup.end(), t.begin(), t.end());
+	}
+}
+
+static bool Report(const char *name, const std::vector<float> &soup) {
+	int soupVerts = soup.size() / MESH_VERTEX_FLOATS;
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+	WeldVertices(soup.data(), soupVerts, vertices, indices);
+	double weldMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	int numVerts = vertices.size() / MESH_VERTEX_FLOATS;
+	std::vector<uint32_t> welded = indices;
+
+	start = std::chrono::steady_clock::now();
+	OptimizeVertexCache(indices.data(), indices.size(), numVerts);
+	OptimizeVertexFetch(vertices, indices.data(), indices.size());
+	double orderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	bool ok = SameTriangles(soup, vertices, indices) && (int)vertices.size() / MESH_VERTEX_FLOATS == numVerts;
+
+	std::cout << name << ": " << soupVerts << " -> " << numVerts << " verts (" << 100.0 * numVerts / soupVerts
+		<< "% unique), weld " << weldMs << " ms, reorder " << orderMs << " ms, " << (ok ? "ok" : "FAILED") << std::endl;
+	for(int cacheSize : { 8, 16, 32 }) {
+		std::cout << "  ACMR, cache " << cacheSize << ": soup 3, welded "
+			<< VertexCacheMissRatio(welded.data(), welded.size(), numVerts, cacheSize) << ", reordered "
+			<< VertexCacheMissRatio(indices.data(), indices.size(), numVerts, cacheSize) << std::endl;
+	}
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+
+	const char *models[] = { "models/cube.txt", "models/knot.txt" };
+	for(const char *model : models) {
+		std::vector<float> soup;
+		if(!ReadTextModel(model, soup)) {
+			std::cerr << "cannot read " << model << ", run from the repository root" << std::endl;
+			return 1;
+		}
+		ok &= Report(model, soup);
+	}
+
+	std::vector<float> grid;
+	ShuffledGrid(GRID_SIZE, grid);
+	ok &= Report("shuffled 128x128 grid", grid);
+
+	// The binary mesh carries the same triangles as the text model
+	std::vector<float> soup;
+	Mesh mesh;
+	if(!ReadTextModel("models/knot.txt", soup) || !mesh.LoadBinary("models/knot.mesh")) {
+		std::cerr << "models/knot.mesh is missing, run `make meshes`" << std::endl;
+		return 1;
+	}
+	std::vector<float> vertices(mesh.vertices, mesh.vertices + (size_t)mesh.numVerts * MESH_VERTEX_FLOATS);
+	std::vector<uint32_t> indices(mesh.numIndices);
+	for(int i = 0; i < mesh.numIndices; i++) {
+		indices[i] = mesh.Index(i);
+	}
+	bool binaryOk = SameTriangles(soup, vertices, indices);
+	std::cout << "knot.mesh: " << mesh.numVerts << " verts, " << mesh.numIndices << " " << mesh.indexSize * 8
+		<< "-bit indices, " << (binaryOk ? "ok" : "FAILED") << std::endl;
+
+	return ok && binaryOk ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+// Wall occlusion: visible-set size and pass cost of GridVisibility on dense
+// generated mazes, from random eye positions in the corridors
+// An exact segment test from sample points checks that no reachable cell is ever left out
+// Usage: BenchOcclusion [size...]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "GridVisibility.hpp"
+#include "MazeGen.hpp"
+
+#define NUM_EYES 256
+#define NUM_CHECKED_EYES 8
+#define CHECK_RADIUS 12
+
+struct Eye {
+	float x;
+	float y;
+};
+
+// True if segment a-b passes through the inside of the square of cell (cx, cy)
+static bool SegmentHitsCell(float ax, float ay, float bx, float by, int cx, int cy) {
+	float origin[2] = { ax, ay }, dir[2] = { bx - ax, by - ay };
+	float lo[2] = { cx - 0.5f, cy - 0.5f }, hi[2] = { cx + 0.5f, cy + 0.5f };
+
+	float t0 = 0.f, t1 = 1.f;
+	for(int k = 0; k < 2; k++) {
+		if(fabsf(dir[k]) < 1e-9f) {
+			if(origin[k] <= lo[k] || origin[k] >= hi[k]) {
+				return false;
+			}
+			continue;
+		}
+		float ta = (lo[k] - origin[k]) / dir[k], tb = (hi[k] - origin[k]) / dir[k];
+		t0 = std::max(t0, std::min(ta, tb));
+		t1 = std::min(t1, std::max(ta, tb));
+	}
+	return t1 - t0 > 1e-6f;
+}
+
+// True if a ray from the eye reaches one of 5x5 points in cell (x, y)
+// without crossing a wall first
+static bool Reachable(const TileGrid &level, const Eye &eye, int x, int y) {
+	for(int sy = 0; sy < 5; sy++) {
+		for(int sx = 0; sx < 5; sx++) {
+			float tx = x - 0.45f + 0.225f * sx;
+			float ty = y - 0.45f + 0.225f * sy;
+			int x0 = (int)floorf(std::min(eye.x, tx) + 0.5f), x1 = (int)floorf(std::max(eye.x, tx) + 0.5f);
+			int y0 = (int)floorf(std::min(eye.y, ty) + 0.5f), y1 = (int)floorf(std::max(eye.y, ty) + 0.5f);
+
+			bool clear = true;
+			for(int cy = y0; cy <= y1 && clear; cy++) {
+				for(int cx = x0; cx <= x1 && clear; cx++) {
+					if((cx != x || cy != y) && level.IsWall(cx, cy) && SegmentHitsCell(eye.x, eye.y, tx, ty, cx, cy)) {
+						clear = false;
+					}
+				}
+			}
+			if(clear) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+int main(int argc, char **argv) {
+	std::vector<int> sizes;
+	for(int i = 1; i < argc; i++) {
+		sizes.push_back(atoi(argv[i]));
+	}
+	if(sizes.empty()) {
+		sizes = { 512, 4096 };
+	}
+
+	bool ok = true;
+	for(int size : sizes) {
+		MazeGenConfig config;
+		config.roomsX = config.roomsY = size / 2;
+		config.seed = 99;
+		TileGrid level;
+		GenerateMaze(config, level);
+
+		// Eyes anywhere in the corridors, off the cell centres
+		MazeRng rng(7);
+		std::vector<Eye> eyes;
+		while(eyes.size() < NUM_EYES) {
+			int x = rng.Below(level.width), y = rng.Below(level.height);
+			if(!level.IsWall(x, y)) {
+				eyes.push_back({ x + (rng.Below(1000) / 1000.f - 0.5f), y + (rng.Below(1000) / 1000.f - 0.5f) });
+			}
+		}
+
+		std::cout << level.width << "x" << level.height << " maze, " << NUM_EYES << " eyes" << std::endl;
+		for(int radius : { 11, 32, 128 }) {
+			GridVisibility visibility;
+			long long visible = 0, visited = 0, window = 0;
+
+			auto start = std::chrono::steady_clock::now();
+			for(const Eye &eye : eyes) {
+				visibility.Compute(level, eye.x, eye.y, radius);
+				visible += visibility.numVisible;
+				visited += visibility.cellsVisited;
+			}
+			double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / NUM_EYES;
+
+			// Cells a frustum-only cull could keep around the eye
+			for(const Eye &eye : eyes) {
+				int ex = (int)floorf(eye.x + 0.5f), ey = (int)floorf(eye.y + 0.5f);
+				int w = std::min(ex + radius, level.width - 1) - std::max(ex - radius, 0) + 1;
+				int h = std::min(ey + radius, level.height - 1) - std::max(ey - radius, 0) + 1;
+				window += (long long)w * h;
+			}
+
+			std::cout << "  radius " << radius << ": " << visible / NUM_EYES << " visible of "
+				<< window / NUM_EYES << " cells in range (" << 100.0 * visible / window << "%), "
+				<< visited / NUM_EYES << " cells visited, " << us << " us per pass" << std::endl;
+		}
+
+		GridVisibility visibility;
+		int missed = 0;
+		for(int i = 0; i < NUM_CHECKED_EYES; i++) {
+			const Eye &eye = eyes[i];
+			visibility.Compute(level, eye.x, eye.y, CHECK_RADIUS);
+			int ex = (int)floorf(eye.x + 0.5f), ey = (int)floorf(eye.y + 0.5f);
+			for(int y = ey - CHECK_RADIUS; y <= ey + CHECK_RADIUS; y++) {
+				for(int x = ex - CHECK_RADIUS; x <= ex + CHECK_RADIUS; x++) {
+					if(level.InBounds(x, y) && !visibility.IsVisible(x, y) && Reachable(level, eye, x, y)) {
+						missed++;
+					}
+				}
+			}
+		}
+		ok = ok && missed == 0;
+		std::cout << "  conservative check: " << missed << " reachable cells missed" << std::endl;
+
+		// Whole rows, as drawn with frustum culling off, keep the stats consistent
+		std::vector<CellSpan> rows, visibleSpans;
+		CullStats stats;
+		for(int y = 0; y < level.height; y++) {
+			rows.push_back({ y, 0, level.width });
+		}
+		stats.cellsVisible = level.width * level.height;
+		visibility.FilterSpans(rows, visibleSpans, stats);
+		int kept = 0;
+		for(const CellSpan &span : visibleSpans) {
+			kept += span.x1 - span.x0;
+		}
+		bool statsOk = stats.cellsVisible == kept && stats.cellsVisible + stats.cellsOccluded == level.width * level.height;
+		ok = ok && statsOk;
+		std::cout << "  filtered rows: " << stats.cellsVisible << " drawn, " << stats.cellsOccluded << " occluded, "
+			<< (statsOk ? "ok" : "FAILED") << std::endl;
+	}
+
+	return ok ? 0 : 1;
+}
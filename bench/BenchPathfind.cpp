@@ -0,0 +1,95 @@
+// A* against jump point search on generated mazes: spawn to goal, then
+// random pairs of rooms
+// The perfect maze has one-cell corridors only, the braided one has some of
+// its walls knocked out, leaving loops and open areas
+// Every path is checked to be walkable, without cut corners, to cost what
+// the search says, and to cost the same for both algorithms; any mismatch
+// fails the run
+// Usage: BenchPathfind [rooms] [queries]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "BenchMaze.hpp"
+#include "MazeGen.hpp"
+#include "Pathfind.hpp"
+#include "Profiler.hpp"
+
+#define BRAID_PERCENT 30
+
+static int RunLevel(const char *name, const TileGrid &level, int rooms, int numQueries) {
+	int failures = 0;
+
+	// Spawn to goal first, then random rooms
+	std::vector<int> queries;
+	int gx, gy;
+	FindTile(level, LEVEL_GOAL, gx, gy);
+	queries.insert(queries.end(), { 1, 1, gx, gy });
+	MazeRng rng(5);
+	for(int i = 1; i < numQueries; i++) {
+		queries.insert(queries.end(), { 2 * (int)rng.Below(rooms) + 1, 2 * (int)rng.Below(rooms) + 1,
+			2 * (int)rng.Below(rooms) + 1, 2 * (int)rng.Below(rooms) + 1 });
+	}
+
+	std::cout << name << ", " << numQueries << " queries" << std::endl;
+	Pathfinder finders[2];
+	std::vector<uint64_t> costs[2];
+	for(int algorithm = PATH_ASTAR; algorithm <= PATH_JPS; algorithm++) {
+		Pathfinder &finder = finders[algorithm];
+		finder.Init(&level);
+		std::vector<PathCell> path;
+
+		// The first query alone, it spans the whole maze
+		double firstMs = 0.0;
+		long long firstExpanded = 0;
+		int bad = 0;
+		double ms = TimeMs([&]() {
+			for(size_t q = 0; q < queries.size(); q += 4) {
+				auto start = std::chrono::steady_clock::now();
+				bool found = finder.Find((PathAlgorithm)algorithm, queries[q], queries[q + 1], queries[q + 2], queries[q + 3], path);
+				if(q == 0) {
+					firstMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+					firstExpanded = finder.stats.expanded;
+				}
+				costs[algorithm].push_back(found ? finder.Cost() : 0);
+				bad += !found || !BenchCheckPath(level, path, finder.Cost(), queries[q], queries[q + 1], queries[q + 2], queries[q + 3]);
+			}
+		});
+		failures += bad;
+
+		const PathStats &stats = finder.stats;
+		std::cout << "  " << (algorithm == PATH_JPS ? "jps" : "a* ") << ": " << stats.queries / (ms / 1000.0) << " queries/s, "
+			<< (double)stats.expanded / stats.queries << " expanded and " << (double)stats.pushed / stats.queries
+			<< " pushed per query; spawn to goal " << firstMs << " ms, " << firstExpanded << " expanded"
+			<< (bad ? ", BAD PATHS" : "") << std::endl;
+	}
+
+	int mismatches = 0;
+	for(size_t i = 0; i < costs[0].size(); i++) {
+		mismatches += costs[0][i] != costs[1][i];
+	}
+	if(mismatches) {
+		std::cout << "  " << mismatches << " paths cost differently" << std::endl;
+	}
+	return failures + mismatches;
+}
+
+int main(int argc, char **argv) {
+	int rooms = argc > 1 ? atoi(argv[1]) : 1024;
+	int numQueries = argc > 2 ? atoi(argv[2]) : 50;
+
+	MazeGenConfig config;
+	config.roomsX = config.roomsY = rooms;
+	TileGrid level;
+	GenerateMaze(config, level);
+	std::cout << level.width << "x" << level.height << " (" << (long long)level.width * level.height / 1000000.0
+		<< " M cells)" << std::endl;
+
+	int failures = RunLevel("perfect maze", level, rooms, numQueries);
+	BenchBraid(level, BRAID_PERCENT);
+	failures += RunLevel("braided maze", level, rooms, numQueries);
+
+	std::cout << (failures ? "FAILED" : "paths ok") << std::endl;
+	return failures ? 1 : 0;
+}
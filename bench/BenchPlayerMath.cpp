@@ -0,0 +1,69 @@
+// Per-frame cost of player/physics style vector math: every body turns its
+// wish direction by a yaw quaternion, accelerates, applies friction and
+// integrates, all through the Vec3f/Quaternion operators
+// Usage: BenchPlayerMath [bodies] [frames]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Math.hpp"
+#include "Scene.hpp"
+
+#define ACCELERATION 10.f
+#define FRICTION 4.f
+#define DELTA_TIME (1.f / 60.f)
+
+// The math types work in compile-time tables
+static constexpr Vec3f compass[4] = {
+	Vec3f(1.f, 0.f, 0.f), Vec3f(0.f, 1.f, 0.f), Vec3f(-1.f, 0.f, 0.f), Vec3f(0.f, -1.f, 0.f)
+};
+static_assert(compass[0].Cross(compass[1]).z == 1.f, "x cross y is up");
+static_assert(Quaternion().RotateVector(compass[2]).x == -1.f, "identity rotation");
+static_assert((compass[1] * 2.f + compass[3]).y == 1.f, "constexpr operators");
+
+static void StepPlayer(Player &player, float dt) {
+	Quaternion yaw(Vec3f(0.f, 0.f, 1.f), player.yaw);
+	Vec3f wish = yaw.RotateVector(player.wishDir);
+	wish.Normalize();
+
+	player.vel = player.vel + wish * (ACCELERATION * dt);
+	player.vel = player.vel - player.vel * (FRICTION * dt);
+	player.origin = player.origin + player.vel * dt;
+
+	// Keep the view facing along the motion
+	Vec3f forward = yaw.RotateVector(Vec3f(1.f, 0.f, 0.f));
+	player.pitch += forward.Cross(player.vel).z * dt;
+	player.yaw += 0.01f;
+}
+
+int main(int argc, char **argv) {
+	int numBodies = argc > 1 ? atoi(argv[1]) : 10000;
+	int frames = argc > 2 ? atoi(argv[2]) : 600;
+
+	std::vector<Player> players(numBodies);
+	for(int i = 0; i < numBodies; i++) {
+		players[i].origin = Vec3f((float)(i % 100), (float)(i / 100), 0.f);
+		players[i].vel = Vec3f(0.f, 0.f, 0.f);
+		players[i].wishDir = compass[i % 4] + Vec3f(0.f, 0.f, (float)(i % 7) - 3.f) * 0.1f;
+		players[i].yaw = 0.001f * i;
+		players[i].pitch = 0.f;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for(int frame = 0; frame < frames; frame++) {
+		for(Player &player : players) {
+			StepPlayer(player, DELTA_TIME);
+		}
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	double check = 0.0;
+	for(const Player &player : players) {
+		check += player.origin.x + player.origin.y + player.pitch;
+	}
+
+	std::cout << numBodies << " bodies, " << frames << " frames: " << ms / frames << " ms per frame, "
+		<< 1e6 * ms / ((double)frames * numBodies) << " ns per body (checksum " << check << ")" << std::endl;
+	return 0;
+}
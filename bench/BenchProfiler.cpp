@@ -0,0 +1,165 @@
+// Cost of a profiled zone, on and off, and of draining the rings
+// Threads record nested zones while the main thread collects them frame by
+// frame; every zone has to come out once, collected or counted as dropped,
+// and zones on a track have to nest, or the run fails
+// Usage: BenchProfiler [zonesPerThread] [threads]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Profiler.hpp"
+
+#define TRACE_FILE "/tmp/BenchProfiler.json"
+
+static double NsPerZone(int zones) {
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < zones; i++) {
+		PROFILE_ZONE("Overhead");
+	}
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / zones;
+}
+
+// Three levels deep, outer zones are recorded after the ones they hold
+static void RecordZones(int zones) {
+	for(int i = 0; i < zones; i += 3) {
+		PROFILE_ZONE("Outer");
+		{
+			PROFILE_ZONE("Middle");
+			PROFILE_ZONE("Inner");
+		}
+	}
+}
+
+// Reads back the complete events of the trace, by track
+static bool ReadTrace(std::vector<std::vector<std::pair<double, double>>> &tracks, long long &events) {
+	std::ifstream in(TRACE_FILE);
+	std::string line;
+	if(!std::getline(in, line) || line.find("traceEvents") == std::string::npos) {
+		return false;
+	}
+	events = 0;
+	while(std::getline(in, line)) {
+		if(line.find("\"ph\":\"X\"") == std::string::npos) {
+			continue;
+		}
+		int tid = 0;
+		double ts = 0.0, dur = 0.0;
+		size_t at = line.find("\"tid\":");
+		if(at == std::string::npos || sscanf(line.c_str() + at, "\"tid\":%d,\"ts\":%lf,\"dur\":%lf", &tid, &ts, &dur) != 3) {
+			return false;
+		}
+		if(tid >= (int)tracks.size()) {
+			tracks.resize(tid + 1);
+		}
+		tracks[tid].push_back({ ts, ts + dur });
+		events++;
+	}
+	return true;
+}
+
+// Sorted by start, longest first, each zone has to end inside the one
+// still open around it or start after it ends
+static int CheckNesting(std::vector<std::pair<double, double>> &zones) {
+	std::sort(zones.begin(), zones.end(), [](const std::pair<double, double> &a, const std::pair<double, double> &b) {
+		return a.first != b.first ? a.first < b.first : a.second > b.second;
+	});
+	int failures = 0;
+	std::vector<double> open;
+	for(const std::pair<double, double> &zone : zones) {
+		while(!open.empty() && open.back() <= zone.first) {
+			open.pop_back();
+		}
+		failures += zone.second < zone.first || (!open.empty() && zone.second > open.back());
+		open.push_back(zone.second);
+	}
+	return failures;
+}
+
+int main(int argc, char **argv) {
+	int zonesPerThread = argc > 1 ? atoi(argv[1]) : 300000;
+	int numThreads = argc > 2 ? atoi(argv[2]) : 4;
+	int failures = 0;
+
+	double offNs = NsPerZone(1000000);
+	ProfilerEnable(true);
+
+	// Once to fault the ring in
+	NsPerZone(PROFILER_RING_EVENTS / 2);
+	ProfilerClearTrace();
+	double onNs = NsPerZone(PROFILER_RING_EVENTS / 2);
+	ProfilerBeginFrame();
+	auto start = std::chrono::steady_clock::now();
+	ProfilerEndFrame();
+	double drainNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()
+		/ (PROFILER_RING_EVENTS / 2);
+	// That frame only starts the summary off
+	std::cout << "zone: " << offNs << " ns off, " << onNs << " ns on, " << drainNs << " ns to collect" << std::endl;
+	ProfilerClearTrace();
+
+	// Workers record while the main thread runs frames that collect
+	std::atomic<int> finished{0};
+	std::vector<std::thread> threads;
+	for(int t = 0; t < numThreads; t++) {
+		threads.emplace_back([t, zonesPerThread, &finished]() {
+			ProfilerSetThreadName(("Worker " + std::to_string(t)).c_str());
+			RecordZones(zonesPerThread);
+			finished++;
+		});
+	}
+	int frames = 0;
+	bool running = true;
+	while(running) {
+		running = finished < numThreads;
+		ProfilerBeginFrame();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		ProfilerEndFrame();
+		frames++;
+	}
+	for(std::thread &thread : threads) {
+		thread.join();
+	}
+	ProfilerEnable(false);
+
+	long long recorded = (long long)numThreads * ((zonesPerThread + 2) / 3 * 3) + frames;
+	ProfilerCounts counts = ProfilerGetCounts();
+	bool accounted = counts.zones + counts.dropped == recorded;
+	std::cout << numThreads << " threads, " << frames << " frames: " << counts.zones << " zones collected, " << counts.dropped
+		<< " dropped, " << counts.untraced << " past the trace limit; "
+		<< (accounted ? "all accounted for" : "ZONES LOST") << std::endl;
+	failures += !accounted;
+
+	start = std::chrono::steady_clock::now();
+	bool written = ProfilerWriteTrace(TRACE_FILE);
+	double writeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<std::vector<std::pair<double, double>>> tracks;
+	long long events = 0;
+	bool read = written && ReadTrace(tracks, events);
+	int badNesting = 0;
+	for(std::vector<std::pair<double, double>> &track : tracks) {
+		badNesting += CheckNesting(track);
+	}
+	bool traceOk = read && events == counts.zones - counts.untraced && badNesting == 0;
+	std::cout << "trace: " << events << " events written in " << writeMs << " ms, " << badNesting << " badly nested; "
+		<< (traceOk ? "ok" : "FAILED") << std::endl;
+	failures += !traceOk;
+	remove(TRACE_FILE);
+
+	FrameTimeSummary summary = ProfilerFrameSummary();
+	bool summaryOk = summary.frames == std::min(frames, PROFILER_SUMMARY_FRAMES) && summary.minMs <= summary.avgMs
+		&& summary.avgMs <= summary.maxMs && summary.minMs <= summary.p99Ms && summary.p99Ms <= summary.maxMs
+		&& summary.minMs >= 1.0;
+	std::cout << "frames: " << summary.minMs << " min / " << summary.avgMs << " avg / " << summary.p99Ms << " p99 / "
+		<< summary.maxMs << " max ms; " << (summaryOk ? "ok" : "FAILED") << std::endl;
+	failures += !summaryOk;
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+// PVS build time per thread count, compressed size against plain bitsets,
+// and runtime lookup cost against computing visibility every frame
+// Also counts cells that a live GridVisibility pass sees from random eyes
+// but the region's precomputed set leaves out, and checks damaged files are refused
+// Usage: BenchPvs [size] [radius]
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "MazeGen.hpp"
+#include "Pvs.hpp"
+
+#define NUM_EYES 4096
+
+int main(int argc, char **argv) {
+	int size = argc > 1 ? atoi(argv[1]) : 256;
+	int radius = argc > 2 ? atoi(argv[2]) : VISIBILITY_RADIUS;
+	int cores = std::max(1u, std::thread::hardware_concurrency());
+
+	MazeGenConfig config;
+	config.roomsX = config.roomsY = size / 2;
+	config.seed = 5;
+	TileGrid level;
+	GenerateMaze(config, level);
+
+	std::cout << level.width << "x" << level.height << " maze, radius " << radius << ", "
+		<< PVS_REGION_SIZE << "x" << PVS_REGION_SIZE << " regions, " << cores << " cores" << std::endl;
+
+	Pvs pvs;
+	for(int threads = 1; threads <= std::max(cores, 2); threads *= 2) {
+		auto start = std::chrono::steady_clock::now();
+		pvs.Build(level, PVS_REGION_SIZE, radius, threads);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "build, " << threads << " threads: " << seconds << " s" << std::endl;
+	}
+
+	std::cout << "memory: " << pvs.CompressedBytes() / 1024 << " KiB run-length coded, "
+		<< pvs.RawBytes() / 1024 << " KiB as plain bitsets ("
+		<< (double)pvs.RawBytes() / pvs.CompressedBytes() << "x), "
+		<< (double)pvs.CompressedBytes() / pvs.NumRegions() << " bytes per region" << std::endl;
+
+	// Round trip through the file format, then time lookups from the mapping
+	const char *fileName = "/tmp/maze_bench.pvs";
+	Pvs loaded;
+	bool ok = pvs.Save(fileName) && loaded.Load(fileName) && loaded.Matches(level);
+
+	MazeRng rng(11);
+	std::vector<float> eyes;
+	while(eyes.size() < 2 * NUM_EYES) {
+		int x = rng.Below(level.width), y = rng.Below(level.height);
+		if(!level.IsWall(x, y)) {
+			eyes.push_back(x + rng.Below(1000) / 1000.f - 0.5f);
+			eyes.push_back(y + rng.Below(1000) / 1000.f - 0.5f);
+		}
+	}
+
+	GridVisibility fromPvs, live;
+	long long pvsCells = 0, liveCells = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < NUM_EYES; i++) {
+		loaded.Lookup(eyes[2 * i], eyes[2 * i + 1], fromPvs);
+		pvsCells += fromPvs.numVisible;
+	}
+	double lookupUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / NUM_EYES;
+
+	start = std::chrono::steady_clock::now();
+	for(int i = 0; i < NUM_EYES; i++) {
+		live.Compute(level, eyes[2 * i], eyes[2 * i + 1], radius);
+		liveCells += live.numVisible;
+	}
+	double liveUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / NUM_EYES;
+
+	long long missed = 0;
+	for(int i = 0; i < NUM_EYES; i++) {
+		loaded.Lookup(eyes[2 * i], eyes[2 * i + 1], fromPvs);
+		live.Compute(level, eyes[2 * i], eyes[2 * i + 1], radius);
+		for(int y = live.OriginY(); y < live.OriginY() + live.WindowSize(); y++) {
+			for(int x = live.OriginX(); x < live.OriginX() + live.WindowSize(); x++) {
+				missed += live.IsVisible(x, y) && !fromPvs.IsVisible(x, y);
+			}
+		}
+	}
+
+	// Damaged files are refused instead of being read past their end
+	std::vector<char> bytes;
+	{
+		std::ifstream in(fileName, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	PvsHeader header;
+	memcpy(&header, bytes.data(), sizeof(header));
+	int refused = 0, damages = 0;
+	auto expectRefused = [&](std::vector<char> damaged) {
+		std::ofstream(fileName, std::ios::binary | std::ios::trunc).write(damaged.data(), damaged.size());
+		Pvs pvs;
+		refused += !pvs.Load(fileName);
+		damages++;
+	};
+	for(size_t field : { offsetof(PvsHeader, regionsX), offsetof(PvsHeader, regionsY), offsetof(PvsHeader, regionSize) }) {
+		std::vector<char> damaged = bytes;
+		damaged[field]++;
+		expectRefused(damaged);
+	}
+	std::vector<char> damaged = bytes;
+	uint32_t pastEnd = header.dataSize + 1;
+	memcpy(&damaged[header.offsetsOffset + loaded.NumRegions() * sizeof(uint32_t)], &pastEnd, sizeof(pastEnd));
+	expectRefused(damaged);
+	damaged = bytes;
+	uint32_t backwards = 0;
+	memcpy(&damaged[header.offsetsOffset + loaded.NumRegions() / 2 * sizeof(uint32_t)], &pastEnd, sizeof(pastEnd));
+	memcpy(&damaged[header.offsetsOffset + (loaded.NumRegions() / 2 + 1) * sizeof(uint32_t)], &backwards, sizeof(backwards));
+	expectRefused(damaged);
+	expectRefused(std::vector<char>(bytes.begin(), bytes.end() - 1));
+	remove(fileName);
+	ok = ok && refused == damages;
+
+	std::cout << "lookup: " << lookupUs << " us, " << pvsCells / NUM_EYES << " cells per set" << std::endl;
+	std::cout << "live GridVisibility: " << liveUs << " us, " << liveCells / NUM_EYES << " cells per set" << std::endl;
+	std::cout << "cells seen live but missing from the PVS: " << missed << " over " << NUM_EYES << " eyes" << std::endl;
+	std::cout << "damaged files refused: " << refused << " of " << damages << std::endl;
+
+	return ok ? 0 : 1;
+}
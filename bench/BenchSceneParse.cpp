@@ -0,0 +1,120 @@
+// Scenefile parse throughput over synthetic maps of up to 100M cells
+// Usage: BenchSceneParse [maxCells]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Scene.hpp"
+#include "SceneFile.hpp"
+
+static bool WriteSyntheticMap(const char *fileName, int width, int height) {
+	FILE *f = fopen(fileName, "wb");
+	if(!f) {
+		return false;
+	}
+
+	fprintf(f, "%d %d\n", width, height);
+
+	std::vector<char> row(width + 1);
+	unsigned int state = 12345;
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			state = state * 1664525u + 1013904223u;
+			row[x] = (state >> 28) < 5 ? 'W' : '0';
+		}
+		row[width] = '\n';
+		if(y == 0) {
+			row[0] = 'S';
+		}
+		fwrite(row.data(), 1, width + 1, f);
+	}
+
+	return fclose(f) == 0;
+}
+
+// Headers past INT_MAX cells parse, sides past SCENE_FILE_MAX_SIDE don't
+static bool CheckHeaderLimits(const char *fileName) {
+	static const struct { long long width, height; bool valid; } headers[] = {
+		{ 100000, 100000, true }, { SCENE_FILE_MAX_SIDE, 1, true }, { SCENE_FILE_MAX_SIDE + 1LL, 1, false }
+	};
+	for(const auto &header : headers) {
+		FILE *f = fopen(fileName, "w");
+		if(!f) {
+			return false;
+		}
+		fprintf(f, "%lld %lld\n", header.width, header.height);
+		fclose(f);
+
+		SceneFileReader reader;
+		bool opened = reader.Open(fileName);
+		if(opened != header.valid || (opened && reader.NumCells() != header.width * header.height)) {
+			std::cerr << "header \"" << header.width << " " << header.height << "\" " << (opened ? "accepted" : "rejected")
+				<< (opened ? "" : ": " + reader.Error()) << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+	long long maxCells = argc > 1 ? atoll(argv[1]) : 100000000LL;
+
+	static const int sizes[][2] = { { 1000, 1000 }, { 4000, 2500 }, { 10000, 10000 } };
+	const char *fileName = "/tmp/maze_bench_scene.txt";
+
+	if(!CheckHeaderLimits(fileName)) {
+		return 1;
+	}
+	std::cout << "header limits ok" << std::endl;
+
+	for(const int *size : sizes) {
+		int width = size[0], height = size[1];
+		long long cells = (long long)width * height;
+		if(cells > maxCells) {
+			break;
+		}
+
+		if(!WriteSyntheticMap(fileName, width, height)) {
+			std::cerr << "cannot write " << fileName << std::endl;
+			return 1;
+		}
+
+		// Reader alone: tokenizing and validation
+		auto start = std::chrono::steady_clock::now();
+		SceneFileReader reader;
+		std::vector<char> row(width);
+		bool ok = reader.Open(fileName);
+		for(int y = 0; ok && y < height; y++) {
+			ok = reader.ReadRow(row.data());
+		}
+		double readSeconds = Seconds(start);
+		if(!ok) {
+			std::cerr << reader.Error() << std::endl;
+			return 1;
+		}
+		long long bytes = reader.BytesRead();
+		reader.Close();
+
+		// Full load into Scene::level
+		start = std::chrono::steady_clock::now();
+		Scene scene;
+		if(!scene.LoadLevel(fileName)) {
+			return 1;
+		}
+		double loadSeconds = Seconds(start);
+
+		std::cout << width << "x" << height << " (" << cells << " cells, " << bytes / (1024 * 1024) << " MiB): "
+			<< "read " << cells / readSeconds / 1e6 << " Mcells/s, "
+			<< "load " << cells / loadSeconds / 1e6 << " Mcells/s (" << loadSeconds * 1000.0 << " ms)" << std::endl;
+	}
+
+	remove(fileName);
+	return 0;
+}
@@ -0,0 +1,150 @@
+// Fixed-timestep player simulation under an uneven frame rate, stepped
+// between frames and on its own thread
+// Frames take frameMs of busy work with a stall of stallMs every tenth
+// frame; the stepped simulation has to catch up in bursts after a stall,
+// the threaded one keeps ticking through it
+// Before timing, the fixed step is checked to give the same motion however
+// the time is split into frames; any mismatch fails the run
+// Usage: BenchSimulation [seconds] [frameMs] [stallMs]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "Simulation.hpp"
+
+static PlayerInput TestInput() {
+	PlayerInput input;
+	input.forward = 1.f;
+	input.right = 0.5f;
+	input.turn = 0.25f;
+	return input;
+}
+
+static bool SamePlayer(const Player &a, const Player &b) {
+	return a.origin.x == b.origin.x && a.origin.y == b.origin.y && a.origin.z == b.origin.z
+		&& a.yaw == b.yaw && a.pitch == b.pitch;
+}
+
+static int CheckSimulation() {
+	int failures = 0;
+	const double dt = 1.0 / SIM_TICK_RATE;
+	const int ticks = 600;
+
+	// One tick per call, against uneven frames covering the same time
+	Simulation even, uneven;
+	Player start;
+	even.Init(start, nullptr, nullptr, dt);
+	uneven.Init(start, nullptr, nullptr, dt);
+	even.SetInput(TestInput());
+	uneven.SetInput(TestInput());
+
+	int stepped = 0;
+	for(int i = 1; i <= ticks; i++) {
+		stepped += even.Advance(i * dt);
+	}
+	double t = 0.0;
+	unsigned int state = 5;
+	while(t < ticks * dt) {
+		state = state * 1664525u + 1013904223u;
+		t = std::min(ticks * dt, t + (state >> 24) / 255.0 * 4.0 * dt);
+		uneven.Advance(t);
+	}
+	if(stepped != ticks || uneven.Ticks() != ticks || !SamePlayer(even.Current(), uneven.Current())) {
+		std::cout << "  uneven frames changed the motion" << std::endl;
+		failures++;
+	}
+
+	// Interpolation runs from the previous tick to the current one
+	Player current = even.Current();
+	Player end = even.Interpolated(ticks * dt + dt);
+	Player middle = even.Interpolated(ticks * dt + dt / 2);
+	Vec3f step = end.origin - even.Interpolated(ticks * dt).origin;
+	if(!SamePlayer(end, current) || fabs((middle.origin - end.origin).Length() - step.Length() / 2) > 1e-5f) {
+		std::cout << "  interpolation does not end on the current tick" << std::endl;
+		failures++;
+	}
+
+	// Friction caps the speed, a little under acceleration / friction with a discrete step
+	float speed = current.vel.Length();
+	float topSpeed = PLAYER_ACCELERATION * (1.f - PLAYER_FRICTION * (float)dt) / PLAYER_FRICTION;
+	if(fabs(speed - topSpeed) > 0.05f) {
+		std::cout << "  top speed " << speed << ", expected " << topSpeed << std::endl;
+		failures++;
+	}
+
+	// A stall past the catch up limit drops the time instead of stepping it all
+	Simulation stalled;
+	stalled.Init(start, nullptr, nullptr, dt);
+	int burst = stalled.Advance(100 * dt);
+	if(burst != SIM_MAX_TICKS_PER_ADVANCE || stalled.Advance(100 * dt) != 0) {
+		std::cout << "  a stall stepped " << burst << " ticks" << std::endl;
+		failures++;
+	}
+	return failures;
+}
+
+static void Spin(double ms) {
+	auto end = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(ms);
+	while(std::chrono::steady_clock::now() < end) {
+	}
+}
+
+static void RunFrames(bool threaded, double seconds, double frameMs, double stallMs) {
+	Simulation sim;
+	sim.Init(Player(), nullptr);
+	sim.SetInput(TestInput());
+	if(threaded) {
+		sim.Start();
+	}
+
+	int frames = 0, totalTicks = 0, minTicks = 1 << 30, maxTicks = 0;
+	double last = sim.Now();
+	double frameTime = 0.0, frameTimeSq = 0.0;
+	while(sim.Now() < seconds) {
+		Spin(frameMs);
+		if(frames % 10 == 9) {
+			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(stallMs));
+		}
+
+		double now = sim.Now();
+		if(!threaded) {
+			sim.Advance(now);
+		}
+		sim.Interpolated(now);
+
+		int ticks = sim.TakeTicks();
+		totalTicks += ticks;
+		minTicks = std::min(minTicks, ticks);
+		maxTicks = std::max(maxTicks, ticks);
+		frameTime += now - last;
+		frameTimeSq += (now - last) * (now - last);
+		last = now;
+		frames++;
+	}
+	double elapsed = sim.Now();
+	sim.Stop();
+
+	double mean = frameTime / frames;
+	double jitter = sqrt(std::max(0.0, frameTimeSq / frames - mean * mean));
+	std::cout << "  " << (threaded ? "threaded" : "stepped ") << ": " << sim.Ticks() / elapsed << " ticks/s, "
+		<< sim.DroppedTicks() << " dropped, " << 1000.0 * sim.MaxLateness() << " ms max late, " << (double)totalTicks / frames << " ticks/frame (" << minTicks << "-" << maxTicks
+		<< "), frame " << 1000.0 * mean << " ms, jitter " << 1000.0 * jitter << " ms" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+	double frameMs = argc > 2 ? atof(argv[2]) : 8.0;
+	double stallMs = argc > 3 ? atof(argv[3]) : 100.0;
+
+	int failures = CheckSimulation();
+	std::cout << "fixed step: " << (failures ? "FAILED" : "ok") << std::endl;
+
+	std::cout << SIM_TICK_RATE << " Hz, " << frameMs << " ms frames, " << stallMs << " ms stall every 10th" << std::endl;
+	RunFrames(false, seconds, frameMs, stallMs);
+	RunFrames(true, seconds, frameMs, stallMs);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+// Memory and traversal cost of TileGrid against the old int-per-cell level
+// Usage: BenchTileGrid [size]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "TileGrid.hpp"
+
+#define NUM_SAMPLES (1 << 22)
+#define WINDOW 16
+
+template <typename Fn>
+static void Report(const char *name, Fn fn) {
+	auto start = std::chrono::steady_clock::now();
+	long long result = fn();
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "  " << name << ": " << ms << " ms (" << result << ")" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	int size = argc > 1 ? atoi(argv[1]) : 4096;
+
+	std::vector<int> ints((size_t)size * size);
+	TileGrid rowMajor, tiled;
+	rowMajor.Resize(size, size, TILE_LAYOUT_ROW_MAJOR);
+	tiled.Resize(size, size, TILE_LAYOUT_TILED);
+
+	unsigned int state = 1;
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			state = state * 1664525u + 1013904223u;
+			int tile = (state >> 28) < 6 ? LEVEL_WALL : LEVEL_AIR;
+			ints[(size_t)y * size + x] = tile;
+			rowMajor.Set(x, y, tile);
+			tiled.Set(x, y, tile);
+		}
+	}
+
+	std::cout << size << "x" << size << " level" << std::endl;
+	std::cout << "memory: int[] " << ints.size() * sizeof(int) / 1024 << " KiB, TileGrid row-major "
+		<< rowMajor.MemoryBytes() / 1024 << " KiB, tiled " << tiled.MemoryBytes() / 1024 << " KiB" << std::endl;
+
+	auto intAt = [&](int x, int y) {
+		return (x < 0 || y < 0 || x >= size || y >= size) ? LEVEL_AIR : ints[(size_t)y * size + x];
+	};
+
+	std::cout << "row scan, count walls" << std::endl;
+	Report("int[]", [&]() {
+		long long n = 0;
+		for(int y = 0; y < size; y++)
+			for(int x = 0; x < size; x++)
+				n += ints[(size_t)y * size + x] == LEVEL_WALL;
+		return n;
+	});
+	Report("TileGrid::At", [&]() {
+		long long n = 0;
+		for(int y = 0; y < size; y++)
+			for(int x = 0; x < size; x++)
+				n += rowMajor.At(x, y) == LEVEL_WALL;
+		return n;
+	});
+	Report("wall bitset", [&]() {
+		long long n = 0;
+		for(int y = 0; y < size; y++)
+			n += rowMajor.CountWallsInRow(y, 0, size);
+		return n;
+	});
+
+	std::cout << "column scan, count walls" << std::endl;
+	Report("int[]", [&]() {
+		long long n = 0;
+		for(int x = 0; x < size; x++)
+			for(int y = 0; y < size; y++)
+				n += ints[(size_t)y * size + x] == LEVEL_WALL;
+		return n;
+	});
+	Report("TileGrid row-major", [&]() {
+		long long n = 0;
+		for(int x = 0; x < size; x++)
+			for(int y = 0; y < size; y++)
+				n += rowMajor.At(x, y) == LEVEL_WALL;
+		return n;
+	});
+	Report("TileGrid tiled", [&]() {
+		long long n = 0;
+		for(int x = 0; x < size; x++)
+			for(int y = 0; y < size; y++)
+				n += tiled.At(x, y) == LEVEL_WALL;
+		return n;
+	});
+
+	// Scattered queries, as agents and visibility passes issue them
+	std::vector<int> samples(2 * NUM_SAMPLES);
+	for(int i = 0; i < NUM_SAMPLES; i++) {
+		state = state * 1664525u + 1013904223u;
+		samples[2 * i] = (state >> 8) % size;
+		state = state * 1664525u + 1013904223u;
+		samples[2 * i + 1] = (state >> 8) % size;
+	}
+
+	std::cout << "wall neighbours at " << NUM_SAMPLES << " random cells" << std::endl;
+	Report("int[]", [&]() {
+		long long n = 0;
+		for(int i = 0; i < NUM_SAMPLES; i++) {
+			int x = samples[2 * i], y = samples[2 * i + 1];
+			n += (intAt(x + 1, y) == LEVEL_WALL) + (intAt(x - 1, y) == LEVEL_WALL)
+				+ (intAt(x, y + 1) == LEVEL_WALL) + (intAt(x, y - 1) == LEVEL_WALL);
+		}
+		return n;
+	});
+	Report("TileGrid::WallNeighbours", [&]() {
+		long long n = 0;
+		for(int i = 0; i < NUM_SAMPLES; i++) {
+			n += __builtin_popcount(rowMajor.WallNeighbours(samples[2 * i], samples[2 * i + 1]));
+		}
+		return n;
+	});
+
+	std::cout << WINDOW << "x" << WINDOW << " windows at " << NUM_SAMPLES / 16 << " random cells" << std::endl;
+	auto window = [&](auto at) {
+		long long n = 0;
+		for(int i = 0; i < NUM_SAMPLES / 16; i++) {
+			int x0 = samples[2 * i] % (size - WINDOW), y0 = samples[2 * i + 1] % (size - WINDOW);
+			for(int y = y0; y < y0 + WINDOW; y++)
+				for(int x = x0; x < x0 + WINDOW; x++)
+					n += at(x, y) == LEVEL_WALL;
+		}
+		return n;
+	};
+	Report("int[]", [&]() { return window([&](int x, int y) { return ints[(size_t)y * size + x]; }); });
+	Report("TileGrid row-major", [&]() { return window([&](int x, int y) { return rowMajor.At(x, y); }); });
+	Report("TileGrid tiled", [&]() { return window([&](int x, int y) { return tiled.At(x, y); }); });
+
+	return 0;
+}
@@ -0,0 +1,112 @@
+// World baking: vertex/triangle counts and bake time before and after
+// hidden-face removal, on no_doors.txt and on a generated 1024x1024 maze
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "Scene.hpp"
+#include "WorldMesh.hpp"
+
+#define CUBE_VERTS 36
+
+// Binary tree maze: every odd cell carves towards +x or +y
+static void GenerateMaze(Scene &scene, int size) {
+	TileGrid &level = scene.level;
+	level.Resize(size, size);
+
+	srand(1);
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			level.Set(x, y, LEVEL_WALL);
+		}
+	}
+	for(int y = 1; y < size - 1; y += 2) {
+		for(int x = 1; x < size - 1; x += 2) {
+			level.Set(x, y, LEVEL_AIR);
+			bool canX = x + 2 < size - 1;
+			bool canY = y + 2 < size - 1;
+			if(canX && (!canY || rand() % 2)) {
+				level.Set(x + 1, y, LEVEL_AIR);
+			}
+			else if(canY) {
+				level.Set(x, y + 1, LEVEL_AIR);
+			}
+		}
+	}
+}
+
+// Unit faces that should survive baking, counted cell by cell
+static long ExposedFaces(const Scene &scene) {
+	const TileGrid &level = scene.level;
+	auto wall = [&](int x, int y) {
+		return level.Get(x, y) == LEVEL_WALL;
+	};
+	static const int dirs[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+	long faces = 0;
+	for(int y = 0; y < level.height; y++) {
+		for(int x = 0; x < level.width; x++) {
+			faces += wall(x, y) ? 0 : 1;	// Floor top
+			if(wall(x, y)) {
+				faces += 1;					// Wall top
+				for(const int *d : dirs) {
+					faces += wall(x + d[0], y + d[1]) ? 0 : 1;
+				}
+			}
+		}
+	}
+	faces += 2 * (level.width + level.height);	// Floor rim
+	return faces;
+}
+
+static double MeshArea(const WorldMesh &mesh) {
+	double area = 0.0;
+	const float *v = mesh.vertices.data();
+	for(size_t t = 0; t < mesh.NumTriangles(); t++, v += 3 * MESH_VERTEX_FLOATS) {
+		const float *a = v, *b = v + MESH_VERTEX_FLOATS, *c = v + 2 * MESH_VERTEX_FLOATS;
+		double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		area += 0.5 * sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	}
+	return area;
+}
+
+static bool Report(const char *name, const Scene &scene) {
+	const TileGrid &level = scene.level;
+
+	auto start = std::chrono::steady_clock::now();
+	WorldMesh mesh;
+	BakeWorldMesh(level, 0, 0, level.width, level.height, mesh);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	size_t before = UnbakedVertexCount(level, 0, 0, level.width, level.height, CUBE_VERTS);
+	std::cout << name << " (" << level.width << "x" << level.height << "): "
+		<< before << " verts / " << before / 3 << " tris before, "
+		<< mesh.NumVerts() << " verts / " << mesh.NumTriangles() << " tris after ("
+		<< (double)before / mesh.NumVerts() << "x fewer), baked in " << ms << " ms" << std::endl;
+
+	long expected = ExposedFaces(scene);
+	double area = MeshArea(mesh);
+	if(fabs(area - expected) > 1e-3 * expected) {
+		std::cerr << name << ": baked surface area " << area << " != " << expected << " exposed faces" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	Scene noDoors;
+	if(!noDoors.LoadLevel("scenefiles/no_doors.txt")) {
+		std::cerr << "error opening scenefiles/no_doors.txt" << std::endl;
+		return 1;
+	}
+
+	Scene maze;
+	GenerateMaze(maze, 1024);
+
+	bool ok = Report("no_doors.txt", noDoors);
+	ok = Report("generated maze", maze) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Chunk streaming: walks a player across a large synthetic level and reports
+// how fast chunks become ready, how long World::Update takes on the main
+// thread and how much baked geometry stays resident
+// Usage: BenchWorldStream [size]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "World.hpp"
+
+static bool WriteMap(const char *fileName, int size) {
+	FILE *f = fopen(fileName, "wb");
+	if(!f) {
+		return false;
+	}
+	fprintf(f, "%d %d\n", size, size);
+
+	// Walls on a lattice with random gaps, a rough stand-in for a maze
+	std::vector<char> row(size + 1);
+	unsigned int state = 7;
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			state = state * 1664525u + 1013904223u;
+			bool lattice = (x % 2 == 0) || (y % 2 == 0);
+			row[x] = (lattice && (state >> 29) < 5) ? 'W' : '0';
+		}
+		row[size] = '\n';
+		fwrite(row.data(), 1, size + 1, f);
+	}
+	return fclose(f) == 0;
+}
+
+int main(int argc, char **argv) {
+	int size = argc > 1 ? atoi(argv[1]) : 4096;
+	const char *fileName = "/tmp/maze_bench_stream.txt";
+	if(!WriteMap(fileName, size)) {
+		std::cerr << "cannot write " << fileName << std::endl;
+		return 1;
+	}
+
+	WorldStreamingConfig config;
+	config.loadRadius = 3;
+	config.memoryBudget = 64 << 20;
+
+	auto start = std::chrono::steady_clock::now();
+	World world;
+	if(!world.Open(fileName, config)) {
+		return 1;
+	}
+	double indexMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<std::unique_ptr<WorldChunk>> ready;
+	std::vector<int> evicted;
+
+	// Diagonal walk at 4 cells per frame, "uploading" whatever is ready
+	int frames = 0, loaded = 0, evictions = 0;
+	double maxUpdateMs = 0.0, totalUpdateMs = 0.0;
+	size_t maxResident = 0;
+	start = std::chrono::steady_clock::now();
+	for(float p = 0.f; p < size; p += 4.f, frames++) {
+		auto updateStart = std::chrono::steady_clock::now();
+		ready.clear();
+		evicted.clear();
+		world.Update(p, p, ready, evicted);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count();
+
+		totalUpdateMs += ms;
+		maxUpdateMs = ms > maxUpdateMs ? ms : maxUpdateMs;
+		loaded += ready.size();
+		evictions += evicted.size();
+		maxResident = world.ResidentBytes() > maxResident ? world.ResidentBytes() : maxResident;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << size << "x" << size << ", " << world.NumChunks() << " chunks of " << WORLD_CHUNK_SIZE << "^2, index built in "
+		<< indexMs << " ms" << std::endl;
+	std::cout << frames << " frames: " << loaded << " chunks loaded (" << loaded / seconds << "/s), "
+		<< evictions << " evicted" << std::endl;
+	std::cout << "Update: " << totalUpdateMs / frames << " ms avg, " << maxUpdateMs << " ms max" << std::endl;
+	std::cout << "resident: " << maxResident / (1024 * 1024) << " MiB peak, budget "
+		<< config.memoryBudget / (1024 * 1024) << " MiB" << std::endl;
+
+	// Standing still with room for about four chunks: the budget holds every
+	// frame and what fits settles instead of being reloaded over and over
+	world.config.memoryBudget = world.NumResident() ? world.ResidentBytes() / world.NumResident() * 4 : 0;
+	bool budgetHeld = true;
+	int settleLoads = 0;
+	for(int frame = 0; frame < 400; frame++) {
+		ready.clear();
+		evicted.clear();
+		world.Update(size / 2.f, size / 2.f, ready, evicted);
+		budgetHeld &= world.ResidentBytes() <= world.config.memoryBudget;
+		settleLoads += frame >= 200 ? ready.size() : 0;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	bool settled = settleLoads == 0 && world.NumResident() > 0;
+	std::cout << "tight budget of " << world.config.memoryBudget / 1024 << " KiB: " << world.NumResident() << " resident, "
+		<< settleLoads << " loads after settling, " << (budgetHeld && settled ? "ok" : "FAILED") << std::endl;
+
+	world.Close();
+	remove(fileName);
+	return maxResident <= config.memoryBudget && budgetHeld && settled ? 0 : 1;
+}
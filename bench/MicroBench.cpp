@@ -0,0 +1,339 @@
+// Microbenchmark suite over the hot paths outside the GL front end: model
+// parsing, scenefile parsing, the Math.hpp operators, grid traversal and
+// building the per-frame instance lists
+// Each case is checked once before it is timed, a failed check makes the
+// run exit non-zero; results go to the console and, with --json, to a file
+// that can be compared between commits
+// Build and run optimized with `make microbench`
+// Usage: MicroBench [--reps n] [--warmup n] [--filter substring] [--json file] [--revision id]
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BenchHarness.hpp"
+#include "CellInstances.hpp"
+#include "Collision.hpp"
+#include "Frustum.hpp"
+#include "GridCuller.hpp"
+#include "GridVisibility.hpp"
+#include "Math.hpp"
+#include "MazeGen.hpp"
+#include "Mesh.hpp"
+#include "MeshOptimize.hpp"
+#include "Scene.hpp"
+#include "SceneFile.hpp"
+#include "WorldMesh.hpp"
+
+#define MAZE_ROOMS 256			// 513x513 level
+#define MATH_COUNT (1 << 16)
+#define SWEEP_COUNT 4096
+
+// Column-major perspective * look-at, laid out like glm
+static void ViewProjection(const float *eye, const float *center, float fovy, float aspect, float zNear, float zFar,
+	float *out) {
+	float f[3] = { center[0] - eye[0], center[1] - eye[1], center[2] - eye[2] };
+	float fl = sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+	for(float &v : f) v /= fl;
+	float s[3] = { f[1], -f[0], 0.f };		// f x up, with z up
+	float sl = sqrtf(s[0] * s[0] + s[1] * s[1]);
+	for(float &v : s) v /= sl;
+	float u[3] = { s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0] };
+
+	float view[16] = {};
+	for(int i = 0; i < 3; i++) {
+		view[i * 4 + 0] = s[i];
+		view[i * 4 + 1] = u[i];
+		view[i * 4 + 2] = -f[i];
+	}
+	view[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+	view[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+	view[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+	view[15] = 1.f;
+
+	float proj[16] = {};
+	float t = 1.f / tanf(fovy / 2.f);
+	proj[0] = t / aspect;
+	proj[5] = t;
+	proj[10] = -(zFar + zNear) / (zFar - zNear);
+	proj[11] = -1.f;
+	proj[14] = -2.f * zFar * zNear / (zFar - zNear);
+
+	for(int c = 0; c < 4; c++) {
+		for(int row = 0; row < 4; row++) {
+			float sum = 0.f;
+			for(int k = 0; k < 4; k++) {
+				sum += proj[k * 4 + row] * view[c * 4 + k];
+			}
+			out[c * 4 + row] = sum;
+		}
+	}
+}
+
+static void BenchModels(BenchHarness &harness) {
+	Mesh text, binary;
+	if(!text.LoadText("models/knot.txt") || !binary.LoadBinary("models/knot.mesh")) {
+		harness.Fail("models/knot.txt and models/knot.mesh are needed, run from the repository root after `make meshes`");
+		return;
+	}
+	if(text.numVerts != binary.numVerts || memcmp(text.vertices, binary.vertices, (size_t)text.numVerts * MESH_VERTEX_STRIDE)) {
+		harness.Fail("knot.txt and knot.mesh hold different vertices");
+	}
+	int numVerts = text.numVerts;
+
+	harness.Run("model", "load_text_knot", numVerts, "verts", [&]() {
+		Mesh mesh;
+		mesh.LoadText("models/knot.txt");
+		BenchKeep(mesh.vertices[0]);
+	});
+	harness.Run("model", "load_binary_knot", numVerts, "verts", [&]() {
+		Mesh mesh;
+		mesh.LoadBinary("models/knot.mesh");
+		BenchKeep(mesh.vertices[0]);
+	});
+
+	// Welding and reordering alone, without the text parse
+	std::vector<float> soup, vertices;
+	std::vector<uint32_t> indices;
+	ReadTextModel("models/knot.txt", soup);
+	harness.Run("model", "build_indexed_knot", soup.size() / MESH_VERTEX_FLOATS, "verts", [&]() {
+		BuildIndexedMesh(soup.data(), soup.size() / MESH_VERTEX_FLOATS, vertices, indices);
+		BenchKeep(indices.back());
+	});
+}
+
+static void BenchScenefile(BenchHarness &harness, const TileGrid &level) {
+	const char *fileName = "/tmp/maze_microbench_scene.txt";
+	if(!WriteSceneFile(fileName, level)) {
+		harness.Fail(std::string("cannot write ") + fileName);
+		return;
+	}
+
+	Scene check;
+	if(!check.LoadLevel(fileName) || check.level.width != level.width || check.level.height != level.height) {
+		harness.Fail("scenefile round trip changed the level size");
+	}
+	else {
+		for(int y = 0; y < level.height; y++) {
+			if(check.level.CountWallsInRow(y, 0, level.width) != level.CountWallsInRow(y, 0, level.width)) {
+				harness.Fail("scenefile round trip changed row " + std::to_string(y));
+				break;
+			}
+		}
+	}
+
+	double cells = (double)level.width * level.height;
+	harness.Run("scenefile", "load_level_513", cells, "cells", [&]() {
+		Scene scene;
+		scene.LoadLevel(fileName);
+		BenchKeep(scene.level.width);
+	});
+	remove(fileName);
+}
+
+static void BenchMath(BenchHarness &harness) {
+	unsigned int state = 1;
+	std::vector<Vec3f> a(MATH_COUNT), b(MATH_COUNT), out(MATH_COUNT);
+	std::vector<float> x(MATH_COUNT), y(MATH_COUNT), z(MATH_COUNT), ox(MATH_COUNT), oy(MATH_COUNT), oz(MATH_COUNT);
+	for(int i = 0; i < MATH_COUNT; i++) {
+		a[i] = Vec3f(BenchRandomSigned(state), BenchRandomSigned(state), BenchRandomSigned(state));
+		b[i] = Vec3f(BenchRandomSigned(state), BenchRandomSigned(state), BenchRandomSigned(state));
+		x[i] = a[i].x;
+		y[i] = a[i].y;
+		z[i] = a[i].z;
+	}
+	Quaternion q(Vec3f(0.f, 0.6f, 0.8f), 1.1f);
+
+	// The batch kernel agrees with the per-element operator
+	RotateVectors(q, { x.data(), y.data(), z.data() }, { ox.data(), oy.data(), oz.data() }, MATH_COUNT);
+	for(int i = 0; i < MATH_COUNT; i++) {
+		Vec3f r = q.RotateVector(a[i]);
+		if(fabsf(r.x - ox[i]) > 1e-5f || fabsf(r.y - oy[i]) > 1e-5f || fabsf(r.z - oz[i]) > 1e-5f) {
+			harness.Fail("RotateVectors differs from Quaternion::RotateVector at " + std::to_string(i));
+			break;
+		}
+	}
+
+	harness.Run("math", "vec3_add_scale", MATH_COUNT, "vecs", [&]() {
+		for(int i = 0; i < MATH_COUNT; i++) {
+			out[i] = a[i] + b[i] * 0.5f - a[i] / 3.f;
+		}
+		BenchKeep(out[MATH_COUNT - 1]);
+	});
+	harness.Run("math", "vec3_dot_cross", MATH_COUNT, "vecs", [&]() {
+		float sum = 0.f;
+		for(int i = 0; i < MATH_COUNT; i++) {
+			sum += a[i].Cross(b[i]).Dot(a[i]);
+		}
+		BenchKeep(sum);
+	});
+	harness.Run("math", "vec3_normalize", MATH_COUNT, "vecs", [&]() {
+		for(int i = 0; i < MATH_COUNT; i++) {
+			out[i] = a[i];
+			out[i].Normalize();
+		}
+		BenchKeep(out[MATH_COUNT - 1]);
+	});
+	harness.Run("math", "quat_rotate_vector", MATH_COUNT, "vecs", [&]() {
+		for(int i = 0; i < MATH_COUNT; i++) {
+			out[i] = q.RotateVector(a[i]);
+		}
+		BenchKeep(out[MATH_COUNT - 1]);
+	});
+	harness.Run("math", "rotate_vectors_batch", MATH_COUNT, "vecs", [&]() {
+		RotateVectors(q, { x.data(), y.data(), z.data() }, { ox.data(), oy.data(), oz.data() }, MATH_COUNT);
+		BenchKeep(ox[MATH_COUNT - 1]);
+	});
+}
+
+static void BenchGrid(BenchHarness &harness, const TileGrid &level) {
+	double cells = (double)level.width * level.height;
+
+	long long walls = 0;
+	for(int y = 0; y < level.height; y++) {
+		walls += level.CountWallsInRow(y, 0, level.width);
+	}
+
+	harness.Run("grid", "scan_tiles", cells, "cells", [&]() {
+		long long count = 0;
+		for(int y = 0; y < level.height; y++) {
+			for(int x = 0; x < level.width; x++) {
+				count += level.At(x, y) == LEVEL_WALL;
+			}
+		}
+		BenchKeep(count);
+	});
+	harness.Run("grid", "count_walls_bitset", cells, "cells", [&]() {
+		long long count = 0;
+		for(int y = 0; y < level.height; y++) {
+			count += level.CountWallsInRow(y, 0, level.width);
+		}
+		if(count != walls) {
+			harness.Fail("CountWallsInRow is not stable");
+		}
+	});
+
+	// Eyes in the middle of rooms, which sit on odd coordinates
+	std::vector<float> eyes;
+	unsigned int state = 5;
+	for(int i = 0; i < 64; i++) {
+		eyes.push_back((float)(1 + 2 * (int)((BenchRandomSigned(state) + 1.f) / 2.f * (MAZE_ROOMS - 1))));
+		eyes.push_back((float)(1 + 2 * (int)((BenchRandomSigned(state) + 1.f) / 2.f * (MAZE_ROOMS - 1))));
+	}
+	GridVisibility visibility;
+	visibility.Compute(level, eyes[0], eyes[1], VISIBILITY_RADIUS);
+	if(!visibility.IsVisible((int)eyes[0], (int)eyes[1])) {
+		harness.Fail("GridVisibility does not see the eye cell");
+	}
+	harness.Run("grid", "shadowcast_r11", (double)eyes.size() / 2, "eyes", [&]() {
+		int visible = 0;
+		for(size_t i = 0; i < eyes.size(); i += 2) {
+			visibility.Compute(level, eyes[i], eyes[i + 1], VISIBILITY_RADIUS);
+			visible += visibility.numVisible;
+		}
+		BenchKeep(visible);
+	});
+
+	// Short moves out of the rooms, the walking and collision path
+	std::vector<float> sweeps;
+	for(int i = 0; i < SWEEP_COUNT; i++) {
+		sweeps.push_back(eyes[(i % 64) * 2]);
+		sweeps.push_back(eyes[(i % 64) * 2 + 1]);
+		sweeps.push_back(BenchRandomSigned(state) * 3.f);
+		sweeps.push_back(BenchRandomSigned(state) * 3.f);
+	}
+	harness.Run("grid", "sweep_circle", SWEEP_COUNT, "sweeps", [&]() {
+		CollisionStats stats;
+		int hits = 0;
+		for(size_t i = 0; i < sweeps.size(); i += 4) {
+			SweepHit hit;
+			hits += SweepCircle(level, sweeps[i], sweeps[i + 1], PLAYER_RADIUS, sweeps[i + 2], sweeps[i + 3], hit, stats);
+		}
+		BenchKeep(hits);
+	});
+}
+
+static void BenchRenderCommands(BenchHarness &harness, const TileGrid &level) {
+	const GridCullBounds bounds = { -1.5f, 0.5f };
+
+	std::vector<CellSpan> rows;
+	long long walls = 0, keys = 0;
+	for(int y = 0; y < level.height; y++) {
+		rows.push_back({ y, 0, level.width });
+		for(int x = 0; x < level.width; x++) {
+			walls += level.At(x, y) == LEVEL_WALL;
+			keys += level.At(x, y) == LEVEL_KEY;
+		}
+	}
+
+	std::vector<InstanceData> cubeInstances, keyInstances;
+	BuildCellInstances(level, rows, cubeInstances, keyInstances);
+	if((long long)cubeInstances.size() != (long long)level.width * level.height + walls || (long long)keyInstances.size() != keys) {
+		harness.Fail("BuildCellInstances made the wrong number of instances");
+	}
+
+	double cells = (double)level.width * level.height;
+	harness.Run("render", "build_instances_full", cells, "cells", [&]() {
+		cubeInstances.clear();
+		keyInstances.clear();
+		BuildCellInstances(level, rows, cubeInstances, keyInstances);
+		BenchKeep(cubeInstances.size());
+	});
+
+	// The per-frame path: frustum, culled spans, shadowcast filter, instances
+	float eyeX = (float)(level.width / 2 | 1), eyeY = (float)(level.height / 2 | 1);
+	float eye[3] = { eyeX, eyeY, 0.2f };
+	float center[3] = { eyeX + 1.f, eyeY + 0.5f, 0.1f };
+	float viewProj[16];
+	ViewProjection(eye, center, 45.f * 3.14159265f / 180.f, 1200.f / 900.f, 0.1f, 64.f, viewProj);
+	Frustum frustum;
+	frustum.Extract(viewProj);
+
+	std::vector<CellSpan> spans, visibleSpans;
+	GridVisibility visibility;
+	harness.Run("render", "cull_and_build_frame", 1, "frames", [&]() {
+		spans.clear();
+		visibleSpans.clear();
+		cubeInstances.clear();
+		keyInstances.clear();
+
+		CullStats stats;
+		CullGrid(frustum, bounds, 0, 0, level.width, level.height, spans, stats);
+		visibility.Compute(level, eyeX, eyeY, VISIBILITY_RADIUS);
+		visibility.FilterSpans(spans, visibleSpans, stats);
+		BuildCellInstances(level, visibleSpans, cubeInstances, keyInstances);
+		BenchKeep(cubeInstances.size());
+	});
+	if(cubeInstances.empty()) {
+		harness.Fail("the frame camera sees no cells");
+	}
+
+	WorldMesh mesh;
+	harness.Run("render", "bake_world_64", 64 * 64, "cells", [&]() {
+		BakeWorldMesh(level, 0, 0, 64, 64, mesh);
+		BenchKeep(mesh.vertices.size());
+	});
+}
+
+int main(int argc, char **argv) {
+	BenchHarness harness(argc, argv);
+
+	MazeGenConfig config;
+	config.roomsX = config.roomsY = MAZE_ROOMS;
+	config.seed = 7;
+	TileGrid level;
+	if(!GenerateMaze(config, level)) {
+		std::cerr << "Failed to generate the benchmark maze" << std::endl;
+		return 1;
+	}
+
+	BenchModels(harness);
+	BenchScenefile(harness, level);
+	BenchMath(harness);
+	BenchGrid(harness, level);
+	BenchRenderCommands(harness, level);
+
+	return harness.Finish();
+}
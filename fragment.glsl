@@ -3,7 +3,6 @@
 in vec3 Color;
 in vec3 vertNormal;
 in vec3 pos;
-in vec3 lightDir;
 in vec2 texcoord;
 
 out vec4 outColor;
@@ -12,6 +11,7 @@ uniform sampler2D tex0;
 uniform sampler2D tex1;
 
 uniform int texID;
+uniform vec3 lightDir;		// View space, set once per frame
 
 const float ambient = .3;
 void main() {
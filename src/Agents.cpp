@@ -0,0 +1,221 @@
+#include "Agents.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "MazeGen.hpp"
+#include "Profiler.hpp"
+#include "Simulation.hpp"
+
+AgentHandle AgentStore::Create(const Player &player, uint64_t seed) {
+	AgentHandle handle;
+	if(!m_free.empty()) {
+		handle.index = m_free.back();
+		m_free.pop_back();
+	}
+	else {
+		handle.index = (uint32_t)m_slotOf.size();
+		m_slotOf.push_back(0);
+		m_generation.push_back(0);
+	}
+	handle.generation = ++m_generation[handle.index];
+
+	int slot = Count();
+	m_slotOf[handle.index] = slot;
+	m_indexOf.push_back(handle.index);
+
+	for(std::vector<float> *column : { &transforms.x, &transforms.y, &transforms.z, &transforms.yaw, &transforms.pitch,
+		&motion.velX, &motion.velY, &motion.velZ, &controls.forward, &controls.right, &controls.turn, &controls.look,
+		&brains.nextThink }) {
+		column->push_back(0.f);
+	}
+	brains.rng.push_back(seed);
+	SetPlayer(slot, player);
+
+	return handle;
+}
+
+void AgentStore::Destroy(AgentHandle handle) {
+	int slot = Slot(handle);
+	if(slot < 0) {
+		return;
+	}
+
+	int last = Count() - 1;
+	for(std::vector<float> *column : { &transforms.x, &transforms.y, &transforms.z, &transforms.yaw, &transforms.pitch,
+		&motion.velX, &motion.velY, &motion.velZ, &controls.forward, &controls.right, &controls.turn, &controls.look,
+		&brains.nextThink }) {
+		(*column)[slot] = (*column)[last];
+		column->pop_back();
+	}
+	brains.rng[slot] = brains.rng[last];
+	brains.rng.pop_back();
+
+	uint32_t moved = m_indexOf[last];
+	m_indexOf[slot] = moved;
+	m_slotOf[moved] = slot;
+	m_indexOf.pop_back();
+
+	m_generation[handle.index]++;
+	m_free.push_back(handle.index);
+}
+
+bool AgentStore::Alive(AgentHandle handle) const {
+	return handle.index < m_generation.size() && m_generation[handle.index] == handle.generation && (handle.generation & 1);
+}
+
+int AgentStore::Slot(AgentHandle handle) const {
+	return Alive(handle) ? (int)m_slotOf[handle.index] : -1;
+}
+
+void AgentStore::Clear() {
+	*this = AgentStore();
+}
+
+Player AgentStore::GetPlayer(int slot) const {
+	Player player;
+	player.origin = Vec3f(transforms.x[slot], transforms.y[slot], transforms.z[slot]);
+	player.vel = Vec3f(motion.velX[slot], motion.velY[slot], motion.velZ[slot]);
+	player.yaw = transforms.yaw[slot];
+	player.pitch = transforms.pitch[slot];
+	return player;
+}
+
+void AgentStore::SetPlayer(int slot, const Player &player) {
+	transforms.x[slot] = player.origin.x;
+	transforms.y[slot] = player.origin.y;
+	transforms.z[slot] = player.origin.z;
+	transforms.yaw[slot] = player.yaw;
+	transforms.pitch[slot] = player.pitch;
+	motion.velX[slot] = player.vel.x;
+	motion.velY[slot] = player.vel.y;
+	motion.velZ[slot] = player.vel.z;
+}
+
+void ThinkAgents(AgentStore &store, int begin, int end, float dt) {
+	AgentControls &controls = store.controls;
+	AgentBrains &brains = store.brains;
+	const AgentMotion &motion = store.motion;
+
+	for(int i = begin; i < end; i++) {
+		brains.nextThink[i] -= dt;
+		if(brains.nextThink[i] > 0.f) {
+			continue;
+		}
+
+		MazeRng rng(brains.rng[i]);
+		float speed2 = motion.velX[i] * motion.velX[i] + motion.velY[i] * motion.velY[i];
+		controls.forward[i] = 1.f;
+		if(speed2 < 0.25f) {
+			// Walked into a wall, turn away from it quickly
+			controls.turn[i] = rng.Coin() ? 1.f : -1.f;
+			brains.nextThink[i] = AGENT_THINK_TIME * 0.5f;
+		}
+		else {
+			controls.turn[i] = ((int)rng.Below(201) - 100) / 100.f;
+			brains.nextThink[i] = AGENT_THINK_TIME * (0.5f + rng.Below(101) / 100.f);
+		}
+		brains.rng[i] = rng.state;
+	}
+}
+
+void SteerAgents(AgentStore &store, const FlowField &field, int begin, int end) {
+	static const float targets[][2] = { { 0.f, 0.f }, { 0.f, 0.f }, { 1.f, 0.f }, { -1.f, 0.f }, { 0.f, 1.f }, { 0.f, -1.f } };
+
+	AgentControls &controls = store.controls;
+	const AgentTransforms &transforms = store.transforms;
+	for(int i = begin; i < end; i++) {
+		int cellX = (int)floorf(transforms.x[i] + 0.5f), cellY = (int)floorf(transforms.y[i] + 0.5f);
+		FlowDirection direction = field.Direction(cellX, cellY);
+		if(direction == FLOW_NONE || direction == FLOW_GOAL) {
+			controls.forward[i] = 0.f;
+			controls.turn[i] = 0.f;
+			continue;
+		}
+
+		// Aim for the centre of the next cell, slowing down while facing away from it
+		float toX = cellX + targets[direction][0] - transforms.x[i];
+		float toY = cellY + targets[direction][1] - transforms.y[i];
+		float off = remainderf(atan2f(toY, toX) - transforms.yaw[i], 6.2831853f);
+		controls.turn[i] = std::max(-1.f, std::min(1.f, off * 4.f));
+		controls.forward[i] = std::max(0.f, cosf(off));
+	}
+}
+
+void MoveAgents(AgentStore &store, const TileGrid *level, int begin, int end, float dt, CollisionStats &stats) {
+	const AgentControls &controls = store.controls;
+	for(int i = begin; i < end; i++) {
+		PlayerInput input;
+		input.forward = controls.forward[i];
+		input.right = controls.right[i];
+		input.turn = controls.turn[i];
+		input.look = controls.look[i];
+
+		Player player = store.GetPlayer(i);
+		StepPlayer(player, input, dt, level, stats);
+		store.SetPlayer(i, player);
+	}
+}
+
+void AgentSim::Init(const TileGrid *level, int threads) {
+	m_level = level;
+	store.Clear();
+	stats = AgentTickStats();
+	m_pool.Start(threads);
+	m_workerCollision.assign(m_pool.NumThreads(), WorkerCollision());
+}
+
+int AgentSim::Spawn(int count, uint64_t seed) {
+	if(!m_level || m_level->width == 0) {
+		return 0;
+	}
+
+	MazeRng rng(seed);
+	int spawned = 0;
+	for(int attempts = 0; spawned < count && attempts < count * 100; attempts++) {
+		int x = rng.Below(m_level->width), y = rng.Below(m_level->height);
+		if(m_level->Get(x, y) != LEVEL_AIR) {
+			continue;
+		}
+		Player player;
+		player.origin = Vec3f((float)x, (float)y, 0.f);
+		player.yaw = rng.Below(360) * 3.14159265f / 180.f;
+		store.Create(player, rng.Next());
+		spawned++;
+	}
+	return spawned;
+}
+
+void AgentSim::Tick(float dt) {
+	int count = store.Count();
+
+	stats.thinkMs = TimeMs([&]() {
+		m_pool.Run(count, AGENT_CHUNK, [&](int begin, int end, int) {
+			PROFILE_ZONE("ThinkAgents");
+			if(m_field) {
+				SteerAgents(store, *m_field, begin, end);
+			}
+			else {
+				ThinkAgents(store, begin, end, dt);
+			}
+		});
+	});
+
+	for(WorkerCollision &worker : m_workerCollision) {
+		worker.stats = CollisionStats();
+	}
+	stats.moveMs = TimeMs([&]() {
+		m_pool.Run(count, AGENT_CHUNK, [&](int begin, int end, int worker) {
+			PROFILE_ZONE("MoveAgents");
+			MoveAgents(store, m_level, begin, end, dt, m_workerCollision[worker].stats);
+		});
+	});
+
+	stats.collision = CollisionStats();
+	for(const WorkerCollision &worker : m_workerCollision) {
+		stats.collision.queries += worker.stats.queries;
+		stats.collision.cellsVisited += worker.stats.cellsVisited;
+		stats.collision.wallsTested += worker.stats.wallsTested;
+		stats.collision.hits += worker.stats.hits;
+	}
+}
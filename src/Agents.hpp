@@ -0,0 +1,127 @@
+#ifndef AGENTS_INCLUDED
+#define AGENTS_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "Collision.hpp"
+#include "FlowField.hpp"
+#include "JobPool.hpp"
+#include "Scene.hpp"
+
+#define AGENT_CHUNK 256				// Agents per job range
+#define AGENT_THINK_TIME 0.5f		// Seconds between new directions, on average
+
+// Stays valid until the agent is destroyed, slots move when others are
+struct AgentHandle {
+	uint32_t	index = 0;
+	uint32_t	generation = 0;
+};
+
+// Components as columns indexed by slot, live agents packed in [0, Count())
+struct AgentTransforms {
+	std::vector<float>	x, y, z;
+	std::vector<float>	yaw, pitch;
+};
+
+struct AgentMotion {
+	std::vector<float>	velX, velY, velZ;
+};
+
+// The same controls a player has, set by the agent's brain
+struct AgentControls {
+	std::vector<float>	forward, right, turn, look;
+};
+
+struct AgentBrains {
+	std::vector<uint64_t>	rng;
+	std::vector<float>		nextThink;
+};
+
+// Entity-component store for agents: systems walk the columns of the
+// components they need, creating and destroying keeps every column packed
+class AgentStore {
+public:
+	AgentHandle Create(const Player &player, uint64_t seed);
+
+	// Moves the last agent into the freed slot
+	void Destroy(AgentHandle handle);
+
+	bool Alive(AgentHandle handle) const;
+
+	// -1 if the agent is gone
+	int Slot(AgentHandle handle) const;
+
+	int Count() const { return (int)m_indexOf.size(); }
+	void Clear();
+
+	// Gathers and scatters the components a Player has
+	Player GetPlayer(int slot) const;
+	void SetPlayer(int slot, const Player &player);
+
+	AgentTransforms	transforms;
+	AgentMotion		motion;
+	AgentControls	controls;
+	AgentBrains		brains;
+
+private:
+	std::vector<uint32_t>	m_slotOf;		// By handle index
+	std::vector<uint32_t>	m_generation;	// By handle index, odd while alive
+	std::vector<uint32_t>	m_indexOf;		// By slot
+	std::vector<uint32_t>	m_free;
+};
+
+// Systems, each over the slots [begin, end)
+
+// Wanders: picks a new turn now and then, and turns hard when stuck
+void ThinkAgents(AgentStore &store, int begin, int end, float dt);
+
+// Heads for the nearest goal with a single flow field lookup per agent,
+// standing still once there
+void SteerAgents(AgentStore &store, const FlowField &field, int begin, int end);
+
+// Same motion and collision as the player
+void MoveAgents(AgentStore &store, const TileGrid *level, int begin, int end, float dt, CollisionStats &stats);
+
+struct AgentTickStats {
+	double			thinkMs = 0.0;
+	double			moveMs = 0.0;
+	CollisionStats	collision;
+};
+
+// Agents in a level, with their systems run in order every tick, each
+// split into AGENT_CHUNK ranges over a pool of worker threads
+// Agents never touch each other, so the result does not depend on the
+// thread count
+class AgentSim {
+public:
+	// level is only read, and has to outlive the agents; 0 threads uses every core
+	void Init(const TileGrid *level, int threads);
+
+	// Into random air cells, returns how many were placed
+	int Spawn(int count, uint64_t seed);
+
+	// Agents steer along field instead of wandering while it is set, it has
+	// to outlive them and must not change while they tick
+	void SetFlowField(const FlowField *field) { m_field = field; }
+
+	void Tick(float dt);
+
+	int NumThreads() const { return m_pool.NumThreads(); }
+
+	AgentStore		store;
+	AgentTickStats	stats;			// Of the last tick
+
+private:
+	// A cache line each, so workers counting collisions do not share one
+	struct alignas(64) WorkerCollision {
+		CollisionStats	stats;
+	};
+
+	const TileGrid	*m_level = nullptr;
+	const FlowField	*m_field = nullptr;
+	JobPool			m_pool;
+	std::vector<WorkerCollision>	m_workerCollision;
+};
+
+#endif
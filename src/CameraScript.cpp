@@ -0,0 +1,79 @@
+#include "CameraScript.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Pathfind.hpp"
+
+void CameraScript::Init(const TileGrid &level, const Player &start) {
+	m_start = start;
+	m_points.clear();
+	m_length.clear();
+
+	int startX = (int)floorf(start.origin.x + 0.5f), startY = (int)floorf(start.origin.y + 0.5f);
+	int goalX, goalY;
+	if(level.width == 0 || !FindTile(level, LEVEL_GOAL, goalX, goalY)) {
+		return;
+	}
+
+	Pathfinder finder;
+	finder.Init(&level);
+	std::vector<PathCell> path;
+	if(!finder.Find(PATH_JPS, startX, startY, goalX, goalY, path) || path.size() < 2) {
+		return;
+	}
+
+	// From where the player stands, then through the middle of each cell
+	m_points.insert(m_points.end(), { start.origin.x, start.origin.y });
+	m_length.push_back(0.f);
+	for(size_t i = 1; i < path.size(); i++) {
+		float x = path[i].x, y = path[i].y;
+		float dx = x - m_points[m_points.size() - 2], dy = y - m_points.back();
+		m_points.insert(m_points.end(), { x, y });
+		m_length.push_back(m_length.back() + sqrtf(dx * dx + dy * dy));
+	}
+}
+
+void CameraScript::PointAt(float s, float &x, float &y) const {
+	s = std::max(0.f, std::min(s, Length()));
+	size_t i = std::upper_bound(m_length.begin(), m_length.end(), s) - m_length.begin();
+	if(i >= m_length.size()) {
+		x = m_points[m_points.size() - 2];
+		y = m_points.back();
+		return;
+	}
+
+	float t = (s - m_length[i - 1]) / (m_length[i] - m_length[i - 1]);
+	x = m_points[2 * i - 2] + (m_points[2 * i] - m_points[2 * i - 2]) * t;
+	y = m_points[2 * i - 1] + (m_points[2 * i + 1] - m_points[2 * i - 1]) * t;
+}
+
+Player CameraScript::At(double t) const {
+	Player player = m_start;
+	player.vel = Vec3f(0, 0, 0);
+	player.pitch = 0.f;
+
+	t = std::max(0.0, std::min(t, 1.0));
+	if(m_length.empty()) {
+		player.yaw = m_start.yaw + (float)(t * 2.0 * M_PI);
+		return player;
+	}
+
+	// Facing a point ahead rounds the corners off, the last stretch keeps
+	// the direction it arrived in
+	float s = (float)t * Length();
+	float x, y, aheadX, aheadY;
+	PointAt(s, x, y);
+	PointAt(std::min(s, Length() - CAMERA_SCRIPT_LOOKAHEAD) + CAMERA_SCRIPT_LOOKAHEAD, aheadX, aheadY);
+	if(s > Length() - CAMERA_SCRIPT_LOOKAHEAD) {
+		float fromX, fromY;
+		PointAt(Length() - CAMERA_SCRIPT_LOOKAHEAD, fromX, fromY);
+		player.yaw = atan2f(aheadY - fromY, aheadX - fromX);
+	}
+	else {
+		player.yaw = atan2f(aheadY - y, aheadX - x);
+	}
+	player.origin.x = x;
+	player.origin.y = y;
+	return player;
+}
@@ -0,0 +1,31 @@
+#ifndef CAMERA_SCRIPT_INCLUDED
+#define CAMERA_SCRIPT_INCLUDED
+
+#include <vector>
+
+#include "Scene.hpp"
+
+#define CAMERA_SCRIPT_LOOKAHEAD 1.5f		// Cells ahead along the route the camera faces
+
+// A camera path that is the same on every run, for headless benchmarks:
+// the shortest route from the start to the level's goal, or a full turn on
+// the spot when there is no goal or no route to it
+class CameraScript {
+public:
+	void Init(const TileGrid &level, const Player &start);
+
+	// Pose at t from 0 to 1 along the path
+	Player At(double t) const;
+
+	// Route length in cells, 0 while turning on the spot
+	float Length() const { return m_length.empty() ? 0.f : m_length.back(); }
+
+private:
+	void PointAt(float s, float &x, float &y) const;
+
+	Player				m_start;
+	std::vector<float>	m_points;		// x, y pairs
+	std::vector<float>	m_length;		// Along the route up to each point
+};
+
+#endif
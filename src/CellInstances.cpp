@@ -0,0 +1,18 @@
+#include "CellInstances.hpp"
+
+void BuildCellInstances(const TileGrid &level, const std::vector<CellSpan> &spans, std::vector<InstanceData> &cubes,
+	std::vector<InstanceData> &keys) {
+	for(const CellSpan &span : spans) {
+		for(int x = span.x0; x < span.x1; x++) {
+			int tile = level.At(x, span.y);
+			if(tile == LEVEL_WALL) {
+				cubes.push_back({ { (float)x, (float)span.y, 0.f }, { 1.f, 1.f, 1.f } });
+			}
+			else if(tile == LEVEL_KEY) {
+				keys.push_back({ { (float)x, (float)span.y, 0.f }, { 0.f, 1.f, 0.f } });
+			}
+
+			cubes.push_back({ { (float)x, (float)span.y, -1.f }, { 0.1f, 0.1f, 0.1f } });
+		}
+	}
+}
@@ -0,0 +1,21 @@
+#ifndef CELL_INSTANCES_INCLUDED
+#define CELL_INSTANCES_INCLUDED
+
+#include <vector>
+
+#include "GridCuller.hpp"
+#include "TileGrid.hpp"
+
+// Per-instance attributes, matching instanceOffset/inColor in vertex.glsl
+struct InstanceData {
+	float	offset[3];
+	float	color[3];
+};
+
+// The instances that draw the cells of spans: a floor cube under every
+// cell, plus a wall cube on walls and a key on keys
+// Appends to cubes and keys
+void BuildCellInstances(const TileGrid &level, const std::vector<CellSpan> &spans, std::vector<InstanceData> &cubes,
+	std::vector<InstanceData> &keys);
+
+#endif
@@ -0,0 +1,196 @@
+#include "Collision.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+bool SweepCircleCell(float x, float y, float radius, float dx, float dy, int cellX, int cellY, SweepHit &hit) {
+	float minX = cellX - 0.5f, maxX = cellX + 0.5f;
+	float minY = cellY - 0.5f, maxY = cellY + 0.5f;
+
+	// Already touching, only moving further in counts
+	float cx = std::max(minX, std::min(x, maxX));
+	float cy = std::max(minY, std::min(y, maxY));
+	float ox = x - cx, oy = y - cy;
+	float dist2 = ox * ox + oy * oy;
+	if(dist2 <= radius * radius) {
+		float nx, ny;
+		if(dist2 > 0.f) {
+			float dist = sqrtf(dist2);
+			nx = ox / dist;
+			ny = oy / dist;
+		}
+		else {
+			// Centre inside the cell, out through the nearest side
+			float left = x - minX, right = maxX - x, down = y - minY, up = maxY - y;
+			float nearest = std::min(std::min(left, right), std::min(down, up));
+			nx = nearest == left ? -1.f : nearest == right ? 1.f : 0.f;
+			ny = nx != 0.f ? 0.f : nearest == down ? -1.f : 1.f;
+		}
+		if(dx * nx + dy * ny >= 0.f || hit.t <= 0.f) {
+			return false;
+		}
+		hit = { true, 0.f, nx, ny };
+		return true;
+	}
+
+	// Slabs of the cell grown by the radius
+	float tEnter = 0.f, tExit = hit.t;
+	float enterNx = 0.f, enterNy = 0.f;
+	if(dx != 0.f) {
+		float inv = 1.f / dx;
+		float t0 = (minX - radius - x) * inv, t1 = (maxX + radius - x) * inv;
+		float n = -1.f;
+		if(t0 > t1) {
+			std::swap(t0, t1);
+			n = 1.f;
+		}
+		if(t0 > tEnter) {
+			tEnter = t0;
+			enterNx = n;
+			enterNy = 0.f;
+		}
+		tExit = std::min(tExit, t1);
+	}
+	else if(x < minX - radius || x > maxX + radius) {
+		return false;
+	}
+	if(dy != 0.f) {
+		float inv = 1.f / dy;
+		float t0 = (minY - radius - y) * inv, t1 = (maxY + radius - y) * inv;
+		float n = -1.f;
+		if(t0 > t1) {
+			std::swap(t0, t1);
+			n = 1.f;
+		}
+		if(t0 > tEnter) {
+			tEnter = t0;
+			enterNx = 0.f;
+			enterNy = n;
+		}
+		tExit = std::min(tExit, t1);
+	}
+	else if(y < minY - radius || y > maxY + radius) {
+		return false;
+	}
+	if(tEnter > tExit) {
+		return false;
+	}
+
+	// Entering the grown box past a corner means the rounded corner is hit, if
+	// at all; starting inside the grown box without touching is such a case
+	float px = x + dx * tEnter, py = y + dy * tEnter;
+	if((px < minX || px > maxX) && (py < minY || py > maxY)) {
+		float cornerX = px < minX ? minX : maxX;
+		float cornerY = py < minY ? minY : maxY;
+		float fx = x - cornerX, fy = y - cornerY;
+		float a = dx * dx + dy * dy;
+		float b = fx * dx + fy * dy;
+		float c = fx * fx + fy * fy - radius * radius;
+		float disc = b * b - a * c;
+		if(disc < 0.f) {
+			return false;
+		}
+		float t = (-b - sqrtf(disc)) / a;
+		if(t < 0.f || t >= hit.t) {
+			return false;
+		}
+		hit = { true, t, (fx + dx * t) / radius, (fy + dy * t) / radius };
+		return true;
+	}
+
+	if(tEnter >= hit.t || (enterNx == 0.f && enterNy == 0.f)) {
+		return false;
+	}
+	hit = { true, tEnter, enterNx, enterNy };
+	return true;
+}
+
+bool SweepCircle(const TileGrid &level, float x, float y, float radius, float dx, float dy, SweepHit &hit, CollisionStats &stats) {
+	stats.queries++;
+	hit = SweepHit();
+
+	// Cell i covers [i - 0.5, i + 0.5), walk in coordinates shifted to [i, i + 1)
+	float ux = x + 0.5f, uy = y + 0.5f;
+	int cellX = (int)floorf(ux), cellY = (int)floorf(uy);
+	int endX = (int)floorf(ux + dx), endY = (int)floorf(uy + dy);
+
+	int stepX = dx > 0.f ? 1 : -1;
+	int stepY = dy > 0.f ? 1 : -1;
+	float deltaX = dx != 0.f ? fabsf(1.f / dx) : INFINITY;
+	float deltaY = dy != 0.f ? fabsf(1.f / dy) : INFINITY;
+	float nextX = dx != 0.f ? (dx > 0.f ? cellX + 1 - ux : ux - cellX) * deltaX : INFINITY;
+	float nextY = dy != 0.f ? (dy > 0.f ? cellY + 1 - uy : uy - cellY) * deltaY : INFINITY;
+
+	auto test = [&](int cx, int cy) {
+		if(level.IsWall(cx, cy)) {
+			stats.wallsTested++;
+			SweepCircleCell(x, y, radius, dx, dy, cx, cy, hit);
+		}
+	};
+
+	// The circle only reaches the 3x3 cells around the one its centre is in,
+	// each step of the walk slides that window by a row or column
+	stats.cellsVisited++;
+	for(int j = -1; j <= 1; j++) {
+		for(int i = -1; i <= 1; i++) {
+			test(cellX + i, cellY + j);
+		}
+	}
+
+	// Every wall touched before the best hit is next to a cell entered before it
+	while(cellX != endX || cellY != endY) {
+		float tEnter = std::min(nextX, nextY);
+		if(tEnter > hit.t || tEnter > 1.f) {
+			break;
+		}
+		stats.cellsVisited++;
+		if(nextX < nextY) {
+			cellX += stepX;
+			nextX += deltaX;
+			for(int j = -1; j <= 1; j++) {
+				test(cellX + stepX, cellY + j);
+			}
+		}
+		else {
+			cellY += stepY;
+			nextY += deltaY;
+			for(int i = -1; i <= 1; i++) {
+				test(cellX + i, cellY + stepY);
+			}
+		}
+	}
+
+	stats.hits += hit.hit;
+	return hit.hit;
+}
+
+void MoveCircle(const TileGrid &level, Vec3f &origin, Vec3f &vel, float radius, float dt, CollisionStats &stats) {
+	float dx = vel.x * dt, dy = vel.y * dt;
+	origin.z += vel.z * dt;
+
+	for(int slide = 0; slide < COLLISION_MAX_SLIDES && (dx != 0.f || dy != 0.f); slide++) {
+		SweepHit hit;
+		if(!SweepCircle(level, origin.x, origin.y, radius, dx, dy, hit, stats)) {
+			origin.x += dx;
+			origin.y += dy;
+			return;
+		}
+
+		// Stop at the wall, backed off along the normal, then slide the rest along it
+		origin.x += dx * hit.t + hit.nx * COLLISION_SKIN;
+		origin.y += dy * hit.t + hit.ny * COLLISION_SKIN;
+
+		float rest = 1.f - hit.t;
+		dx *= rest;
+		dy *= rest;
+		float into = dx * hit.nx + dy * hit.ny;
+		dx -= hit.nx * into;
+		dy -= hit.ny * into;
+
+		float velInto = vel.x * hit.nx + vel.y * hit.ny;
+		if(velInto < 0.f) {
+			vel.x -= hit.nx * velInto;
+			vel.y -= hit.ny * velInto;
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef COLLISION_INCLUDED
+#define COLLISION_INCLUDED
+
+#include "Math.hpp"
+#include "TileGrid.hpp"
+
+#define PLAYER_RADIUS 0.25f
+#define COLLISION_SKIN 1e-3f		// Gap kept to walls so rounding never starts a sweep inside one
+#define COLLISION_MAX_SLIDES 3
+
+// Earliest contact of a sweep, t is the fraction of the motion before it
+struct SweepHit {
+	bool	hit = false;
+	float	t = 1.f;
+	float	nx = 0.f;			// Wall normal at the contact
+	float	ny = 0.f;
+};
+
+struct CollisionStats {
+	long long	queries = 0;
+	long long	cellsVisited = 0;	// Along the path of the centre
+	long long	wallsTested = 0;
+	long long	hits = 0;
+};
+
+// Wall cells are unit squares centred on their coordinates, circles have a
+// radius below half a cell and only move in the xy plane
+
+// Sweeps a circle from (x, y) by (dx, dy) against one wall cell, keeps the
+// earlier of hit and the contact
+// A circle already touching the cell only hits it when moving further in
+bool SweepCircleCell(float x, float y, float radius, float dx, float dy, int cellX, int cellY, SweepHit &hit);
+
+// Same against every wall of the level, walking the cells along the path of
+// the centre with a grid DDA, so the cost is in the cells crossed rather
+// than the size of the level
+bool SweepCircle(const TileGrid &level, float x, float y, float radius, float dx, float dy, SweepHit &hit, CollisionStats &stats);
+
+// Moves origin by vel * dt, sliding along the walls it hits
+// The part of vel going into a wall is removed
+void MoveCircle(const TileGrid &level, Vec3f &origin, Vec3f &vel, float radius, float dt, CollisionStats &stats);
+
+#endif
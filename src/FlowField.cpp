@@ -0,0 +1,259 @@
+#include "FlowField.hpp"
+
+#include <algorithm>
+#include <functional>
+
+static const int flowSteps[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+void FlowField::Init(const TileGrid *level, int threads) {
+	m_level = level;
+	m_width = level->width;
+	m_height = level->height;
+	m_pool.Start(threads);
+	m_next.assign(m_pool.NumThreads(), std::vector<uint32_t>());
+
+	size_t cells = (size_t)m_width * m_height;
+	size_t words = (cells + 63) / 64;
+	m_distance.assign(cells, FLOW_UNREACHABLE);
+	m_direction.assign(cells, FLOW_NONE);
+	m_blocked.assign(words, 0);
+	m_openDoors.assign(words, 0);
+	m_visited.reset(new std::atomic<uint64_t>[words]);
+
+	for(int y = 0; y < m_height; y++) {
+		for(int x = 0; x < m_width; x++) {
+			int tile = level->At(x, y);
+			if(tile == LEVEL_WALL || tile == LEVEL_DOOR) {
+				SetBlocked(Index(x, y), true);
+			}
+		}
+	}
+}
+
+void FlowField::SetBlocked(size_t cell, bool blocked) {
+	if(blocked) {
+		m_blocked[cell >> 6] |= 1ull << (cell & 63);
+	}
+	else {
+		m_blocked[cell >> 6] &= ~(1ull << (cell & 63));
+	}
+}
+
+void FlowField::Build() {
+	std::vector<PathCell> goals;
+	for(int y = 0; y < m_height; y++) {
+		for(int x = 0; x < m_width; x++) {
+			if(m_level->At(x, y) == LEVEL_GOAL) {
+				goals.push_back({ x, y });
+			}
+		}
+	}
+	Build(goals);
+}
+
+void FlowField::Build(const std::vector<PathCell> &goals) {
+	size_t cells = m_distance.size();
+	std::fill(m_distance.begin(), m_distance.end(), FLOW_UNREACHABLE);
+	for(size_t i = 0; i < m_blocked.size(); i++) {
+		m_visited[i].store(m_blocked[i], std::memory_order_relaxed);
+	}
+
+	m_frontier.clear();
+	for(const PathCell &goal : goals) {
+		if(Blocked(goal.x, goal.y)) {
+			continue;
+		}
+		size_t cell = Index(goal.x, goal.y);
+		if(!(m_visited[cell >> 6].fetch_or(1ull << (cell & 63), std::memory_order_relaxed) & (1ull << (cell & 63)))) {
+			m_distance[cell] = 0;
+			m_frontier.push_back((uint32_t)cell);
+		}
+	}
+
+	// One BFS level at a time, each split over the workers when it is wide enough
+	uint32_t distance = 0;
+	while(!m_frontier.empty()) {
+		ExpandFrontier(++distance);
+	}
+	levels = distance ? distance - 1 : 0;
+
+	// Directions only depend on the distances, so they come out the same for any thread count
+	const int grain = 1 << 16;
+	m_pool.Run((int)((cells + grain - 1) / grain), 1, [&](int begin, int end, int) {
+		PickDirections((size_t)begin * grain, std::min(cells, (size_t)end * grain));
+	});
+}
+
+void FlowField::ExpandFrontier(uint32_t distance) {
+	auto expand = [&](int begin, int end, int worker) {
+		std::vector<uint32_t> &next = m_next[worker];
+		for(int i = begin; i < end; i++) {
+			uint32_t cell = m_frontier[i];
+			int x = cell % m_width, y = cell / m_width;
+			for(const int *step : flowSteps) {
+				int nx = x + step[0], ny = y + step[1];
+				if(!m_level->InBounds(nx, ny)) {
+					continue;
+				}
+				size_t n = Index(nx, ny);
+				uint64_t bit = 1ull << (n & 63);
+				if(m_visited[n >> 6].load(std::memory_order_relaxed) & bit) {
+					continue;
+				}
+				if(!(m_visited[n >> 6].fetch_or(bit, std::memory_order_relaxed) & bit)) {
+					m_distance[n] = distance;
+					next.push_back((uint32_t)n);
+				}
+			}
+		}
+	};
+
+	int count = (int)m_frontier.size();
+	if(count < FLOW_SERIAL_FRONTIER || m_pool.NumThreads() == 1) {
+		expand(0, count, 0);
+	}
+	else {
+		m_pool.Run(count, FLOW_SERIAL_FRONTIER / 4, expand);
+	}
+
+	m_frontier.clear();
+	for(std::vector<uint32_t> &next : m_next) {
+		m_frontier.insert(m_frontier.end(), next.begin(), next.end());
+		next.clear();
+	}
+}
+
+uint8_t FlowField::PickDirection(size_t cell) const {
+	uint32_t distance = m_distance[cell];
+	if(distance == FLOW_UNREACHABLE) {
+		return FLOW_NONE;
+	}
+	if(distance == 0) {
+		return FLOW_GOAL;
+	}
+	int x = cell % m_width, y = cell / m_width;
+	for(int i = 0; i < 4; i++) {
+		int nx = x + flowSteps[i][0], ny = y + flowSteps[i][1];
+		if(m_level->InBounds(nx, ny) && m_distance[Index(nx, ny)] == distance - 1) {
+			return FLOW_POS_X + i;
+		}
+	}
+	return FLOW_NONE;
+}
+
+void FlowField::PickDirections(size_t begin, size_t end) {
+	for(size_t cell = begin; cell < end; cell++) {
+		m_direction[cell] = PickDirection(cell);
+	}
+}
+
+bool FlowField::DoorOpen(int x, int y) const {
+	if(!m_level->InBounds(x, y)) {
+		return false;
+	}
+	size_t cell = Index(x, y);
+	return (m_openDoors[cell >> 6] >> (cell & 63)) & 1;
+}
+
+int FlowField::SetDoor(int x, int y, bool open) {
+	if(!m_level->InBounds(x, y) || m_level->At(x, y) != LEVEL_DOOR || DoorOpen(x, y) == open) {
+		return 0;
+	}
+	size_t door = Index(x, y);
+	if(open) {
+		m_openDoors[door >> 6] |= 1ull << (door & 63);
+	}
+	else {
+		m_openDoors[door >> 6] &= ~(1ull << (door & 63));
+	}
+	SetBlocked(door, !open);
+
+	// Distances can only drop when a door opens, and only rise behind one
+	// that closes: the cells whose path ran through it, its subtree in the
+	// field, lose their distance and get it back from the cells around them
+	m_affected.clear();
+	m_queue.clear();
+	if(open) {
+		m_affected.push_back((uint32_t)door);
+	}
+	else {
+		m_distance[door] = FLOW_UNREACHABLE;
+		m_affected.push_back((uint32_t)door);
+		for(size_t i = 0; i < m_affected.size(); i++) {
+			uint32_t cell = m_affected[i];
+			int cx = cell % m_width, cy = cell / m_width;
+			for(int d = 0; d < 4; d++) {
+				int nx = cx - flowSteps[d][0], ny = cy - flowSteps[d][1];
+				if(!m_level->InBounds(nx, ny)) {
+					continue;
+				}
+				size_t n = Index(nx, ny);
+				if(m_direction[n] == FLOW_POS_X + d && m_distance[n] != FLOW_UNREACHABLE) {
+					m_distance[n] = FLOW_UNREACHABLE;
+					m_affected.push_back((uint32_t)n);
+				}
+			}
+		}
+	}
+
+	// Seed from the settled cells next to the affected ones, then relax in
+	// order of distance, the same as the BFS would have
+	for(uint32_t cell : m_affected) {
+		if(Blocked(cell % m_width, cell / m_width)) {
+			continue;
+		}
+		int cx = cell % m_width, cy = cell / m_width;
+		uint32_t best = FLOW_UNREACHABLE;
+		for(const int *step : flowSteps) {
+			uint32_t d = Distance(cx + step[0], cy + step[1]);
+			best = std::min(best, d == FLOW_UNREACHABLE ? d : d + 1);
+		}
+		if(best < m_distance[cell]) {
+			m_distance[cell] = best;
+			m_queue.push_back((uint64_t)best << 32 | cell);
+		}
+	}
+	std::make_heap(m_queue.begin(), m_queue.end(), std::greater<uint64_t>());
+
+	int changed = open ? 0 : (int)m_affected.size();
+	while(!m_queue.empty()) {
+		std::pop_heap(m_queue.begin(), m_queue.end(), std::greater<uint64_t>());
+		uint64_t entry = m_queue.back();
+		m_queue.pop_back();
+		uint32_t cell = (uint32_t)entry, distance = (uint32_t)(entry >> 32);
+		if(distance != m_distance[cell]) {
+			continue;
+		}
+		if(open) {
+			m_affected.push_back(cell);
+			changed++;
+		}
+
+		int cx = cell % m_width, cy = cell / m_width;
+		for(const int *step : flowSteps) {
+			int nx = cx + step[0], ny = cy + step[1];
+			if(Blocked(nx, ny)) {
+				continue;
+			}
+			size_t n = Index(nx, ny);
+			if(distance + 1 < m_distance[n]) {
+				m_distance[n] = distance + 1;
+				m_queue.push_back((uint64_t)(distance + 1) << 32 | n);
+				std::push_heap(m_queue.begin(), m_queue.end(), std::greater<uint64_t>());
+			}
+		}
+	}
+
+	// A changed cell can become the first choice of a neighbour too
+	for(uint32_t cell : m_affected) {
+		int cx = cell % m_width, cy = cell / m_width;
+		m_direction[cell] = PickDirection(cell);
+		for(const int *step : flowSteps) {
+			int nx = cx + step[0], ny = cy + step[1];
+			if(m_level->InBounds(nx, ny)) {
+				m_direction[Index(nx, ny)] = PickDirection(Index(nx, ny));
+			}
+		}
+	}
+	return changed;
+}
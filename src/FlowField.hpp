@@ -0,0 +1,93 @@
+#ifndef FLOW_FIELD_INCLUDED
+#define FLOW_FIELD_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "JobPool.hpp"
+#include "Pathfind.hpp"
+#include "TileGrid.hpp"
+
+// Step to take from a cell towards the nearest goal
+enum FlowDirection {
+	FLOW_NONE,			// Blocked, or no goal can be reached
+	FLOW_GOAL,
+	FLOW_POS_X,
+	FLOW_NEG_X,
+	FLOW_POS_Y,
+	FLOW_NEG_Y
+};
+
+#define FLOW_UNREACHABLE 0xffffffffu
+#define FLOW_SERIAL_FRONTIER 4096		// Smaller BFS levels are not worth splitting up
+
+// Distance in steps to the nearest goal cell and the direction towards it
+// for every cell of a level, from a multi-source BFS over the four
+// neighbours; walls and closed doors block
+// Doors start closed, SetDoor updates only the cells whose distance changes
+class FlowField {
+public:
+	FlowField() {}
+
+	// level is only read, and has to outlive the field; 0 threads uses every core
+	void Init(const TileGrid *level, int threads);
+
+	// Every LEVEL_GOAL cell, or the given cells
+	void Build();
+	void Build(const std::vector<PathCell> &goals);
+
+	// Opens or closes the door at (x, y) and repairs the field around it
+	// Returns the number of cells recomputed
+	int SetDoor(int x, int y, bool open);
+	bool DoorOpen(int x, int y) const;
+
+	uint32_t Distance(int x, int y) const {
+		return m_level->InBounds(x, y) ? m_distance[Index(x, y)] : FLOW_UNREACHABLE;
+	}
+
+	FlowDirection Direction(int x, int y) const {
+		return m_level->InBounds(x, y) ? (FlowDirection)m_direction[Index(x, y)] : FLOW_NONE;
+	}
+
+	bool Blocked(int x, int y) const {
+		return !m_level->InBounds(x, y) || ((m_blocked[Index(x, y) >> 6] >> (Index(x, y) & 63)) & 1);
+	}
+
+	int NumThreads() const { return m_pool.NumThreads(); }
+
+	// Deepest BFS level of the last Build
+	int		levels = 0;
+
+private:
+	size_t Index(int x, int y) const { return (size_t)y * m_width + x; }
+
+	void SetBlocked(size_t cell, bool blocked);
+	void ExpandFrontier(uint32_t distance);
+
+	// First neighbour one step closer, in +x, -x, +y, -y order
+	uint8_t PickDirection(size_t cell) const;
+	void PickDirections(size_t begin, size_t end);
+
+	const TileGrid				*m_level = nullptr;
+	int							m_width = 0;
+	int							m_height = 0;
+	JobPool						m_pool;
+
+	std::vector<uint32_t>		m_distance;
+	std::vector<uint8_t>		m_direction;
+	std::vector<uint64_t>		m_blocked;		// Walls and closed doors, one bit per cell
+	std::vector<uint64_t>		m_openDoors;
+
+	// BFS state; visited bits are claimed atomically by the workers
+	std::unique_ptr<std::atomic<uint64_t>[]>	m_visited;
+	std::vector<uint32_t>		m_frontier;
+	std::vector<std::vector<uint32_t>>	m_next;		// Per worker
+
+	// SetDoor scratch
+	std::vector<uint32_t>		m_affected;
+	std::vector<uint64_t>		m_queue;
+};
+
+#endif
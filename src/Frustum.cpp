@@ -0,0 +1,49 @@
+#include "Frustum.hpp"
+
+#include <cmath>
+
+void Frustum::Extract(const float *viewProj) {
+	// Row i of the matrix, stored column-major
+	auto row = [&](int i, int j) {
+		return viewProj[j * 4 + i];
+	};
+
+	// Left, right, bottom, top, near, far: row 3 plus or minus rows 0, 1, 2
+	for(int i = 0; i < 6; i++) {
+		int axis = i / 2;
+		float sign = (i & 1) ? -1.f : 1.f;
+
+		FrustumPlane &plane = planes[i];
+		plane.a = row(3, 0) + sign * row(axis, 0);
+		plane.b = row(3, 1) + sign * row(axis, 1);
+		plane.c = row(3, 2) + sign * row(axis, 2);
+		plane.d = row(3, 3) + sign * row(axis, 3);
+
+		float length = sqrtf(plane.a * plane.a + plane.b * plane.b + plane.c * plane.c);
+		plane.a /= length;
+		plane.b /= length;
+		plane.c /= length;
+		plane.d /= length;
+	}
+}
+
+CullResult Frustum::TestBox(const float *boxMin, const float *boxMax) const {
+	CullResult result = CULL_INSIDE;
+	for(const FrustumPlane &plane : planes) {
+		// Corners furthest along and against the plane normal
+		float px = plane.a >= 0.f ? boxMax[0] : boxMin[0];
+		float py = plane.b >= 0.f ? boxMax[1] : boxMin[1];
+		float pz = plane.c >= 0.f ? boxMax[2] : boxMin[2];
+		if(plane.a * px + plane.b * py + plane.c * pz + plane.d < 0.f) {
+			return CULL_OUTSIDE;
+		}
+
+		float nx = plane.a >= 0.f ? boxMin[0] : boxMax[0];
+		float ny = plane.b >= 0.f ? boxMin[1] : boxMax[1];
+		float nz = plane.c >= 0.f ? boxMin[2] : boxMax[2];
+		if(plane.a * nx + plane.b * ny + plane.c * nz + plane.d < 0.f) {
+			result = CULL_INTERSECT;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,29 @@
+#ifndef FRUSTUM_INCLUDED
+#define FRUSTUM_INCLUDED
+
+enum CullResult {
+	CULL_OUTSIDE,
+	CULL_INTERSECT,
+	CULL_INSIDE
+};
+
+// Plane ax + by + cz + d = 0 with a unit normal pointing into the frustum
+struct FrustumPlane {
+	float a, b, c, d;
+};
+
+// View frustum as six planes, extracted from a view-projection matrix
+class Frustum {
+public:
+	Frustum() {}
+
+	// viewProj is column-major, as glm stores it (Gribb/Hartmann extraction)
+	void Extract(const float *viewProj);
+
+	// Tests an axis-aligned box against every plane
+	CullResult TestBox(const float *boxMin, const float *boxMax) const;
+
+	FrustumPlane planes[6];
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "GridCuller.hpp"
+
+static void CellRangeBox(const GridCullBounds &bounds, int x0, int y0, int x1, int y1, float *boxMin, float *boxMax) {
+	boxMin[0] = x0 - 0.5f;
+	boxMin[1] = y0 - 0.5f;
+	boxMin[2] = bounds.zMin;
+	boxMax[0] = x1 - 0.5f;
+	boxMax[1] = y1 - 0.5f;
+	boxMax[2] = bounds.zMax;
+}
+
+static void AcceptRange(int x0, int y0, int x1, int y1, std::vector<CellSpan> &spans, CullStats &stats) {
+	for(int y = y0; y < y1; y++) {
+		spans.push_back({ y, x0, x1 });
+	}
+	stats.cellsVisible += (x1 - x0) * (y1 - y0);
+}
+
+// Straddling leaf: test each cell and merge runs of visible cells
+static void CullLeaf(const Frustum &frustum, const GridCullBounds &bounds, int x0, int y0, int x1, int y1,
+	std::vector<CellSpan> &spans, CullStats &stats) {
+	float boxMin[3], boxMax[3];
+	for(int y = y0; y < y1; y++) {
+		int runStart = -1;
+		for(int x = x0; x < x1; x++) {
+			CellRangeBox(bounds, x, y, x + 1, y + 1, boxMin, boxMax);
+			bool visible = frustum.TestBox(boxMin, boxMax) != CULL_OUTSIDE;
+			if(visible && runStart < 0) {
+				runStart = x;
+			}
+			else if(!visible && runStart >= 0) {
+				spans.push_back({ y, runStart, x });
+				runStart = -1;
+			}
+			stats.cellsVisible += visible;
+			stats.cellsCulled += !visible;
+		}
+		if(runStart >= 0) {
+			spans.push_back({ y, runStart, x1 });
+		}
+	}
+	stats.cellsTested += (x1 - x0) * (y1 - y0);
+}
+
+static void CullNode(const Frustum &frustum, const GridCullBounds &bounds, int x0, int y0, int x1, int y1,
+	std::vector<CellSpan> &spans, CullStats &stats) {
+	float boxMin[3], boxMax[3];
+	CellRangeBox(bounds, x0, y0, x1, y1, boxMin, boxMax);
+	stats.nodesTested++;
+
+	CullResult result = frustum.TestBox(boxMin, boxMax);
+	if(result == CULL_OUTSIDE) {
+		stats.cellsCulled += (x1 - x0) * (y1 - y0);
+		return;
+	}
+	if(result == CULL_INSIDE) {
+		AcceptRange(x0, y0, x1, y1, spans, stats);
+		return;
+	}
+
+	int w = x1 - x0, h = y1 - y0;
+	if(w <= GRID_CULL_LEAF_SIZE && h <= GRID_CULL_LEAF_SIZE) {
+		CullLeaf(frustum, bounds, x0, y0, x1, y1, spans, stats);
+		return;
+	}
+
+	// Split the long sides in half, keeping nodes roughly square
+	int mx = w > GRID_CULL_LEAF_SIZE ? x0 + w / 2 : x1;
+	int my = h > GRID_CULL_LEAF_SIZE ? y0 + h / 2 : y1;
+
+	CullNode(frustum, bounds, x0, y0, mx, my, spans, stats);
+	if(mx < x1) {
+		CullNode(frustum, bounds, mx, y0, x1, my, spans, stats);
+	}
+	if(my < y1) {
+		CullNode(frustum, bounds, x0, my, mx, y1, spans, stats);
+		if(mx < x1) {
+			CullNode(frustum, bounds, mx, my, x1, y1, spans, stats);
+		}
+	}
+}
+
+void CullGrid(const Frustum &frustum, const GridCullBounds &bounds, int x0, int y0, int x1, int y1,
+	std::vector<CellSpan> &spans, CullStats &stats) {
+	if(x0 >= x1 || y0 >= y1) {
+		return;
+	}
+	CullNode(frustum, bounds, x0, y0, x1, y1, spans, stats);
+}
@@ -0,0 +1,48 @@
+#ifndef GRID_CULLER_INCLUDED
+#define GRID_CULLER_INCLUDED
+
+#include <vector>
+
+#include "Frustum.hpp"
+
+// Nodes at most this many cells across are tested cell by cell
+#define GRID_CULL_LEAF_SIZE 8
+
+// Visible cells [x0, x1) of row y
+struct CellSpan {
+	int y;
+	int x0;
+	int x1;
+};
+
+struct CullStats {
+	int		nodesTested = 0;		// Boxes tested above cell level
+	int		cellsTested = 0;		// Cells tested individually in straddling leaves
+	int		cellsCulled = 0;
+	int		cellsOccluded = 0;		// Inside the frustum but hidden behind walls
+	int		cellsVisible = 0;
+
+	CullStats &operator+=(const CullStats &other) {
+		nodesTested += other.nodesTested;
+		cellsTested += other.cellsTested;
+		cellsCulled += other.cellsCulled;
+		cellsOccluded += other.cellsOccluded;
+		cellsVisible += other.cellsVisible;
+		return *this;
+	}
+};
+
+// Bounds of the geometry drawn for the grid, cell (x, y) spans x +- 0.5, y +- 0.5
+struct GridCullBounds {
+	float	zMin;
+	float	zMax;
+};
+
+// Culls the cells [x0, x1) x [y0, y1) with an implicit quadtree over cell
+// ranges: nodes fully inside the frustum are accepted whole, nodes fully
+// outside are dropped whole, and only straddling leaves test single cells
+// Appends the visible row spans to spans
+void CullGrid(const Frustum &frustum, const GridCullBounds &bounds, int x0, int y0, int x1, int y1,
+	std::vector<CellSpan> &spans, CullStats &stats);
+
+#endif
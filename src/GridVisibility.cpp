@@ -0,0 +1,182 @@
+#include "GridVisibility.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// World offset of octant cell (row, col) is (row * xx + col * xy, row * yx + col * yy)
+// Rows run away from the eye along one axis, columns cover slopes 0 to 1 of the other
+static const int octantMul[8][4] = {
+	{ 1, 0, 0, 1 },
+	{ 1, 0, 0, -1 },
+	{ -1, 0, 0, 1 },
+	{ -1, 0, 0, -1 },
+	{ 0, 1, 1, 0 },
+	{ 0, -1, 1, 0 },
+	{ 0, 1, -1, 0 },
+	{ 0, -1, -1, 0 }
+};
+
+void GridVisibility::Compute(const TileGrid &level, float eyeX, float eyeY, int radius) {
+	m_level = &level;
+	m_eyeX = (int)floorf(eyeX + 0.5f);
+	m_eyeY = (int)floorf(eyeY + 0.5f);
+	m_fracX = eyeX - m_eyeX;
+	m_fracY = eyeY - m_eyeY;
+	m_radius = radius;
+
+	Reset(m_eyeX - radius, m_eyeY - radius, 2 * radius + 1);
+
+	Mark(m_eyeX, m_eyeY);
+	for(int octant = 0; octant < 8; octant++) {
+		CastOctant(octant, 1, 0.f, 1.f);
+	}
+}
+
+void GridVisibility::Reset(int originX, int originY, int size) {
+	if(size != m_size) {
+		m_size = size;
+		m_stamps.assign((size_t)size * size, 0);
+		m_stamp = 0;
+	}
+	if(++m_stamp == 0) {
+		std::fill(m_stamps.begin(), m_stamps.end(), 0);
+		m_stamp = 1;
+	}
+	m_originX = originX;
+	m_originY = originY;
+
+	numVisible = 0;
+	cellsVisited = 0;
+}
+
+void GridVisibility::MarkRow(int y, int x0, int x1) {
+	int wy = y - m_originY;
+	x0 = std::max(x0, m_originX);
+	x1 = std::min(x1, m_originX + m_size);
+	if((unsigned)wy >= (unsigned)m_size) {
+		return;
+	}
+	uint32_t *stamps = &m_stamps[(size_t)wy * m_size];
+	for(int x = x0; x < x1; x++) {
+		uint32_t &stamp = stamps[x - m_originX];
+		if(stamp != m_stamp) {
+			stamp = m_stamp;
+			numVisible++;
+		}
+	}
+}
+
+void GridVisibility::Mark(int x, int y) {
+	if(!m_level->InBounds(x, y)) {
+		return;
+	}
+	int wx = x - m_originX, wy = y - m_originY;
+	if((unsigned)wx >= (unsigned)m_size || (unsigned)wy >= (unsigned)m_size) {
+		return;
+	}
+	uint32_t &stamp = m_stamps[(size_t)wy * m_size + wx];
+	if(stamp != m_stamp) {
+		stamp = m_stamp;
+		numVisible++;
+	}
+}
+
+// Scans rows outward while [start, end] of the octant's slopes is still lit
+// Each wall shadows the slopes of every ray that crosses its square, and the
+// lit run before it continues in a recursive scan
+void GridVisibility::CastOctant(int octant, int row, float start, float end) {
+	const int *mul = octantMul[octant];
+
+	// Eye offset from its cell centre, along the rows and the columns
+	float eyeRow = m_fracX * mul[0] + m_fracY * mul[2];
+	float eyeCol = m_fracX * mul[1] + m_fracY * mul[3];
+
+	for(int d = row; d <= m_radius && start < end; d++) {
+		float nearEdge = std::max(d - 0.5f - eyeRow, 1e-4f);
+		float farEdge = d + 0.5f - eyeRow;
+
+		int cMin = (int)floorf(start * nearEdge + eyeCol - 0.5f);
+		int cMax = (int)ceilf(end * farEdge + eyeCol + 0.5f);
+
+		bool blocked = false;
+		float openStart = start;
+		float shadowEnd = start;
+		for(int c = cMin; c <= cMax; c++) {
+			float left = c - 0.5f - eyeCol;
+			float right = c + 0.5f - eyeCol;
+			float minSlope = left >= 0.f ? left / farEdge : left / nearEdge;
+			float maxSlope = right >= 0.f ? right / nearEdge : right / farEdge;
+			if(maxSlope <= start || minSlope >= end) {
+				continue;
+			}
+
+			int x = m_eyeX + d * mul[0] + c * mul[1];
+			int y = m_eyeY + d * mul[2] + c * mul[3];
+			cellsVisited++;
+			Mark(x, y);
+
+			if(m_level->IsWall(x, y)) {
+				if(!blocked) {
+					CastOctant(octant, d + 1, openStart, minSlope);
+					blocked = true;
+					shadowEnd = maxSlope;
+				}
+				else {
+					shadowEnd = std::max(shadowEnd, maxSlope);
+				}
+			}
+			else if(blocked) {
+				blocked = false;
+				openStart = shadowEnd;
+			}
+		}
+
+		if(blocked) {
+			return;
+		}
+		start = openStart;
+	}
+}
+
+bool GridVisibility::AnyVisible(int x0, int y0, int x1, int y1) const {
+	x0 = std::max(x0, m_originX);
+	y0 = std::max(y0, m_originY);
+	x1 = std::min(x1, m_originX + m_size);
+	y1 = std::min(y1, m_originY + m_size);
+	for(int y = y0; y < y1; y++) {
+		const uint32_t *stamps = &m_stamps[(size_t)(y - m_originY) * m_size];
+		for(int x = x0; x < x1; x++) {
+			if(stamps[x - m_originX] == m_stamp) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void GridVisibility::FilterSpans(const std::vector<CellSpan> &spans, std::vector<CellSpan> &visible, CullStats &stats) const {
+	for(const CellSpan &span : spans) {
+		int kept = 0;
+		int runStart = -1;
+		int x0 = std::max(span.x0, m_originX);
+		int x1 = std::min(span.x1, m_originX + m_size);
+		for(int x = x0; x < x1; x++) {
+			bool lit = IsVisible(x, span.y);
+			if(lit && runStart < 0) {
+				runStart = x;
+			}
+			else if(!lit && runStart >= 0) {
+				visible.push_back({ span.y, runStart, x });
+				runStart = -1;
+			}
+			kept += lit;
+		}
+		if(runStart >= 0) {
+			visible.push_back({ span.y, runStart, x1 });
+		}
+
+		int occluded = (span.x1 - span.x0) - kept;
+		stats.cellsVisible -= occluded;
+		stats.cellsOccluded += occluded;
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef GRID_VISIBILITY_INCLUDED
+#define GRID_VISIBILITY_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "TileGrid.hpp"
+#include "GridCuller.hpp"
+
+#define VIEW_FAR 10.0f							// Far plane of the camera, in cells
+#define VISIBILITY_RADIUS ((int)VIEW_FAR + 1)	// Cells reachable within the far plane
+
+// Potentially visible cells around an eye inside the maze, found by
+// recursive shadowcasting over the wall bitset in eight octants
+// Walls are treated as occluders of full height, which is exact while the
+// eye is below the wall tops; a cell is kept if any ray from the eye can
+// reach any part of its square, so the set never misses a visible cell
+class GridVisibility {
+public:
+	GridVisibility() {}
+
+	// eyeX/eyeY in grid units (cell (x, y) spans x +- 0.5, y +- 0.5)
+	// Cells further than radius cells away along either axis are never visible
+	void Compute(const TileGrid &level, float eyeX, float eyeY, int radius);
+
+	bool IsVisible(int x, int y) const {
+		int wx = x - m_originX, wy = y - m_originY;
+		if((unsigned)wx >= (unsigned)m_size || (unsigned)wy >= (unsigned)m_size) {
+			return false;
+		}
+		return m_stamps[(size_t)wy * m_size + wx] == m_stamp;
+	}
+
+	// Empties the set and moves its size x size window to start at (originX, originY)
+	void Reset(int originX, int originY, int size);
+
+	// Marks [x0, x1) of row y visible, for sets that were computed offline
+	void MarkRow(int y, int x0, int x1);
+
+	int OriginX() const { return m_originX; }
+	int OriginY() const { return m_originY; }
+	int WindowSize() const { return m_size; }
+
+	// True if any cell of [x0, x1) x [y0, y1) is visible
+	bool AnyVisible(int x0, int y0, int x1, int y1) const;
+
+	// Splits spans down to their visible cells, counting the rest as occluded
+	// The spans must already be counted in stats.cellsVisible, as CullGrid does
+	void FilterSpans(const std::vector<CellSpan> &spans, std::vector<CellSpan> &visible, CullStats &stats) const;
+
+	int		numVisible = 0;
+	int		cellsVisited = 0;
+
+private:
+	void CastOctant(int octant, int row, float start, float end);
+	void Mark(int x, int y);
+
+	const TileGrid	*m_level = nullptr;
+
+	// Eye cell, and the eye's offset from that cell's centre
+	int		m_eyeX = 0;
+	int		m_eyeY = 0;
+	float	m_fracX = 0.f;
+	float	m_fracY = 0.f;
+	int		m_radius = 0;
+
+	// Square window around the eye cell, (2 * radius + 1) cells across after
+	// Compute; a cell is visible when its stamp matches the current one so
+	// nothing is cleared between frames
+	std::vector<uint32_t>	m_stamps;
+	uint32_t				m_stamp = 0;
+	int						m_size = 0;
+	int						m_originX = 0;
+	int						m_originY = 0;
+};
+
+#endif
@@ -0,0 +1,485 @@
+#include "Hpa.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+
+#include "Parallel.hpp"
+#include "Pvs.hpp"
+#include "SceneFile.hpp"
+
+#define HPA_NO_NODE 0xffffffffu
+#define HPA_UNREACHABLE 0xffffffffu
+
+static const int hpaSteps[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+std::string HpaFileName(const char *sceneFile) {
+	return SceneSideFileName(sceneFile, ".hpa");
+}
+
+void Hpa::Resize() {
+	m_width = m_level->width;
+	clustersX = (m_level->width + clusterSize - 1) / clusterSize;
+	clustersY = (m_level->height + clusterSize - 1) / clusterSize;
+
+	// A border holds at most one transition every other cell
+	m_maxNodes = 4 * ((clusterSize + 1) / 2);
+
+	m_clusters.assign(NumClusters(), Cluster());
+	m_startNode = (uint32_t)NumClusters() * m_maxNodes;
+	m_goalNode = m_startNode + 1;
+	m_nodes.assign(m_startNode + 2, Node());
+	m_generation = 0;
+
+	m_refiner.Init(m_level);
+}
+
+void Hpa::Build(const TileGrid *level, int size, int threads) {
+	m_level = level;
+	clusterSize = size;
+	Resize();
+	levelHash = HashLevelWalls(*level);
+
+	threads = ResolveThreadCount(threads);
+	ParallelFor(NumClusters(), threads, [&](int cluster) {
+		CollectNodes(cluster);
+	});
+	ParallelFor(NumClusters(), threads, [&](int cluster) {
+		ComputeDistances(cluster);
+		LinkNodes(cluster);
+	});
+}
+
+int Hpa::NumNodes() const {
+	int count = 0;
+	for(const Cluster &cluster : m_clusters) {
+		count += cluster.cells.size();
+	}
+	return count;
+}
+
+void Hpa::ClusterBounds(int cluster, int &x0, int &y0, int &x1, int &y1) const {
+	x0 = (cluster % clustersX) * clusterSize;
+	y0 = (cluster / clustersX) * clusterSize;
+	x1 = std::min(x0 + clusterSize, m_level->width);
+	y1 = std::min(y0 + clusterSize, m_level->height);
+}
+
+// Nodes on each border in turn, +x, -x, +y then -y, in order along it
+void Hpa::CollectNodes(int cluster) {
+	int x0, y0, x1, y1;
+	ClusterBounds(cluster, x0, y0, x1, y1);
+
+	Cluster &c = m_clusters[cluster];
+	c.cells.clear();
+	auto add = [&](int x, int y) {
+		uint32_t cell = (uint32_t)y * m_width + x;
+		if(std::find(c.cells.begin(), c.cells.end(), cell) == c.cells.end()) {
+			c.cells.push_back(cell);
+		}
+	};
+
+	for(const int *step : hpaSteps) {
+		// Our side of the border, walked along its length
+		bool vertical = step[0] != 0;
+		int fixed = vertical ? (step[0] > 0 ? x1 - 1 : x0) : (step[1] > 0 ? y1 - 1 : y0);
+		int begin = vertical ? y0 : x0, end = vertical ? y1 : x1;
+
+		int runStart = -1;
+		for(int i = begin; i <= end; i++) {
+			int x = vertical ? fixed : i, y = vertical ? i : fixed;
+			bool open = i < end && Walkable(x, y) && Walkable(x + step[0], y + step[1]);
+			if(open && runStart < 0) {
+				runStart = i;
+			}
+			else if(!open && runStart >= 0) {
+				int last = i - 1;
+				if(last - runStart + 1 >= HPA_ENTRANCE_SPLIT) {
+					add(vertical ? fixed : runStart, vertical ? runStart : fixed);
+					add(vertical ? fixed : last, vertical ? last : fixed);
+				}
+				else {
+					int middle = (runStart + last) / 2;
+					add(vertical ? fixed : middle, vertical ? middle : fixed);
+				}
+				runStart = -1;
+			}
+		}
+	}
+}
+
+void Hpa::ClusterDistances(int cluster, int x, int y, std::vector<uint32_t> &distance) const {
+	int x0, y0, x1, y1;
+	ClusterBounds(cluster, x0, y0, x1, y1);
+	int w = x1 - x0, h = y1 - y0;
+
+	// The cluster's walkable cells with a blocked border around them, so
+	// neighbours need no bounds checks
+	int stride = w + 2;
+	thread_local std::vector<uint8_t> open;
+	open.assign((size_t)stride * (h + 2), 0);
+	for(int cy = y0; cy < y1; cy++) {
+		for(int cx = x0; cx < x1; cx++) {
+			open[(cy - y0 + 1) * stride + (cx - x0 + 1)] = !m_level->IsWall(cx, cy);
+		}
+	}
+
+	// Dijkstra with the Pathfinder's moves and costs
+	distance.assign((size_t)w * h, HPA_UNREACHABLE);
+	thread_local std::vector<uint64_t> heap;
+	heap.clear();
+	uint32_t first = (y - y0) * w + (x - x0);
+	distance[first] = 0;
+	heap.push_back(first);
+	while(!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+		uint64_t entry = heap.back();
+		heap.pop_back();
+		uint32_t local = (uint32_t)entry, d = (uint32_t)(entry >> 32);
+		if(d != distance[local]) {
+			continue;
+		}
+		int lx = local % w, ly = local / w;
+		const uint8_t *at = &open[(ly + 1) * stride + lx + 1];
+		for(int dy = -1; dy <= 1; dy++) {
+			for(int dx = -1; dx <= 1; dx++) {
+				if((dx == 0 && dy == 0) || !at[dy * stride + dx]) {
+					continue;
+				}
+				if(dx != 0 && dy != 0 && (!at[dx] || !at[dy * stride])) {
+					continue;
+				}
+				uint32_t n = (ly + dy) * w + (lx + dx);
+				uint32_t nd = d + (dx && dy ? PATH_COST_DIAGONAL : PATH_COST_STRAIGHT);
+				if(nd < distance[n]) {
+					distance[n] = nd;
+					heap.push_back((uint64_t)nd << 32 | n);
+					std::push_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+				}
+			}
+		}
+	}
+}
+
+void Hpa::ComputeDistances(int cluster) {
+	int x0, y0, x1, y1;
+	ClusterBounds(cluster, x0, y0, x1, y1);
+	int w = x1 - x0;
+
+	Cluster &c = m_clusters[cluster];
+	size_t n = c.cells.size();
+	c.distance.assign(n * n, HPA_UNREACHABLE);
+
+	std::vector<uint32_t> distance;
+	for(size_t i = 0; i < n; i++) {
+		ClusterDistances(cluster, c.cells[i] % m_width, c.cells[i] / m_width, distance);
+		for(size_t j = 0; j < n; j++) {
+			int x = c.cells[j] % m_width, y = c.cells[j] / m_width;
+			c.distance[i * n + j] = distance[(y - y0) * w + (x - x0)];
+		}
+	}
+}
+
+void Hpa::LinkNodes(int cluster) {
+	Cluster &c = m_clusters[cluster];
+	c.links.assign(4 * c.cells.size(), HPA_NO_NODE);
+	for(size_t i = 0; i < c.cells.size(); i++) {
+		int x = c.cells[i] % m_width, y = c.cells[i] / m_width;
+		for(int side = 0; side < 4; side++) {
+			int nx = x + hpaSteps[side][0], ny = y + hpaSteps[side][1];
+			if(!m_level->InBounds(nx, ny) || ClusterOf(nx, ny) == cluster) {
+				continue;
+			}
+			int other = ClusterOf(nx, ny);
+			const std::vector<uint32_t> &cells = m_clusters[other].cells;
+			auto it = std::find(cells.begin(), cells.end(), (uint32_t)ny * m_width + nx);
+			if(it != cells.end()) {
+				c.links[4 * i + side] = (uint32_t)other * m_maxNodes + (it - cells.begin());
+			}
+		}
+	}
+}
+
+int Hpa::Update(int x0, int y0, int x1, int y1) {
+	x0 = std::max(0, x0);
+	y0 = std::max(0, y0);
+	x1 = std::min(m_level->width, x1);
+	y1 = std::min(m_level->height, y1);
+	if(x0 >= x1 || y0 >= y1) {
+		return 0;
+	}
+
+	// The touched clusters, then their neighbours for the borders they share,
+	// then one more ring whose links point at renumbered nodes
+	int cx0 = x0 / clusterSize, cy0 = y0 / clusterSize;
+	int cx1 = (x1 - 1) / clusterSize, cy1 = (y1 - 1) / clusterSize;
+	auto forClusters = [&](int grow, const std::function<void(int)> &fn) {
+		for(int cy = std::max(0, cy0 - grow); cy <= std::min(clustersY - 1, cy1 + grow); cy++) {
+			for(int cx = std::max(0, cx0 - grow); cx <= std::min(clustersX - 1, cx1 + grow); cx++) {
+				// Rings are diamonds, diagonal clusters share no border
+				int outX = std::max(cx0 - cx, cx - cx1), outY = std::max(cy0 - cy, cy - cy1);
+				if(std::max(0, outX) + std::max(0, outY) <= grow) {
+					fn(cy * clustersX + cx);
+				}
+			}
+		}
+	};
+
+	int rebuilt = 0;
+	forClusters(1, [&](int cluster) {
+		CollectNodes(cluster);
+		ComputeDistances(cluster);
+		rebuilt++;
+	});
+	forClusters(2, [&](int cluster) {
+		LinkNodes(cluster);
+	});
+	return rebuilt;
+}
+
+uint32_t Hpa::NodeCell(uint32_t node) const {
+	if(node == m_startNode) {
+		return m_startCell;
+	}
+	if(node == m_goalNode) {
+		return m_goalCell;
+	}
+	return m_clusters[node / m_maxNodes].cells[node % m_maxNodes];
+}
+
+void Hpa::Open(uint32_t node, uint64_t g, uint32_t parent) {
+	Node &n = m_nodes[node];
+	uint32_t seen = m_generation << 1;
+	if(n.stamp == seen ? g >= n.g : n.stamp == (seen | 1)) {
+		return;
+	}
+	n.stamp = seen;
+	n.g = g;
+	n.parent = parent;
+
+	uint32_t cell = NodeCell(node);
+	int dx = (int)(cell % m_width) - (int)(m_goalCell % m_width), dy = (int)(cell / m_width) - (int)(m_goalCell / m_width);
+	m_open.push_back({ g + PathDistance(dx, dy), node });
+	std::push_heap(m_open.begin(), m_open.end(), std::greater<PathOpenEntry>());
+}
+
+bool Hpa::Find(int startX, int startY, int goalX, int goalY, std::vector<PathCell> &path) {
+	stats.queries++;
+	path.clear();
+	if(!Walkable(startX, startY) || !Walkable(goalX, goalY)) {
+		return false;
+	}
+
+	if(++m_generation >= (1u << 31)) {
+		std::fill(m_nodes.begin(), m_nodes.end(), Node());
+		m_generation = 1;
+	}
+	m_open.clear();
+
+	m_startCell = (uint32_t)startY * m_width + startX;
+	m_goalCell = (uint32_t)goalY * m_width + goalX;
+	m_startCluster = ClusterOf(startX, startY);
+	m_goalCluster = ClusterOf(goalX, goalY);
+	ClusterDistances(m_startCluster, startX, startY, m_startDistance);
+	ClusterDistances(m_goalCluster, goalX, goalY, m_goalDistance);
+
+	// Distance within a cluster from the start, or to the goal, by cell
+	auto local = [&](const std::vector<uint32_t> &distance, int cluster, uint32_t cell) {
+		int x0, y0, x1, y1;
+		ClusterBounds(cluster, x0, y0, x1, y1);
+		return distance[(cell / m_width - y0) * (x1 - x0) + (cell % m_width - x0)];
+	};
+
+	Open(m_startNode, 0, m_startNode);
+	while(!m_open.empty()) {
+		std::pop_heap(m_open.begin(), m_open.end(), std::greater<PathOpenEntry>());
+		uint32_t node = m_open.back().node;
+		m_open.pop_back();
+
+		Node &n = m_nodes[node];
+		if(n.stamp & 1) {
+			continue;
+		}
+		n.stamp |= 1;
+		stats.abstractExpanded++;
+		if(node == m_goalNode) {
+			break;
+		}
+		uint64_t g = n.g;
+
+		if(node == m_startNode) {
+			const Cluster &c = m_clusters[m_startCluster];
+			for(size_t i = 0; i < c.cells.size(); i++) {
+				uint32_t d = local(m_startDistance, m_startCluster, c.cells[i]);
+				if(d != HPA_UNREACHABLE) {
+					Open((uint32_t)m_startCluster * m_maxNodes + i, d, node);
+				}
+			}
+			if(m_startCluster == m_goalCluster) {
+				uint32_t d = local(m_startDistance, m_startCluster, m_goalCell);
+				if(d != HPA_UNREACHABLE) {
+					Open(m_goalNode, d, node);
+				}
+			}
+			continue;
+		}
+
+		int cluster = node / m_maxNodes;
+		size_t i = node % m_maxNodes;
+		const Cluster &c = m_clusters[cluster];
+		size_t count = c.cells.size();
+		for(size_t j = 0; j < count; j++) {
+			uint32_t d = c.distance[i * count + j];
+			if(j != i && d != HPA_UNREACHABLE) {
+				Open((uint32_t)cluster * m_maxNodes + j, g + d, node);
+			}
+		}
+		for(int side = 0; side < 4; side++) {
+			uint32_t link = c.links[4 * i + side];
+			if(link != HPA_NO_NODE) {
+				Open(link, g + PATH_COST_STRAIGHT, node);
+			}
+		}
+		if(cluster == m_goalCluster) {
+			uint32_t d = local(m_goalDistance, m_goalCluster, c.cells[i]);
+			if(d != HPA_UNREACHABLE) {
+				Open(m_goalNode, g + d, node);
+			}
+		}
+	}
+
+	if(m_nodes[m_goalNode].stamp != ((m_generation << 1) | 1)) {
+		return false;
+	}
+	stats.found++;
+	m_cost = m_nodes[m_goalNode].g;
+
+	// Abstract route back to front, then refined front to back
+	std::vector<uint32_t> route;
+	for(uint32_t node = m_goalNode; node != m_startNode; node = m_nodes[node].parent) {
+		route.push_back(node);
+	}
+	route.push_back(m_startNode);
+	std::reverse(route.begin(), route.end());
+
+	path.push_back({ startX, startY });
+	for(size_t i = 1; i < route.size(); i++) {
+		if(!Refine(route[i - 1], route[i], path)) {
+			path.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+// Appends the cells after from up to and including to
+bool Hpa::Refine(uint32_t from, uint32_t to, std::vector<PathCell> &path) {
+	uint32_t fromCell = NodeCell(from), toCell = NodeCell(to);
+	int fx = fromCell % m_width, fy = fromCell / m_width;
+	int tx = toCell % m_width, ty = toCell / m_width;
+
+	int cluster = ClusterOf(fx, fy);
+	if(cluster != ClusterOf(tx, ty)) {
+		path.push_back({ tx, ty });		// Across an entrance
+		return true;
+	}
+
+	int x0, y0, x1, y1;
+	ClusterBounds(cluster, x0, y0, x1, y1);
+	m_refiner.SetBounds(x0, y0, x1, y1);
+	long long expanded = m_refiner.stats.expanded;
+	bool found = m_refiner.Find(PATH_JPS, fx, fy, tx, ty, m_segment);
+	stats.refineExpanded += m_refiner.stats.expanded - expanded;
+	if(!found) {
+		return false;
+	}
+	path.insert(path.end(), m_segment.begin() + 1, m_segment.end());
+	return true;
+}
+
+bool Hpa::Save(const char *fileName) const {
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		return false;
+	}
+
+	// The level may have changed through Update since it was built
+	HpaHeader header;
+	header.magic = HPA_MAGIC;
+	header.version = HPA_VERSION;
+	header.width = m_level->width;
+	header.height = m_level->height;
+	header.clusterSize = clusterSize;
+	header.clustersX = clustersX;
+	header.clustersY = clustersY;
+	header.reserved = 0;
+	header.levelHash = HashLevelWalls(*m_level);
+	out.write((const char *)&header, sizeof(header));
+
+	for(const Cluster &c : m_clusters) {
+		uint32_t count = c.cells.size();
+		out.write((const char *)&count, sizeof(count));
+		out.write((const char *)c.cells.data(), count * sizeof(uint32_t));
+		out.write((const char *)c.distance.data(), (size_t)count * count * sizeof(uint32_t));
+	}
+	return (bool)out;
+}
+
+bool Hpa::Load(const char *fileName, const TileGrid *level) {
+	std::ifstream in(fileName, std::ios::binary);
+	if(!in.is_open()) {
+		return false;
+	}
+
+	HpaHeader header;
+	if(!in.read((char *)&header, sizeof(header)) || header.magic != HPA_MAGIC || header.version != HPA_VERSION
+		|| header.clusterSize == 0 || header.clusterSize > 4096) {
+		std::cerr << "Invalid or outdated cluster graph " << fileName << std::endl;
+		return false;
+	}
+	if((int)header.width != level->width || (int)header.height != level->height || header.levelHash != HashLevelWalls(*level)) {
+		return false;
+	}
+
+	m_level = level;
+	clusterSize = header.clusterSize;
+	Resize();
+	levelHash = header.levelHash;
+
+	for(int cluster = 0; cluster < NumClusters(); cluster++) {
+		Cluster &c = m_clusters[cluster];
+		uint32_t count = 0;
+		if(!in.read((char *)&count, sizeof(count)) || count > (uint32_t)m_maxNodes) {
+			in.setstate(std::ios::failbit);
+			break;
+		}
+		c.cells.resize(count);
+		c.distance.resize((size_t)count * count);
+		in.read((char *)c.cells.data(), count * sizeof(uint32_t));
+		in.read((char *)c.distance.data(), (size_t)count * count * sizeof(uint32_t));
+
+		int x0, y0, x1, y1;
+		ClusterBounds(cluster, x0, y0, x1, y1);
+		for(uint32_t cell : c.cells) {
+			int x = cell % m_width, y = cell / m_width;
+			if(x < x0 || y < y0 || x >= x1 || y >= y1) {
+				in.setstate(std::ios::failbit);
+			}
+		}
+		if(!in) {
+			break;
+		}
+	}
+	if(!in) {
+		std::cerr << "Cluster graph " << fileName << " is truncated or corrupt" << std::endl;
+		m_clusters.clear();
+		clustersX = clustersY = 0;
+		return false;
+	}
+
+	for(int cluster = 0; cluster < NumClusters(); cluster++) {
+		LinkNodes(cluster);
+	}
+	return true;
+}
@@ -0,0 +1,138 @@
+#ifndef HPA_INCLUDED
+#define HPA_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Pathfind.hpp"
+#include "TileGrid.hpp"
+
+#define HPA_MAGIC 0x31415048		// "HPA1" in little endian
+#define HPA_VERSION 1
+#define HPA_CLUSTER_SIZE 16			// Cells per side of a cluster
+#define HPA_ENTRANCE_SPLIT 6		// Entrances this wide get a transition at each end instead of the middle
+
+// Header at the start of every .hpa file, followed by each cluster in
+// row-major order: its node count, the cell index of every node, then the
+// node to node distances as a row-major count x count matrix (all uint32_t)
+struct HpaHeader {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	clusterSize;
+	uint32_t	clustersX;
+	uint32_t	clustersY;
+	uint32_t	reserved;
+	uint64_t	levelHash;
+};
+
+struct HpaStats {
+	long long	queries = 0;
+	long long	found = 0;
+	long long	abstractExpanded = 0;	// Nodes of the cluster graph
+	long long	refineExpanded = 0;		// Cells, refining inside clusters
+};
+
+// Hierarchical pathfinding (HPA*): the level is cut into square clusters,
+// the open stretches of each border between two clusters become entrances,
+// and the cells either side of an entrance become nodes of an abstract
+// graph. Nodes of a cluster are joined by their shortest distance inside
+// it, so a long route is searched over the graph, then refined one cluster
+// at a time with a Pathfinder kept to that cluster
+// Paths move like the Pathfinder's but only cross borders straight at
+// entrances, so they can come out slightly longer than the shortest
+// Walkable cells are the Pathfinder's, anything but a wall; code that
+// changes the level, say closing a door by putting a wall in its cell,
+// calls Update for the cells it changed
+class Hpa {
+public:
+	Hpa() {}
+
+	// level is only read, and has to outlive the graph; 0 threads uses every core
+	void Build(const TileGrid *level, int clusterSize, int threads);
+
+	bool Save(const char *fileName) const;
+
+	// Reads a file written by Save, failing if it was built for other walls
+	bool Load(const char *fileName, const TileGrid *level);
+
+	// Rebuilds the clusters that [x0, x1) x [y0, y1) touches, with the
+	// entrances on their borders
+	// Returns the number of clusters rebuilt
+	int Update(int x0, int y0, int x1, int y1);
+
+	// Every cell from start to goal, both included; false if there is no path
+	bool Find(int startX, int startY, int goalX, int goalY, std::vector<PathCell> &path);
+
+	// Of the last path found, in PATH_COST_* units
+	uint64_t Cost() const { return m_cost; }
+
+	int NumClusters() const { return clustersX * clustersY; }
+	int NumNodes() const;
+
+	int			clusterSize = 0;
+	int			clustersX = 0;
+	int			clustersY = 0;
+	uint64_t	levelHash = 0;
+
+	HpaStats	stats;
+
+private:
+	struct Cluster {
+		std::vector<uint32_t>	cells;			// Cell index of each node
+		std::vector<uint32_t>	distance;		// cells.size() squared
+		std::vector<uint32_t>	links;			// Four per node, the node across each border (+x, -x, +y, -y)
+	};
+
+	// Abstract search state, stamped per query like the Pathfinder's
+	struct Node {
+		uint32_t	stamp;
+		uint32_t	parent;
+		uint64_t	g;
+	};
+
+	void Resize();
+	bool Walkable(int x, int y) const { return m_level->InBounds(x, y) && !m_level->IsWall(x, y); }
+
+	void CollectNodes(int cluster);
+	void ComputeDistances(int cluster);
+	void LinkNodes(int cluster);
+
+	// Distances inside cluster from one cell to every cell of it
+	void ClusterDistances(int cluster, int x, int y, std::vector<uint32_t> &distance) const;
+
+	void ClusterBounds(int cluster, int &x0, int &y0, int &x1, int &y1) const;
+	int ClusterOf(int x, int y) const { return (y / clusterSize) * clustersX + x / clusterSize; }
+
+	uint32_t NodeCell(uint32_t node) const;
+	void Open(uint32_t node, uint64_t g, uint32_t parent);
+	bool Refine(uint32_t from, uint32_t to, std::vector<PathCell> &path);
+
+	const TileGrid				*m_level = nullptr;
+	int							m_width = 0;
+	int							m_maxNodes = 0;		// Per cluster, node ids are cluster * m_maxNodes + index
+	std::vector<Cluster>		m_clusters;
+
+	std::vector<Node>			m_nodes;			// Every node id, then the start and goal
+	std::vector<PathOpenEntry>	m_open;
+	uint32_t					m_generation = 0;
+	uint32_t					m_startNode = 0;
+	uint32_t					m_goalNode = 0;
+	int							m_startCluster = 0;
+	int							m_goalCluster = 0;
+	uint32_t					m_startCell = 0;
+	uint32_t					m_goalCell = 0;
+	std::vector<uint32_t>		m_startDistance;	// By cell of the start's cluster
+	std::vector<uint32_t>		m_goalDistance;
+	uint64_t					m_cost = 0;
+
+	Pathfinder					m_refiner;
+	std::vector<PathCell>		m_segment;
+};
+
+// The .hpa file stored next to a scenefile ("maps/a.txt" -> "maps/a.hpa")
+std::string HpaFileName(const char *sceneFile);
+
+#endif
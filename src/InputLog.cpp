@@ -0,0 +1,189 @@
+#include "InputLog.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+enum {
+	INPUT_FORWARD = 1 << 0,
+	INPUT_RIGHT = 1 << 1,
+	INPUT_TURN = 1 << 2,
+	INPUT_LOOK = 1 << 3
+};
+
+static LoggedPose PoseOf(const Player &player) {
+	return { player.origin.x, player.origin.y, player.origin.z, player.yaw, player.pitch };
+}
+
+static float *InputField(PlayerInput &input, int field) {
+	float *fields[] = { &input.forward, &input.right, &input.turn, &input.look };
+	return fields[field];
+}
+
+static float InputValue(const PlayerInput &input, int field) {
+	return *InputField(const_cast<PlayerInput &>(input), field);
+}
+
+void InputLog::Begin(double seconds, uint64_t hash, const Player &player) {
+	tickSeconds = seconds;
+	levelHash = hash;
+	numTicks = 0;
+	start = PoseOf(player);
+	end = start;
+	changes.clear();
+}
+
+void InputLog::Record(uint64_t tick, const PlayerInput &input) {
+	const PlayerInput last = changes.empty() ? PlayerInput() : changes.back().input;
+	if(memcmp(&last, &input, sizeof(PlayerInput)) != 0) {
+		changes.push_back({ tick, input });
+	}
+}
+
+void InputLog::Finish(uint64_t ticks, const Player &player) {
+	numTicks = ticks;
+	end = PoseOf(player);
+}
+
+Player InputLog::StartPlayer() const {
+	Player player;
+	player.origin = Vec3f(start.x, start.y, start.z);
+	player.yaw = start.yaw;
+	player.pitch = start.pitch;
+	return player;
+}
+
+bool InputLog::EndsAt(const Player &player) const {
+	LoggedPose pose = PoseOf(player);
+	return memcmp(&pose, &end, sizeof(LoggedPose)) == 0;
+}
+
+bool InputLog::Save(const char *fileName) const {
+	std::vector<uint8_t> data;
+	PlayerInput last;
+	uint64_t lastTick = 0;
+	for(const InputChange &change : changes) {
+		for(uint64_t delta = change.tick - lastTick; ; delta >>= 7) {
+			data.push_back((delta & 0x7f) | (delta >= 0x80 ? 0x80 : 0));
+			if(delta < 0x80) {
+				break;
+			}
+		}
+		lastTick = change.tick;
+
+		size_t maskAt = data.size();
+		data.push_back(0);
+		for(int field = 0; field < 4; field++) {
+			float value = InputValue(change.input, field), previous = InputValue(last, field);
+			if(memcmp(&value, &previous, sizeof(float)) != 0) {
+				data[maskAt] |= 1 << field;
+				data.insert(data.end(), (const uint8_t *)&value, (const uint8_t *)&value + sizeof(float));
+			}
+		}
+		last = change.input;
+	}
+
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		return false;
+	}
+
+	InputLogHeader header;
+	header.magic = INPUT_LOG_MAGIC;
+	header.version = INPUT_LOG_VERSION;
+	header.numChanges = changes.size();
+	header.reserved = 0;
+	header.tickSeconds = tickSeconds;
+	header.levelHash = levelHash;
+	header.numTicks = numTicks;
+	header.start = start;
+	header.end = end;
+	out.write((const char *)&header, sizeof(header));
+	out.write((const char *)data.data(), data.size());
+	return (bool)out;
+}
+
+bool InputLog::Load(const char *fileName) {
+	std::ifstream in(fileName, std::ios::binary);
+	if(!in.is_open()) {
+		return false;
+	}
+
+	InputLogHeader header;
+	if(!in.read((char *)&header, sizeof(header)) || header.magic != INPUT_LOG_MAGIC || header.version != INPUT_LOG_VERSION
+		|| !(header.tickSeconds > 0.0)) {
+		std::cerr << "Invalid or outdated input log " << fileName << std::endl;
+		return false;
+	}
+	std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	changes.clear();
+	PlayerInput input;
+	uint64_t tick = 0;
+	size_t at = 0;
+	bool valid = true;
+	for(uint32_t i = 0; i < header.numChanges && valid; i++) {
+		uint64_t delta = 0;
+		for(int shift = 0; ; shift += 7) {
+			if(at >= data.size() || shift > 63) {
+				valid = false;
+				break;
+			}
+			uint8_t byte = data[at++];
+			delta |= (uint64_t)(byte & 0x7f) << shift;
+			if(!(byte & 0x80)) {
+				break;
+			}
+		}
+		if(!valid || at >= data.size()) {
+			valid = false;
+			break;
+		}
+		tick += delta;
+
+		uint8_t mask = data[at++];
+		for(int field = 0; field < 4; field++) {
+			if(!(mask & (1 << field))) {
+				continue;
+			}
+			if(at + sizeof(float) > data.size()) {
+				valid = false;
+				break;
+			}
+			memcpy(InputField(input, field), &data[at], sizeof(float));
+			at += sizeof(float);
+		}
+		changes.push_back({ tick, input });
+	}
+	if(!valid || at != data.size()) {
+		std::cerr << "Input log " << fileName << " is truncated or corrupt" << std::endl;
+		changes.clear();
+		return false;
+	}
+
+	tickSeconds = header.tickSeconds;
+	levelHash = header.levelHash;
+	numTicks = header.numTicks;
+	start = header.start;
+	end = header.end;
+	return true;
+}
+
+void InputPlayback::Begin(const InputLog *log) {
+	m_log = log;
+	m_next = 0;
+	m_tick = 0;
+	m_input = PlayerInput();
+}
+
+PlayerInput InputPlayback::Next() {
+	if(Finished()) {
+		return PlayerInput();
+	}
+	while(m_next < m_log->changes.size() && m_log->changes[m_next].tick <= m_tick) {
+		m_input = m_log->changes[m_next++].input;
+	}
+	m_tick++;
+	return m_input;
+}
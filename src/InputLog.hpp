@@ -0,0 +1,97 @@
+#ifndef INPUT_LOG_INCLUDED
+#define INPUT_LOG_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "Scene.hpp"
+
+#define INPUT_LOG_MAGIC 0x4e495a4d		// "MZIN" in little endian
+#define INPUT_LOG_VERSION 1
+
+// What the controls ask for, sampled by the main thread
+struct PlayerInput {
+	float	forward = 0.f;		// -1..1 along the view
+	float	right = 0.f;		// -1..1 across it
+	float	turn = 0.f;			// -1..1, positive turns left
+	float	look = 0.f;			// -1..1, positive looks up
+};
+
+// Where the player stood, at the start and end of a log
+struct LoggedPose {
+	float	x, y, z;
+	float	yaw, pitch;
+};
+
+// Header at the start of every input log, followed by numChanges changes:
+// the ticks since the previous change as a LEB128 varint, a byte with a
+// bit for each PlayerInput field that changed (forward, right, turn, look)
+// and the new value of each of those as a float
+struct InputLogHeader {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	numChanges;
+	uint32_t	reserved;
+	double		tickSeconds;
+	uint64_t	levelHash;		// HashLevelWalls of the level it was recorded on
+	uint64_t	numTicks;
+	LoggedPose	start;
+	LoggedPose	end;
+};
+
+struct InputChange {
+	uint64_t	tick;
+	PlayerInput	input;
+};
+
+// The input of every simulation tick, by tick rather than by time, so a
+// replay steps the same ticks with the same input however fast it runs
+// and however the frames fell when it was recorded
+class InputLog {
+public:
+	void Begin(double tickSeconds, uint64_t levelHash, const Player &start);
+
+	// Input of a tick, ticks in order; only changes are kept
+	void Record(uint64_t tick, const PlayerInput &input);
+
+	// After the last tick, to check replays against
+	void Finish(uint64_t numTicks, const Player &end);
+
+	bool Save(const char *fileName) const;
+	bool Load(const char *fileName);
+
+	// Where the log starts, to replay from
+	Player StartPlayer() const;
+
+	// Whether player is where the log ended, bit for bit
+	bool EndsAt(const Player &player) const;
+
+	double		tickSeconds = 0.0;
+	uint64_t	levelHash = 0;
+	uint64_t	numTicks = 0;
+	LoggedPose	start = {};
+	LoggedPose	end = {};
+
+	std::vector<InputChange> changes;
+};
+
+// Walks a log forward one tick at a time
+class InputPlayback {
+public:
+	void Begin(const InputLog *log);
+
+	// Input of the next tick, none past the end of the log
+	PlayerInput Next();
+
+	bool Finished() const { return m_tick >= Length(); }
+	uint64_t Tick() const { return m_tick; }
+	uint64_t Length() const { return m_log ? m_log->numTicks : 0; }
+
+private:
+	const InputLog	*m_log = nullptr;
+	size_t			m_next = 0;
+	uint64_t		m_tick = 0;
+	PlayerInput		m_input;
+};
+
+#endif
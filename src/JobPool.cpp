@@ -0,0 +1,88 @@
+#include "JobPool.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "Parallel.hpp"
+#include "Profiler.hpp"
+
+JobPool::~JobPool() {
+	Stop();
+}
+
+void JobPool::Start(int threads) {
+	Stop();
+
+	m_quit = false;
+	for(int worker = 1; worker < ResolveThreadCount(threads); worker++) {
+		m_workers.emplace_back(&JobPool::WorkerMain, this, worker, m_job);
+	}
+}
+
+void JobPool::Stop() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for(std::thread &thread : m_workers) {
+		thread.join();
+	}
+	m_workers.clear();
+}
+
+void JobPool::Run(int count, int grain, const std::function<void(int, int, int)> &fn) {
+	m_grain = std::max(1, grain);
+	m_count = count;
+	m_next = 0;
+
+	// A single range is not worth waking anyone for
+	if(m_workers.empty() || count <= m_grain) {
+		if(count > 0) {
+			fn(0, count, 0);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_fn = &fn;
+		m_busy = (int)m_workers.size();
+		m_job++;
+	}
+	m_wake.notify_all();
+
+	Work(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this]() { return m_busy == 0; });
+	m_fn = nullptr;
+}
+
+void JobPool::WorkerMain(int worker, uint64_t seen) {
+	ProfilerSetThreadName(("Job worker " + std::to_string(worker)).c_str());
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for(;;) {
+		m_wake.wait(lock, [&]() { return m_quit || m_job != seen; });
+		if(m_quit) {
+			return;
+		}
+		seen = m_job;
+
+		lock.unlock();
+		Work(worker);
+		lock.lock();
+
+		if(--m_busy == 0) {
+			m_done.notify_one();
+		}
+	}
+}
+
+// Ranges are handed out one at a time, so uneven ones balance out
+void JobPool::Work(int worker) {
+	for(int begin = m_next.fetch_add(m_grain); begin < m_count; begin = m_next.fetch_add(m_grain)) {
+		(*m_fn)(begin, std::min(m_count, begin + m_grain), worker);
+	}
+}
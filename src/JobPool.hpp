@@ -0,0 +1,49 @@
+#ifndef JOB_POOL_INCLUDED
+#define JOB_POOL_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads kept waiting between jobs, for work that is split up every
+// tick where ParallelFor would start and join threads each time
+// Run is meant to be called from one thread at a time
+class JobPool {
+public:
+	JobPool() {}
+	~JobPool();
+
+	// threads counts the calling thread, 0 uses every core
+	void Start(int threads);
+	void Stop();
+
+	int NumThreads() const { return (int)m_workers.size() + 1; }
+
+	// Calls fn(begin, end, worker) over [0, count) in ranges of grain items,
+	// worker is in [0, NumThreads()); returns once every range is done
+	void Run(int count, int grain, const std::function<void(int, int, int)> &fn);
+
+private:
+	void WorkerMain(int worker, uint64_t seen);
+	void Work(int worker);
+
+	std::vector<std::thread>	m_workers;
+
+	std::mutex					m_mutex;
+	std::condition_variable		m_wake;
+	std::condition_variable		m_done;
+	uint64_t					m_job = 0;			// Bumped for every Run
+	int							m_busy = 0;			// Workers still on the current job
+	bool						m_quit = false;
+
+	const std::function<void(int, int, int)> *m_fn = nullptr;
+	int							m_count = 0;
+	int							m_grain = 1;
+	std::atomic<int>			m_next{0};
+};
+
+#endif
@@ -1,85 +1,200 @@
 #ifndef MATH_INCLUDED
 #define MATH_INCLUDED
 
-#include <math.h>
+#include <cmath>
+#include <cstddef>
+
+// Header-only so every operator inlines at the call site, and constexpr so
+// the types work in compile-time tables; Length, Normalize and the
+// axis-angle constructor need sqrt/sin/cos and are inline only
 
 // Default is origin
-struct Vec3f {
+template <typename T>
+struct Vec3T {
 public:
-	Vec3f() {}
-	Vec3f(float x, float y, float z) : x(x), y(y), z(z) {}
-	Vec3f(const Vec3f &v2) : x(v2.x), y(v2.y), z(v2.z) {}
+	constexpr Vec3T() {}
+	constexpr Vec3T(T x, T y, T z) : x(x), y(y), z(z) {}
+
+	T Length() const {
+		return std::sqrt(x * x + y * y + z * z);
+	}
+
+	T Normalize() {
+		T l = Length();
+		if (l > T(0)) {
+			x /= l;
+			y /= l;
+			z /= l;
+		}
+		return l;
+	}
+
+	constexpr void Negate() {
+		x = -x;
+		y = -y;
+		z = -z;
+	}
 
-	float Length() {
-		return sqrt(x * x + y * y + z * z);
+	constexpr Vec3T Cross(const Vec3T &v2) const {
+		return Vec3T(	y*v2.z - z*v2.y,
+						z*v2.x - x*v2.z,
+						x*v2.y - y*v2.x	);
 	}
 
-	float Normalize();
-	void Negate();
-	Vec3f Cross(const Vec3f &v2) const;
-	float Dot(const Vec3f &v2) const;
+	constexpr T Dot(const Vec3T &v2) const {
+		return x*v2.x + y*v2.y + z*v2.z;
+	}
 
-	float x = 0.f;
-	float y = 0.f;
-	float z = 0.f;
+	T x = T(0);
+	T y = T(0);
+	T z = T(0);
 
-	Vec3f operator+(const Vec3f &v2) const;
-	Vec3f operator-(const Vec3f &v2) const;
+	constexpr Vec3T operator+(const Vec3T &v2) const { return Vec3T(x + v2.x, y + v2.y, z + v2.z); }
+	constexpr Vec3T operator-(const Vec3T &v2) const { return Vec3T(x - v2.x, y - v2.y, z - v2.z); }
 
 	// We want symmetry for these operators
 
-	friend Vec3f operator*(float lhs, const Vec3f &rhs);
-	friend Vec3f operator*(const Vec3f &lhs, float rhs);
-	friend Vec3f operator/(float lhs, const Vec3f &rhs);
-	friend Vec3f operator/(const Vec3f &lhs, float rhs);
+	friend constexpr Vec3T operator*(T lhs, const Vec3T &rhs) { return Vec3T(lhs * rhs.x, lhs * rhs.y, lhs * rhs.z); }
+	friend constexpr Vec3T operator*(const Vec3T &lhs, T rhs) { return Vec3T(lhs.x * rhs, lhs.y * rhs, lhs.z * rhs); }
+	friend constexpr Vec3T operator/(T lhs, const Vec3T &rhs) { return Vec3T(lhs / rhs.x, lhs / rhs.y, lhs / rhs.z); }
+	friend constexpr Vec3T operator/(const Vec3T &lhs, T rhs) { return Vec3T(lhs.x / rhs, lhs.y / rhs, lhs.z / rhs); }
 };
 
 
 // Floating-point quaternion in (w, x, y, z) convention
 // Default is identity
-struct Quaternion {
+template <typename T>
+struct QuaternionT {
 public:
-	Quaternion() {}		// Will be the indentity quaternion
-    Quaternion(float w, float x, float y, float z) : w(w), x(x), y(y), z(z) {}
-	Quaternion(const Quaternion &q2) : w(q2.w), x(q2.x), y(q2.y), z(q2.z) {}
-
-	Quaternion(const Vec3f &axis, float angle); // Create from an axis-angle
-
-	Quaternion GetConjugate();
-	void Normalize();
-	Vec3f RotateVector(const Vec3f &v) const;
-
-	float w = 1.f;
-	float x = 0.f;
-	float y = 0.f;
-	float z = 0.f;
-	
-	Quaternion operator*(const Quaternion &q2) const;
+	constexpr QuaternionT() {}		// Will be the indentity quaternion
+	constexpr QuaternionT(T w, T x, T y, T z) : w(w), x(x), y(y), z(z) {}
+
+	// Create from an axis-angle
+	// Axis must be a normal(unit) vector
+	QuaternionT(const Vec3T<T> &axis, T angle) {
+		T sinHA = std::sin(angle / 2);
+		w = std::cos(angle / 2);
+		x = axis.x * sinHA;
+		y = axis.y * sinHA;
+		z = axis.z * sinHA;
+	}
+
+	constexpr QuaternionT GetConjugate() const {
+		return QuaternionT(w, -x, -y, -z);
+	}
+
+	void Normalize() {
+		T l = std::sqrt(w * w + x * x + y * y + z * z);
+		if (l > T(0)) {
+			w /= l;
+			x /= l;
+			y /= l;
+			z /= l;
+		}
+	}
+
+	// Vector rotation, q * v * q^-1 for a unit quaternion
+	// Expanded as v + w t + (q x t) with t = 2 (q x v)
+	constexpr Vec3T<T> RotateVector(const Vec3T<T> &v) const {
+		T tx = T(2) * (y * v.z - z * v.y);
+		T ty = T(2) * (z * v.x - x * v.z);
+		T tz = T(2) * (x * v.y - y * v.x);
+
+		return Vec3T<T>(	v.x + w * tx + (y * tz - z * ty),
+							v.y + w * ty + (z * tx - x * tz),
+							v.z + w * tz + (x * ty - y * tx)	);
+	}
+
+	T w = T(1);
+	T x = T(0);
+	T y = T(0);
+	T z = T(0);
+
+	// Hamilton product, (q * q2).RotateVector(v) rotates by q2 first
+	constexpr QuaternionT operator*(const QuaternionT &q2) const {
+		return QuaternionT(	w * q2.w - x * q2.x - y * q2.y - z * q2.z,
+							w * q2.x + x * q2.w + y * q2.z - z * q2.y,
+							w * q2.y - x * q2.z + y * q2.w + z * q2.x,
+							w * q2.z + x * q2.y - y * q2.x + z * q2.w	);
+	}
 };
 
 // R, G, and B float values between 0-1
 // Default is black
-struct Color {
+template <typename T>
+struct ColorT {
 public:
-    Color() {}
-    Color(float r, float g, float b) : r(r), g(g), b(b) {}
-	Color(const Color &c2) : r(c2.r), g(c2.g), b(c2.b) {}
-	
-	float r = 0.f;
-	float g = 0.f;
-	float b = 0.f;
-
-	Color operator+(const Color &v2) const;
-	Color operator-(const Color &v2) const;
-	Color operator*(const Color &v2) const;
-	Color operator/(const Color &v2) const;
+	constexpr ColorT() {}
+	constexpr ColorT(T r, T g, T b) : r(r), g(g), b(b) {}
+
+	T r = T(0);
+	T g = T(0);
+	T b = T(0);
+
+	constexpr ColorT operator+(const ColorT &v2) const { return ColorT(r + v2.r, g + v2.g, b + v2.b); }
+	constexpr ColorT operator-(const ColorT &v2) const { return ColorT(r - v2.r, g - v2.g, b - v2.b); }
+	constexpr ColorT operator*(const ColorT &v2) const { return ColorT(r * v2.r, g * v2.g, b * v2.b); }
+	constexpr ColorT operator/(const ColorT &v2) const { return ColorT(r / v2.r, g / v2.g, b / v2.b); }
 
 	// We want symmetry for these operators
 
-	friend Color operator*(float lhs, const Color &rhs);
-	friend Color operator*(const Color &lhs, float rhs);
-	friend Color operator/(float lhs, const Color &rhs);
-	friend Color operator/(const Color &lhs, float rhs);
+	friend constexpr ColorT operator*(T lhs, const ColorT &rhs) { return ColorT(lhs * rhs.r, lhs * rhs.g, lhs * rhs.b); }
+	friend constexpr ColorT operator*(const ColorT &lhs, T rhs) { return ColorT(lhs.r * rhs, lhs.g * rhs, lhs.b * rhs); }
+	friend constexpr ColorT operator/(T lhs, const ColorT &rhs) { return ColorT(lhs / rhs.r, lhs / rhs.g, lhs / rhs.b); }
+	friend constexpr ColorT operator/(const ColorT &lhs, T rhs) { return ColorT(lhs.r / rhs, lhs.g / rhs, lhs.b / rhs); }
+};
+
+typedef Vec3T<float> Vec3f;
+typedef Vec3T<double> Vec3d;
+typedef QuaternionT<float> Quaternion;
+typedef QuaternionT<double> Quaterniond;
+typedef ColorT<float> Color;
+typedef ColorT<double> Colord;
+
+// i * j = k and j * i = -k, with w first in the constructor
+static_assert((Quaterniond(0, 1, 0, 0) * Quaterniond(0, 0, 1, 0)).z == 1.0
+	&& (Quaterniond(0, 0, 1, 0) * Quaterniond(0, 1, 0, 0)).z == -1.0
+	&& (Quaterniond(0, 1, 0, 0) * Quaterniond(0, 1, 0, 0)).w == -1.0, "quaternion product order");
+
+// Batch kernels over structure-of-arrays data
+// Every kernel has AVX, SSE and scalar versions, picked once at startup
+// from what the CPU supports; outputs may alias the inputs
+
+enum SimdLevel {
+	SIMD_SCALAR,
+	SIMD_SSE,
+	SIMD_AVX
+};
+
+// n vectors as three separate arrays
+struct Vec3fArrays {
+	float *x;
+	float *y;
+	float *z;
 };
 
+// n colors as three separate arrays
+struct ColorArrays {
+	float *r;
+	float *g;
+	float *b;
+};
+
+SimdLevel ActiveSimdLevel();
+
+// Caps the level the kernels use, for benchmarks and checks
+// Levels the CPU lacks fall back to the best one it has
+void SetSimdLevel(SimdLevel level);
+
+const char *SimdLevelName(SimdLevel level);
+
+// out[i] = q.RotateVector(in[i]), q must be a unit quaternion
+void RotateVectors(const Quaternion &q, const Vec3fArrays &in, const Vec3fArrays &out, size_t n);
+
+// Normalizes in place, zero-length vectors are left alone
+void NormalizeVectors(const Vec3fArrays &v, size_t n);
+
+// out[i] = a[i] + (b[i] - a[i]) * t
+void BlendColors(const ColorArrays &a, const ColorArrays &b, float t, const ColorArrays &out, size_t n);
+
 #endif
@@ -0,0 +1,223 @@
+#include "Math.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MATH_SIMD_X86
+#endif
+
+// Scalar versions, also used for the tails of the vector loops
+
+static void RotateVectorsScalar(const Quaternion &q, const Vec3fArrays &in, const Vec3fArrays &out, size_t begin, size_t n) {
+	for(size_t i = begin; i < n; i++) {
+		float vx = in.x[i], vy = in.y[i], vz = in.z[i];
+		float tx = 2.f * (q.y * vz - q.z * vy);
+		float ty = 2.f * (q.z * vx - q.x * vz);
+		float tz = 2.f * (q.x * vy - q.y * vx);
+		out.x[i] = vx + q.w * tx + (q.y * tz - q.z * ty);
+		out.y[i] = vy + q.w * ty + (q.z * tx - q.x * tz);
+		out.z[i] = vz + q.w * tz + (q.x * ty - q.y * tx);
+	}
+}
+
+static void NormalizeVectorsScalar(const Vec3fArrays &v, size_t begin, size_t n) {
+	for(size_t i = begin; i < n; i++) {
+		float l = sqrtf(v.x[i] * v.x[i] + v.y[i] * v.y[i] + v.z[i] * v.z[i]);
+		if(l > 0.f) {
+			v.x[i] /= l;
+			v.y[i] /= l;
+			v.z[i] /= l;
+		}
+	}
+}
+
+static void BlendColorsScalar(const ColorArrays &a, const ColorArrays &b, float t, const ColorArrays &out, size_t begin, size_t n) {
+	for(size_t i = begin; i < n; i++) {
+		out.r[i] = a.r[i] + (b.r[i] - a.r[i]) * t;
+		out.g[i] = a.g[i] + (b.g[i] - a.g[i]) * t;
+		out.b[i] = a.b[i] + (b.b[i] - a.b[i]) * t;
+	}
+}
+
+#ifdef MATH_SIMD_X86
+
+// SSE, 4 lanes
+
+static void RotateVectorsSSE(const Quaternion &q, const Vec3fArrays &in, const Vec3fArrays &out, size_t n) {
+	const __m128 qx = _mm_set1_ps(q.x), qy = _mm_set1_ps(q.y), qz = _mm_set1_ps(q.z), qw = _mm_set1_ps(q.w);
+	const __m128 two = _mm_set1_ps(2.f);
+
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		__m128 vx = _mm_loadu_ps(in.x + i), vy = _mm_loadu_ps(in.y + i), vz = _mm_loadu_ps(in.z + i);
+		__m128 tx = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qy, vz), _mm_mul_ps(qz, vy)));
+		__m128 ty = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qz, vx), _mm_mul_ps(qx, vz)));
+		__m128 tz = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qx, vy), _mm_mul_ps(qy, vx)));
+		_mm_storeu_ps(out.x + i, _mm_add_ps(_mm_add_ps(vx, _mm_mul_ps(qw, tx)), _mm_sub_ps(_mm_mul_ps(qy, tz), _mm_mul_ps(qz, ty))));
+		_mm_storeu_ps(out.y + i, _mm_add_ps(_mm_add_ps(vy, _mm_mul_ps(qw, ty)), _mm_sub_ps(_mm_mul_ps(qz, tx), _mm_mul_ps(qx, tz))));
+		_mm_storeu_ps(out.z + i, _mm_add_ps(_mm_add_ps(vz, _mm_mul_ps(qw, tz)), _mm_sub_ps(_mm_mul_ps(qx, ty), _mm_mul_ps(qy, tx))));
+	}
+	RotateVectorsScalar(q, in, out, i, n);
+}
+
+static void NormalizeVectorsSSE(const Vec3fArrays &v, size_t n) {
+	const __m128 zero = _mm_setzero_ps();
+
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		__m128 x = _mm_loadu_ps(v.x + i), y = _mm_loadu_ps(v.y + i), z = _mm_loadu_ps(v.z + i);
+		__m128 l = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+
+		// Zero lengths divide by one instead
+		__m128 isZero = _mm_cmpeq_ps(l, zero);
+		l = _mm_or_ps(_mm_andnot_ps(isZero, l), _mm_and_ps(isZero, _mm_set1_ps(1.f)));
+
+		_mm_storeu_ps(v.x + i, _mm_div_ps(x, l));
+		_mm_storeu_ps(v.y + i, _mm_div_ps(y, l));
+		_mm_storeu_ps(v.z + i, _mm_div_ps(z, l));
+	}
+	NormalizeVectorsScalar(v, i, n);
+}
+
+static void BlendColorsSSE(const ColorArrays &a, const ColorArrays &b, float t, const ColorArrays &out, size_t n) {
+	const __m128 vt = _mm_set1_ps(t);
+
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		__m128 ar = _mm_loadu_ps(a.r + i), ag = _mm_loadu_ps(a.g + i), ab = _mm_loadu_ps(a.b + i);
+		_mm_storeu_ps(out.r + i, _mm_add_ps(ar, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b.r + i), ar), vt)));
+		_mm_storeu_ps(out.g + i, _mm_add_ps(ag, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b.g + i), ag), vt)));
+		_mm_storeu_ps(out.b + i, _mm_add_ps(ab, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(b.b + i), ab), vt)));
+	}
+	BlendColorsScalar(a, b, t, out, i, n);
+}
+
+// AVX, 8 lanes, compiled for AVX regardless of the build flags and only
+// called when the CPU has it
+
+__attribute__((target("avx")))
+static void RotateVectorsAVX(const Quaternion &q, const Vec3fArrays &in, const Vec3fArrays &out, size_t n) {
+	const __m256 qx = _mm256_set1_ps(q.x), qy = _mm256_set1_ps(q.y), qz = _mm256_set1_ps(q.z), qw = _mm256_set1_ps(q.w);
+	const __m256 two = _mm256_set1_ps(2.f);
+
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		__m256 vx = _mm256_loadu_ps(in.x + i), vy = _mm256_loadu_ps(in.y + i), vz = _mm256_loadu_ps(in.z + i);
+		__m256 tx = _mm256_mul_ps(two, _mm256_sub_ps(_mm256_mul_ps(qy, vz), _mm256_mul_ps(qz, vy)));
+		__m256 ty = _mm256_mul_ps(two, _mm256_sub_ps(_mm256_mul_ps(qz, vx), _mm256_mul_ps(qx, vz)));
+		__m256 tz = _mm256_mul_ps(two, _mm256_sub_ps(_mm256_mul_ps(qx, vy), _mm256_mul_ps(qy, vx)));
+		_mm256_storeu_ps(out.x + i, _mm256_add_ps(_mm256_add_ps(vx, _mm256_mul_ps(qw, tx)), _mm256_sub_ps(_mm256_mul_ps(qy, tz), _mm256_mul_ps(qz, ty))));
+		_mm256_storeu_ps(out.y + i, _mm256_add_ps(_mm256_add_ps(vy, _mm256_mul_ps(qw, ty)), _mm256_sub_ps(_mm256_mul_ps(qz, tx), _mm256_mul_ps(qx, tz))));
+		_mm256_storeu_ps(out.z + i, _mm256_add_ps(_mm256_add_ps(vz, _mm256_mul_ps(qw, tz)), _mm256_sub_ps(_mm256_mul_ps(qx, ty), _mm256_mul_ps(qy, tx))));
+	}
+	RotateVectorsScalar(q, in, out, i, n);
+}
+
+__attribute__((target("avx")))
+static void NormalizeVectorsAVX(const Vec3fArrays &v, size_t n) {
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		__m256 x = _mm256_loadu_ps(v.x + i), y = _mm256_loadu_ps(v.y + i), z = _mm256_loadu_ps(v.z + i);
+		__m256 l = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+
+		__m256 isZero = _mm256_cmp_ps(l, zero, _CMP_EQ_OQ);
+		l = _mm256_blendv_ps(l, _mm256_set1_ps(1.f), isZero);
+
+		_mm256_storeu_ps(v.x + i, _mm256_div_ps(x, l));
+		_mm256_storeu_ps(v.y + i, _mm256_div_ps(y, l));
+		_mm256_storeu_ps(v.z + i, _mm256_div_ps(z, l));
+	}
+	NormalizeVectorsScalar(v, i, n);
+}
+
+__attribute__((target("avx")))
+static void BlendColorsAVX(const ColorArrays &a, const ColorArrays &b, float t, const ColorArrays &out, size_t n) {
+	const __m256 vt = _mm256_set1_ps(t);
+
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		__m256 ar = _mm256_loadu_ps(a.r + i), ag = _mm256_loadu_ps(a.g + i), ab = _mm256_loadu_ps(a.b + i);
+		_mm256_storeu_ps(out.r + i, _mm256_add_ps(ar, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(b.r + i), ar), vt)));
+		_mm256_storeu_ps(out.g + i, _mm256_add_ps(ag, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(b.g + i), ag), vt)));
+		_mm256_storeu_ps(out.b + i, _mm256_add_ps(ab, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(b.b + i), ab), vt)));
+	}
+	BlendColorsScalar(a, b, t, out, i, n);
+}
+
+static SimdLevel DetectSimdLevel() {
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx")) {
+		return SIMD_AVX;
+	}
+	if(__builtin_cpu_supports("sse2")) {
+		return SIMD_SSE;
+	}
+	return SIMD_SCALAR;
+}
+
+#else
+
+static SimdLevel DetectSimdLevel() {
+	return SIMD_SCALAR;
+}
+
+#endif
+
+static const SimdLevel supportedLevel = DetectSimdLevel();
+static SimdLevel activeLevel = supportedLevel;
+
+SimdLevel ActiveSimdLevel() {
+	return activeLevel;
+}
+
+void SetSimdLevel(SimdLevel level) {
+	activeLevel = level < supportedLevel ? level : supportedLevel;
+}
+
+const char *SimdLevelName(SimdLevel level) {
+	static const char *names[] = { "scalar", "SSE", "AVX" };
+	return names[level];
+}
+
+void RotateVectors(const Quaternion &q, const Vec3fArrays &in, const Vec3fArrays &out, size_t n) {
+#ifdef MATH_SIMD_X86
+	if(activeLevel == SIMD_AVX) {
+		RotateVectorsAVX(q, in, out, n);
+		return;
+	}
+	if(activeLevel == SIMD_SSE) {
+		RotateVectorsSSE(q, in, out, n);
+		return;
+	}
+#endif
+	RotateVectorsScalar(q, in, out, 0, n);
+}
+
+void NormalizeVectors(const Vec3fArrays &v, size_t n) {
+#ifdef MATH_SIMD_X86
+	if(activeLevel == SIMD_AVX) {
+		NormalizeVectorsAVX(v, n);
+		return;
+	}
+	if(activeLevel == SIMD_SSE) {
+		NormalizeVectorsSSE(v, n);
+		return;
+	}
+#endif
+	NormalizeVectorsScalar(v, 0, n);
+}
+
+void BlendColors(const ColorArrays &a, const ColorArrays &b, float t, const ColorArrays &out, size_t n) {
+#ifdef MATH_SIMD_X86
+	if(activeLevel == SIMD_AVX) {
+		BlendColorsAVX(a, b, t, out, n);
+		return;
+	}
+	if(activeLevel == SIMD_SSE) {
+		BlendColorsSSE(a, b, t, out, n);
+		return;
+	}
+#endif
+	BlendColorsScalar(a, b, t, out, 0, n);
+}
@@ -0,0 +1,423 @@
+#include "MazeGen.hpp"
+#include "SceneFile.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char *algorithmNames[NUM_MAZE_ALGORITHMS] = {
+	"backtracker",
+	"kruskal",
+	"eller",
+	"wilson"
+};
+
+const char *MazeAlgorithmName(MazeAlgorithm algorithm) {
+	return algorithmNames[algorithm];
+}
+
+int MazeAlgorithmFromName(const char *name) {
+	for(int i = 0; i < NUM_MAZE_ALGORITHMS; i++) {
+		if(!strcmp(name, algorithmNames[i])) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Independent seed for each band, and one for the passages joining them
+static uint64_t BandSeed(uint64_t seed, int band) {
+	return MazeRng(seed ^ ((uint64_t)band * 0xd1b54a32d192ed03ull)).Next();
+}
+
+static uint64_t StitchSeed(uint64_t seed) {
+	return MazeRng(~seed).Next();
+}
+
+// Opens the wall between neighbouring rooms a and b
+static void Carve(uint8_t *rooms, int width, int a, int b) {
+	if(b == a + 1) {
+		rooms[a] |= MAZE_OPEN_EAST;
+	}
+	else if(b == a - 1) {
+		rooms[b] |= MAZE_OPEN_EAST;
+	}
+	else if(b == a + width) {
+		rooms[a] |= MAZE_OPEN_SOUTH;
+	}
+	else {
+		rooms[b] |= MAZE_OPEN_SOUTH;
+	}
+}
+
+// Room index of the neighbour in direction dir (0 east, 1 west, 2 south, 3 north), -1 past the edge
+static int Neighbour(int room, int dir, int width, int height) {
+	int x = room % width, y = room / width;
+	switch(dir) {
+		case 0: return x + 1 < width ? room + 1 : -1;
+		case 1: return x > 0 ? room - 1 : -1;
+		case 2: return y + 1 < height ? room + width : -1;
+		default: return y > 0 ? room - width : -1;
+	}
+}
+
+// Depth-first search with an explicit stack: long winding corridors
+static void GenerateBacktracker(int width, int height, MazeRng &rng, uint8_t *rooms) {
+	int numRooms = width * height;
+	std::vector<uint8_t> visited(numRooms, 0);
+	std::vector<int> stack;
+	stack.reserve(numRooms);
+
+	int start = rng.Below(numRooms);
+	visited[start] = 1;
+	stack.push_back(start);
+
+	while(!stack.empty()) {
+		int room = stack.back();
+
+		int options[4], numOptions = 0;
+		for(int dir = 0; dir < 4; dir++) {
+			int next = Neighbour(room, dir, width, height);
+			if(next >= 0 && !visited[next]) {
+				options[numOptions++] = next;
+			}
+		}
+
+		if(!numOptions) {
+			stack.pop_back();
+			continue;
+		}
+
+		int next = options[rng.Below(numOptions)];
+		Carve(rooms, width, room, next);
+		visited[next] = 1;
+		stack.push_back(next);
+	}
+}
+
+static int FindRoot(std::vector<int> &parent, int i) {
+	while(parent[i] != i) {
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+// Randomly ordered edges joined whenever they connect two separate trees
+static void GenerateKruskal(int width, int height, MazeRng &rng, uint8_t *rooms) {
+	int numRooms = width * height;
+
+	// Edge 2 * room is the room's east wall, 2 * room + 1 its south wall
+	std::vector<int> edges;
+	edges.reserve(2 * numRooms);
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			int room = y * width + x;
+			if(x + 1 < width) {
+				edges.push_back(2 * room);
+			}
+			if(y + 1 < height) {
+				edges.push_back(2 * room + 1);
+			}
+		}
+	}
+	for(int i = (int)edges.size() - 1; i > 0; i--) {
+		std::swap(edges[i], edges[rng.Below(i + 1)]);
+	}
+
+	std::vector<int> parent(numRooms);
+	for(int i = 0; i < numRooms; i++) {
+		parent[i] = i;
+	}
+
+	int joined = 0;
+	for(size_t i = 0; i < edges.size() && joined < numRooms - 1; i++) {
+		int room = edges[i] >> 1;
+		bool south = edges[i] & 1;
+		int a = FindRoot(parent, room);
+		int b = FindRoot(parent, south ? room + width : room + 1);
+		if(a == b) {
+			continue;
+		}
+		parent[b] = a;
+		rooms[room] |= south ? MAZE_OPEN_SOUTH : MAZE_OPEN_EAST;
+		joined++;
+	}
+}
+
+// Loop-erased random walks, an unbiased sample of all spanning trees
+static void GenerateWilson(int width, int height, MazeRng &rng, uint8_t *rooms) {
+	int numRooms = width * height;
+	std::vector<uint8_t> inMaze(numRooms, 0);
+	std::vector<uint8_t> walkDir(numRooms, 0);
+
+	inMaze[rng.Below(numRooms)] = 1;
+
+	for(int start = 0; start < numRooms; start++) {
+		if(inMaze[start]) {
+			continue;
+		}
+
+		// Walk until the maze is hit, overwriting the exit direction of a
+		// room on every revisit erases the loop through it
+		int room = start;
+		while(!inMaze[room]) {
+			int dir, next;
+			do {
+				dir = rng.Below(4);
+				next = Neighbour(room, dir, width, height);
+			} while(next < 0);
+			walkDir[room] = dir;
+			room = next;
+		}
+
+		room = start;
+		while(!inMaze[room]) {
+			int next = Neighbour(room, walkDir[room], width, height);
+			Carve(rooms, width, room, next);
+			inMaze[room] = 1;
+			room = next;
+		}
+	}
+}
+
+void EllerStream::Begin(int width, uint64_t seed) {
+	m_rng = MazeRng(seed);
+	m_width = width;
+	m_parent.resize(width);
+	m_root.resize(width);
+	m_count.resize(width);
+	m_pick.resize(width);
+	m_down.resize(width);
+	m_any.resize(width);
+
+	for(int x = 0; x < width; x++) {
+		m_parent[x] = x;
+	}
+}
+
+int EllerStream::Find(int x) {
+	while(m_parent[x] != x) {
+		m_parent[x] = m_parent[m_parent[x]];
+		x = m_parent[x];
+	}
+	return x;
+}
+
+void EllerStream::NextRow(bool lastRow, uint8_t *rooms) {
+	memset(rooms, 0, m_width);
+
+	// Join neighbours from different sets at random, all of them on the last row
+	for(int x = 0; x + 1 < m_width; x++) {
+		int a = Find(x), b = Find(x + 1);
+		if(a != b && (lastRow || m_rng.Coin())) {
+			rooms[x] |= MAZE_OPEN_EAST;
+			m_parent[b] = a;
+		}
+	}
+
+	if(lastRow) {
+		return;
+	}
+
+	// Every set continues down through at least one room, picked by
+	// reservoir sampling when none of its coin flips did
+	for(int x = 0; x < m_width; x++) {
+		m_count[x] = 0;
+		m_any[x] = 0;
+	}
+	for(int x = 0; x < m_width; x++) {
+		int root = Find(x);
+		m_root[x] = root;
+		m_down[x] = m_rng.Coin();
+		m_any[root] |= m_down[x];
+		if(m_rng.Below(++m_count[root]) == 0) {
+			m_pick[root] = x;
+		}
+	}
+	for(int x = 0; x < m_width; x++) {
+		int root = m_root[x];
+		if(!m_any[root] && m_pick[root] == x) {
+			m_down[x] = 1;
+		}
+	}
+
+	// Rooms below keep their set, the rest of the next row starts fresh
+	// m_pick is reused as the first room of each set in the next row
+	for(int x = 0; x < m_width; x++) {
+		m_pick[x] = -1;
+	}
+	for(int x = 0; x < m_width; x++) {
+		if(!m_down[x]) {
+			m_parent[x] = x;
+			continue;
+		}
+		rooms[x] |= MAZE_OPEN_SOUTH;
+		int root = m_root[x];
+		if(m_pick[root] < 0) {
+			m_pick[root] = x;
+		}
+		m_parent[x] = m_pick[root];
+	}
+}
+
+static void GenerateEller(int width, int height, MazeRng &rng, uint8_t *rooms) {
+	EllerStream stream;
+	stream.Begin(width, rng.Next());
+	for(int y = 0; y < height; y++) {
+		stream.NextRow(y == height - 1, rooms + (size_t)y * width);
+	}
+}
+
+void GenerateMazeRooms(MazeAlgorithm algorithm, int width, int height, uint64_t seed, uint8_t *rooms) {
+	memset(rooms, 0, (size_t)width * height);
+
+	MazeRng rng(seed);
+	switch(algorithm) {
+		case MAZE_BACKTRACKER:
+			GenerateBacktracker(width, height, rng, rooms);
+			break;
+		case MAZE_KRUSKAL:
+			GenerateKruskal(width, height, rng, rooms);
+			break;
+		case MAZE_ELLER:
+			GenerateEller(width, height, rng, rooms);
+			break;
+		case MAZE_WILSON:
+			GenerateWilson(width, height, rng, rooms);
+			break;
+		default:
+			break;
+	}
+}
+
+void MazeRoomRowTiles(const uint8_t *rooms, int width, uint8_t *tiles) {
+	tiles[0] = LEVEL_WALL;
+	for(int x = 0; x < width; x++) {
+		tiles[2 * x + 1] = LEVEL_AIR;
+		tiles[2 * x + 2] = (rooms[x] & MAZE_OPEN_EAST) ? LEVEL_AIR : LEVEL_WALL;
+	}
+}
+
+void MazeWallRowTiles(const uint8_t *rooms, int width, uint8_t *tiles) {
+	tiles[0] = LEVEL_WALL;
+	for(int x = 0; x < width; x++) {
+		tiles[2 * x + 1] = (rooms && (rooms[x] & MAZE_OPEN_SOUTH)) ? LEVEL_AIR : LEVEL_WALL;
+		tiles[2 * x + 2] = LEVEL_WALL;
+	}
+}
+
+bool GenerateMaze(const MazeGenConfig &config, TileGrid &level) {
+	int roomsX = config.roomsX, roomsY = config.roomsY;
+	if(roomsX <= 0 || roomsY <= 0 || roomsX > MAZE_MAX_ROOMS || roomsY > MAZE_MAX_ROOMS || (long long)roomsX * roomsY > (1LL << 30)) {
+		std::cerr << "Invalid maze size " << roomsX << "x" << roomsY << std::endl;
+		return false;
+	}
+
+	int bandRooms = config.bandRooms > 0 ? std::min(config.bandRooms, roomsY) : roomsY;
+	int numBands = (roomsY + bandRooms - 1) / bandRooms;
+	int threads = ResolveThreadCount(config.threads);
+
+	std::vector<uint8_t> rooms((size_t)roomsX * roomsY);
+	ParallelFor(numBands, threads, [&](int band) {
+		int y0 = band * bandRooms;
+		int y1 = std::min(y0 + bandRooms, roomsY);
+		GenerateMazeRooms(config.algorithm, roomsX, y1 - y0, BandSeed(config.seed, band),
+			&rooms[(size_t)y0 * roomsX]);
+	});
+
+	// Each band is a spanning tree, so one passage between neighbouring
+	// bands keeps the whole maze perfect
+	MazeRng stitch(StitchSeed(config.seed));
+	for(int band = 1; band < numBands; band++) {
+		int x = stitch.Below(roomsX);
+		rooms[(size_t)(band * bandRooms - 1) * roomsX + x] |= MAZE_OPEN_SOUTH;
+	}
+
+	// Rows of the bitset never share words, so bands can be written in parallel too
+	int width = 2 * roomsX + 1, height = 2 * roomsY + 1;
+	level.Resize(width, height, level.layout);
+	ParallelFor(numBands, threads, [&](int band) {
+		int y0 = band * bandRooms;
+		int y1 = std::min(y0 + bandRooms, roomsY);
+		std::vector<uint8_t> tiles(width);
+
+		auto writeRow = [&](int tileY) {
+			for(int x = 0; x < width; x++) {
+				level.Set(x, tileY, tiles[x]);
+			}
+		};
+
+		if(band == 0) {
+			MazeWallRowTiles(nullptr, roomsX, tiles.data());
+			writeRow(0);
+		}
+		for(int y = y0; y < y1; y++) {
+			const uint8_t *row = &rooms[(size_t)y * roomsX];
+			MazeRoomRowTiles(row, roomsX, tiles.data());
+			writeRow(2 * y + 1);
+			MazeWallRowTiles(row, roomsX, tiles.data());
+			writeRow(2 * y + 2);
+		}
+	});
+
+	level.Set(1, 1, LEVEL_SPAWN);
+	level.Set(width - 2, height - 2, LEVEL_GOAL);
+
+	return true;
+}
+
+static_assert(2LL * MAZE_MAX_ROOMS + 1 <= SCENE_FILE_MAX_SIDE, "mazes must fit the scenefile reader");
+
+bool WriteEllerSceneFile(const char *fileName, int roomsX, int roomsY, uint64_t seed) {
+	if(roomsX <= 0 || roomsY <= 0 || roomsX > MAZE_MAX_ROOMS || roomsY > MAZE_MAX_ROOMS) {
+		std::cerr << "Invalid maze size " << roomsX << "x" << roomsY << std::endl;
+		return false;
+	}
+
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		return false;
+	}
+
+	int width = 2 * roomsX + 1, height = 2 * roomsY + 1;
+	out << width << " " << height << "\n";
+
+	std::vector<uint8_t> rooms(roomsX), tiles(width);
+	std::vector<char> line(width + 1);
+	line[width] = '\n';
+
+	auto writeRow = [&]() {
+		for(int x = 0; x < width; x++) {
+			line[x] = CharFromTile(tiles[x]);
+		}
+		out.write(line.data(), line.size());
+	};
+
+	// Same seed chain as a single band of GenerateMaze
+	MazeRng rng(BandSeed(seed, 0));
+	EllerStream stream;
+	stream.Begin(roomsX, rng.Next());
+
+	MazeWallRowTiles(nullptr, roomsX, tiles.data());
+	writeRow();
+	for(int y = 0; y < roomsY; y++) {
+		stream.NextRow(y == roomsY - 1, rooms.data());
+
+		MazeRoomRowTiles(rooms.data(), roomsX, tiles.data());
+		if(y == 0) {
+			tiles[1] = LEVEL_SPAWN;
+		}
+		if(y == roomsY - 1) {
+			tiles[width - 2] = LEVEL_GOAL;
+		}
+		writeRow();
+
+		MazeWallRowTiles(rooms.data(), roomsX, tiles.data());
+		writeRow();
+	}
+
+	return (bool)out;
+}
@@ -0,0 +1,103 @@
+#ifndef MAZE_GEN_INCLUDED
+#define MAZE_GEN_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "SceneFile.hpp"
+#include "TileGrid.hpp"
+
+enum MazeAlgorithm {
+	MAZE_BACKTRACKER,
+	MAZE_KRUSKAL,
+	MAZE_ELLER,
+	MAZE_WILSON,
+	NUM_MAZE_ALGORITHMS
+};
+
+// Passage bits of a room, the west and north passages belong to the neighbour
+enum {
+	MAZE_OPEN_EAST = 1 << 0,
+	MAZE_OPEN_SOUTH = 1 << 1
+};
+
+#define MAZE_BAND_ROOMS 128		// Rows of rooms generated independently of each other
+
+// Most rooms along either side, so the level still fits a scenefile
+#define MAZE_MAX_ROOMS ((SCENE_FILE_MAX_SIDE - 1) / 2)
+
+// splitmix64, so a seed gives the same maze on every platform and standard library
+struct MazeRng {
+	uint64_t state;
+
+	explicit MazeRng(uint64_t seed) : state(seed) {}
+
+	uint64_t Next() {
+		uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+
+	// Uniform in [0, n)
+	uint32_t Below(uint32_t n) { return (uint32_t)(((Next() >> 32) * n) >> 32); }
+	bool Coin() { return Next() >> 63; }
+};
+
+struct MazeGenConfig {
+	MazeAlgorithm	algorithm = MAZE_BACKTRACKER;
+	int				roomsX = 16;
+	int				roomsY = 16;
+	uint64_t		seed = 1;
+
+	// Bands of bandRooms rows are generated on separate threads and joined
+	// by one passage each; 0 generates the whole maze as a single band
+	// The output depends on the seed and band size, never on the thread count
+	int				bandRooms = MAZE_BAND_ROOMS;
+	int				threads = 0;		// 0 uses every core
+};
+
+// Rooms sit on odd tile coordinates, so a maze of roomsX x roomsY rooms is
+// a (2 * roomsX + 1) x (2 * roomsY + 1) level with spawn in the first room
+// and the goal in the last
+bool GenerateMaze(const MazeGenConfig &config, TileGrid &level);
+
+// Passages (MAZE_OPEN_* bits) of a perfect maze over width x height rooms
+void GenerateMazeRooms(MazeAlgorithm algorithm, int width, int height, uint64_t seed, uint8_t *rooms);
+
+// Eller's algorithm one row of rooms at a time in O(width) memory
+class EllerStream {
+public:
+	void Begin(int width, uint64_t seed);
+
+	// Passages of the next row, the last row joins every remaining set
+	void NextRow(bool lastRow, uint8_t *rooms);
+
+private:
+	int Find(int x);
+
+	MazeRng				m_rng = MazeRng(0);
+	int					m_width = 0;
+	std::vector<int>	m_parent;
+	std::vector<int>	m_root;
+	std::vector<int>	m_count;
+	std::vector<int>	m_pick;
+	std::vector<uint8_t> m_down;
+	std::vector<uint8_t> m_any;
+};
+
+// Tiles of the level row through a row of rooms and of the wall row below
+// it, a null rooms row gives the solid top border
+void MazeRoomRowTiles(const uint8_t *rooms, int width, uint8_t *tiles);
+void MazeWallRowTiles(const uint8_t *rooms, int width, uint8_t *tiles);
+
+// Streams an Eller's maze straight to a scenefile, matching GenerateMaze
+// with MAZE_ELLER and bandRooms 0 for the same seed
+bool WriteEllerSceneFile(const char *fileName, int roomsX, int roomsY, uint64_t seed);
+
+const char *MazeAlgorithmName(MazeAlgorithm algorithm);
+
+// -1 if the name is unknown
+int MazeAlgorithmFromName(const char *name);
+
+#endif
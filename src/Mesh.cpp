@@ -0,0 +1,196 @@
+#include "Mesh.hpp"
+#include "MeshOptimize.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Mesh::~Mesh() {
+	Release();
+}
+
+void Mesh::Release() {
+	if(m_mapping) {
+		munmap(m_mapping, m_mappingSize);
+		m_mapping = nullptr;
+		m_mappingSize = 0;
+	}
+	m_ownedVertices = std::vector<float>();
+	m_ownedIndices = std::vector<uint8_t>();
+
+	vertices = nullptr;
+	numVerts = 0;
+	indices = nullptr;
+	numIndices = 0;
+	indexSize = 0;
+	mapped = false;
+}
+
+bool Mesh::LoadBinary(const char *fileName) {
+	Release();
+
+	int fd = open(fileName, O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(MeshHeader)) {
+		close(fd);
+		return false;
+	}
+
+	size_t fileSize = st.st_size;
+	void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);		// The mapping keeps its own reference to the file
+	if(mapping == MAP_FAILED) {
+		std::cerr << "Failed to map mesh file " << fileName << std::endl;
+		return false;
+	}
+
+	const MeshHeader *header = (const MeshHeader *)mapping;
+	if(header->magic != MESH_MAGIC || header->version != MESH_VERSION || header->vertexFloats != MESH_VERTEX_FLOATS
+		|| header->dataSize != (uint64_t)header->numVerts * MESH_VERTEX_STRIDE
+		|| header->dataOffset % MESH_DATA_ALIGN != 0
+		|| header->dataOffset > fileSize || header->dataSize > fileSize - header->dataOffset
+		|| header->numIndices % 3 != 0 || (header->indexSize != 2 && header->indexSize != 4)
+		|| header->indexOffset % header->indexSize != 0
+		|| header->indexOffset > fileSize
+		|| header->numIndices > (fileSize - header->indexOffset) / header->indexSize) {
+		std::cerr << "Invalid or outdated mesh file " << fileName << std::endl;
+		munmap(mapping, fileSize);
+		return false;
+	}
+
+	// The whole payload goes to the GPU right away, so read it in eagerly
+	madvise(mapping, fileSize, MADV_WILLNEED);
+
+	m_mapping = mapping;
+	m_mappingSize = fileSize;
+	vertices = (const float *)((const char *)mapping + header->dataOffset);
+	numVerts = header->numVerts;
+	indices = (const char *)mapping + header->indexOffset;
+	numIndices = header->numIndices;
+	indexSize = header->indexSize;
+	mapped = true;
+
+	// An index past the vertices would read outside the buffer on the GPU
+	for(int i = 0; i < numIndices; i++) {
+		if(Index(i) >= (uint32_t)numVerts) {
+			std::cerr << "Mesh file " << fileName << " indexes past its vertices" << std::endl;
+			Release();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ReadTextModel(const char *fileName, std::vector<float> &soup) {
+	std::ifstream modelFile;
+	modelFile.open(fileName);
+	if(!modelFile.is_open()) {
+		return false;
+	}
+
+	int numLines = 0;
+	modelFile >> numLines;
+	if(numLines <= 0 || numLines % (MESH_VERTEX_FLOATS * 3) != 0) {
+		std::cerr << "Invalid float count in model file " << fileName << std::endl;
+		return false;
+	}
+
+	soup.resize(numLines);
+	for(int i = 0; i < numLines; i++) {
+		modelFile >> soup[i];
+	}
+	if(!modelFile) {
+		std::cerr << "Model file " << fileName << " ended early" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Text models are triangle soups, indexed here so both formats draw the same way
+bool Mesh::LoadText(const char *fileName) {
+	Release();
+
+	std::vector<float> soup;
+	if(!ReadTextModel(fileName, soup)) {
+		return false;
+	}
+
+	std::vector<uint32_t> list;
+	BuildIndexedMesh(soup.data(), soup.size() / MESH_VERTEX_FLOATS, m_ownedVertices, list);
+
+	vertices = m_ownedVertices.data();
+	numVerts = m_ownedVertices.size() / MESH_VERTEX_FLOATS;
+	indexSize = MeshIndexSize(numVerts);
+	PackIndices(list.data(), list.size(), indexSize, m_ownedIndices);
+	indices = m_ownedIndices.data();
+	numIndices = list.size();
+
+	return true;
+}
+
+bool Mesh::Load(const char *baseName) {
+	std::string name = baseName;
+	if(LoadBinary((name + ".mesh").c_str())) {
+		return true;
+	}
+	return LoadText((name + ".txt").c_str());
+}
+
+int MeshIndexSize(int numVerts) {
+	return numVerts <= 0xffff ? 2 : 4;
+}
+
+void PackIndices(const uint32_t *indices, size_t numIndices, int indexSize, std::vector<uint8_t> &out) {
+	out.resize(numIndices * indexSize);
+	if(indexSize == 4) {
+		memcpy(out.data(), indices, out.size());
+		return;
+	}
+	uint16_t *packed = (uint16_t *)out.data();
+	for(size_t i = 0; i < numIndices; i++) {
+		packed[i] = (uint16_t)indices[i];
+	}
+}
+
+bool WriteMeshBinary(const char *fileName, const float *vertices, int numVerts, const uint32_t *indices, int numIndices) {
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		return false;
+	}
+
+	MeshHeader header;
+	header.magic = MESH_MAGIC;
+	header.version = MESH_VERSION;
+	header.vertexFloats = MESH_VERTEX_FLOATS;
+	header.numVerts = numVerts;
+	header.dataOffset = MESH_DATA_ALIGN;
+	header.dataSize = (uint64_t)numVerts * MESH_VERTEX_STRIDE;
+	header.numIndices = numIndices;
+	header.indexSize = MeshIndexSize(numVerts);
+	header.indexOffset = header.dataOffset + header.dataSize;		// The stride keeps it aligned
+
+	std::vector<uint8_t> packed;
+	PackIndices(indices, numIndices, header.indexSize, packed);
+
+	char padding[MESH_DATA_ALIGN];
+	memset(padding, 0, sizeof(padding));
+
+	out.write((const char *)&header, sizeof(header));
+	out.write(padding, MESH_DATA_ALIGN - sizeof(header));
+	out.write((const char *)vertices, header.dataSize);
+	out.write((const char *)packed.data(), packed.size());
+
+	return (bool)out;
+}
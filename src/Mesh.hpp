@@ -0,0 +1,93 @@
+#ifndef MESH_INCLUDED
+#define MESH_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Interleaved vertex layout shared by every model:
+// position (3), texcoord (2), normal (3)
+#define MESH_VERTEX_FLOATS 8
+#define MESH_VERTEX_STRIDE (MESH_VERTEX_FLOATS * sizeof(float))
+
+#define MESH_MAGIC 0x48534d4d		// "MMSH" in little endian
+#define MESH_VERSION 2
+#define MESH_DATA_ALIGN 64			// Payload offset alignment, in bytes
+
+// Header at the start of every binary .mesh file
+// The vertex payload starts at dataOffset and is dataSize bytes long, the
+// triangle list indices (indexSize bytes each) follow it at indexOffset
+struct MeshHeader {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	vertexFloats;
+	uint32_t	numVerts;
+	uint64_t	dataOffset;
+	uint64_t	dataSize;
+	uint32_t	numIndices;
+	uint32_t	indexSize;
+	uint64_t	indexOffset;
+};
+
+// Where a model sits in vertex and index buffers shared by several models
+struct MeshRange {
+	int		baseVertex = 0;
+	int		numIndices = 0;
+	size_t	indexOffset = 0;		// In bytes
+	int		indexSize = 4;
+};
+
+// Indexed triangle list of a single model
+// Binary meshes are memory-mapped and point straight into the mapping,
+// text models are triangle soups, welded and reordered into heap arrays
+class Mesh {
+public:
+	Mesh() {}
+	~Mesh();
+
+	Mesh(const Mesh &) = delete;
+	Mesh &operator=(const Mesh &) = delete;
+
+	bool LoadBinary(const char *fileName);
+	bool LoadText(const char *fileName);
+
+	// Tries <baseName>.mesh first, then falls back to <baseName>.txt
+	bool Load(const char *baseName);
+
+	// Unmaps or frees the vertex data
+	void Release();
+
+	size_t SizeBytes() const { return (size_t)numVerts * MESH_VERTEX_STRIDE; }
+	size_t IndexBytes() const { return (size_t)numIndices * indexSize; }
+
+	uint32_t Index(int i) const {
+		return indexSize == 2 ? ((const uint16_t *)indices)[i] : ((const uint32_t *)indices)[i];
+	}
+
+	const float	*vertices = nullptr;
+	int			numVerts = 0;
+	const void	*indices = nullptr;
+	int			numIndices = 0;
+	int			indexSize = 0;			// 2 or 4 bytes
+	bool		mapped = false;
+
+private:
+	void					*m_mapping = nullptr;
+	size_t					m_mappingSize = 0;
+	std::vector<float>		m_ownedVertices;
+	std::vector<uint8_t>	m_ownedIndices;
+};
+
+// Reads a legacy text model, a float count followed by one float per line
+bool ReadTextModel(const char *fileName, std::vector<float> &soup);
+
+// Index size of a mesh with numVerts vertices, 16 bits whenever they fit
+int MeshIndexSize(int numVerts);
+
+// Stores indices at indexSize bytes each into out
+void PackIndices(const uint32_t *indices, size_t numIndices, int indexSize, std::vector<uint8_t> &out);
+
+// Writes an indexed mesh out in the binary .mesh format
+bool WriteMeshBinary(const char *fileName, const float *vertices, int numVerts, const uint32_t *indices, int numIndices);
+
+#endif
@@ -0,0 +1,185 @@
+#include "MeshOptimize.hpp"
+#include "Mesh.hpp"
+
+#include <cstring>
+
+// Bits of one vertex with -0 folded into +0, so equal vertices compare equal
+static void VertexKey(const float *vertex, uint32_t *key) {
+	for(int i = 0; i < MESH_VERTEX_FLOATS; i++) {
+		float f = vertex[i] == 0.f ? 0.f : vertex[i];
+		memcpy(&key[i], &f, sizeof(f));
+	}
+}
+
+static uint32_t HashKey(const uint32_t *key) {
+	uint32_t h = 2166136261u;		// FNV-1a over the words
+	for(int i = 0; i < MESH_VERTEX_FLOATS; i++) {
+		h = (h ^ key[i]) * 16777619u;
+	}
+	return h ^ (h >> 15);
+}
+
+void WeldVertices(const float *soup, int numVerts, std::vector<float> &vertices, std::vector<uint32_t> &indices) {
+	vertices.clear();
+	indices.resize(numVerts);
+
+	// Open addressing over the unique vertices, at most half full
+	size_t tableSize = 16;
+	while(tableSize < (size_t)numVerts * 2) {
+		tableSize *= 2;
+	}
+	std::vector<uint32_t> table(tableSize, ~0u);
+	std::vector<uint32_t> keys;
+
+	uint32_t key[MESH_VERTEX_FLOATS];
+	for(int v = 0; v < numVerts; v++) {
+		const float *vertex = soup + (size_t)v * MESH_VERTEX_FLOATS;
+		VertexKey(vertex, key);
+
+		size_t slot = HashKey(key) & (tableSize - 1);
+		while(table[slot] != ~0u && memcmp(&keys[(size_t)table[slot] * MESH_VERTEX_FLOATS], key, sizeof(key)) != 0) {
+			slot = (slot + 1) & (tableSize - 1);
+		}
+
+		if(table[slot] == ~0u) {
+			table[slot] = (uint32_t)(keys.size() / MESH_VERTEX_FLOATS);
+			keys.insert(keys.end(), key, key + MESH_VERTEX_FLOATS);
+			vertices.insert(vertices.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+		}
+		indices[v] = table[slot];
+	}
+}
+
+void OptimizeVertexCache(uint32_t *indices, size_t numIndices, int numVerts, int cacheSize) {
+	size_t numTris = numIndices / 3;
+	if(numTris == 0 || numVerts == 0) {
+		return;
+	}
+
+	// Triangles around each vertex, as offsets into one array
+	std::vector<uint32_t> firstTri(numVerts + 1, 0);
+	for(size_t i = 0; i < numTris * 3; i++) {
+		firstTri[indices[i] + 1]++;
+	}
+	for(int v = 0; v < numVerts; v++) {
+		firstTri[v + 1] += firstTri[v];
+	}
+	std::vector<uint32_t> adjacency(numTris * 3);
+	std::vector<uint32_t> fill(firstTri.begin(), firstTri.end() - 1);
+	for(size_t i = 0; i < numTris * 3; i++) {
+		adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	// Triangles not emitted yet around each vertex
+	std::vector<uint32_t> live(numVerts);
+	for(int v = 0; v < numVerts; v++) {
+		live[v] = firstTri[v + 1] - firstTri[v];
+	}
+
+	std::vector<uint32_t> cacheTime(numVerts, 0);
+	std::vector<bool> emitted(numTris, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> out;
+	out.reserve(numTris * 3);
+
+	uint32_t time = cacheSize + 1;
+	int cursor = 0;
+	int fan = 0;
+	while(fan >= 0) {
+		candidates.clear();
+		for(uint32_t a = firstTri[fan]; a < firstTri[fan + 1]; a++) {
+			uint32_t tri = adjacency[a];
+			if(emitted[tri]) {
+				continue;
+			}
+			emitted[tri] = true;
+
+			for(int k = 0; k < 3; k++) {
+				uint32_t v = indices[tri * 3 + k];
+				out.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if(time - cacheTime[v] > (uint32_t)cacheSize) {
+					cacheTime[v] = time++;
+				}
+			}
+		}
+
+		// The neighbour that stays in the cache longest once its own fan is
+		// emitted, else the most recent dead end, else the next vertex in order
+		fan = -1;
+		int best = -1;
+		for(uint32_t v : candidates) {
+			if(live[v] == 0) {
+				continue;
+			}
+			int priority = 0;
+			if(time - cacheTime[v] + 2 * live[v] <= (uint32_t)cacheSize) {
+				priority = time - cacheTime[v];
+			}
+			if(priority > best) {
+				best = priority;
+				fan = v;
+			}
+		}
+		while(fan < 0 && !deadEnd.empty()) {
+			uint32_t v = deadEnd.back();
+			deadEnd.pop_back();
+			if(live[v] > 0) {
+				fan = v;
+			}
+		}
+		while(fan < 0 && cursor < numVerts) {
+			if(live[cursor] > 0) {
+				fan = cursor;
+			}
+			cursor++;
+		}
+	}
+
+	memcpy(indices, out.data(), out.size() * sizeof(uint32_t));
+}
+
+void OptimizeVertexFetch(std::vector<float> &vertices, uint32_t *indices, size_t numIndices) {
+	size_t numVerts = vertices.size() / MESH_VERTEX_FLOATS;
+	std::vector<uint32_t> remap(numVerts, ~0u);
+	std::vector<float> ordered;
+	ordered.reserve(vertices.size());
+
+	for(size_t i = 0; i < numIndices; i++) {
+		uint32_t v = indices[i];
+		if(remap[v] == ~0u) {
+			remap[v] = (uint32_t)(ordered.size() / MESH_VERTEX_FLOATS);
+			const float *vertex = vertices.data() + (size_t)v * MESH_VERTEX_FLOATS;
+			ordered.insert(ordered.end(), vertex, vertex + MESH_VERTEX_FLOATS);
+		}
+		indices[i] = remap[v];
+	}
+	vertices.swap(ordered);
+}
+
+double VertexCacheMissRatio(const uint32_t *indices, size_t numIndices, int numVerts, int cacheSize) {
+	size_t numTris = numIndices / 3;
+	if(numTris == 0) {
+		return 0.0;
+	}
+
+	// A vertex is still in the FIFO until cacheSize misses come after its own
+	std::vector<int64_t> insertedAt(numVerts, -(int64_t)cacheSize - 1);
+	int64_t misses = 0;
+	for(size_t i = 0; i < numTris * 3; i++) {
+		uint32_t v = indices[i];
+		if(misses - insertedAt[v] >= cacheSize) {
+			insertedAt[v] = ++misses;
+		}
+	}
+	return (double)misses / numTris;
+}
+
+void BuildIndexedMesh(const float *soup, int numVerts, std::vector<float> &vertices, std::vector<uint32_t> &indices) {
+	WeldVertices(soup, numVerts, vertices, indices);
+	OptimizeVertexCache(indices.data(), indices.size(), (int)(vertices.size() / MESH_VERTEX_FLOATS));
+	OptimizeVertexFetch(vertices, indices.data(), indices.size());
+}
@@ -0,0 +1,33 @@
+#ifndef MESH_OPTIMIZE_INCLUDED
+#define MESH_OPTIMIZE_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Cache size Tipsify plans for, at or below the post-transform cache of
+// current GPUs so the order degrades gracefully on larger ones
+#define MESH_CACHE_SIZE 16
+
+// Merges bit-identical vertices of a triangle soup (-0 and +0 count as equal)
+// into vertices, in order of first appearance, and writes one index per
+// soup vertex to indices
+void WeldVertices(const float *soup, int numVerts, std::vector<float> &vertices, std::vector<uint32_t> &indices);
+
+// Reorders triangles for post-transform cache locality with Tipsify
+// (Sander, Nehab and Barczak 2007): fans around each vertex, moving on to a
+// neighbour that is still in a cacheSize FIFO cache, in linear time
+void OptimizeVertexCache(uint32_t *indices, size_t numIndices, int numVerts, int cacheSize = MESH_CACHE_SIZE);
+
+// Renumbers vertices in the order the indices first use them, so the
+// vertex fetch walks memory forwards; unused vertices are dropped
+void OptimizeVertexFetch(std::vector<float> &vertices, uint32_t *indices, size_t numIndices);
+
+// Average cache miss ratio: vertices transformed per triangle with a FIFO
+// cache of cacheSize entries, 3 for a soup and 0.5 at best
+double VertexCacheMissRatio(const uint32_t *indices, size_t numIndices, int numVerts, int cacheSize = MESH_CACHE_SIZE);
+
+// Welds, orders for the cache, then for the fetch
+void BuildIndexedMesh(const float *soup, int numVerts, std::vector<float> &vertices, std::vector<uint32_t> &indices);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef PARALLEL_INCLUDED
+#define PARALLEL_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Worker count for a threads setting, where 0 means every core
+inline int ResolveThreadCount(int threads) {
+	return threads > 0 ? threads : (int)std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs fn(i) for i in [0, count) on up to threads threads, the calling
+// thread included; items are handed out one at a time
+template <typename Fn>
+void ParallelFor(int count, int threads, Fn fn) {
+	threads = std::min(threads, count);
+	if(threads <= 1) {
+		for(int i = 0; i < count; i++) {
+			fn(i);
+		}
+		return;
+	}
+
+	std::atomic<int> next(0);
+	auto worker = [&]() {
+		for(int i = next++; i < count; i = next++) {
+			fn(i);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for(int t = 1; t < threads; t++) {
+		pool.emplace_back(worker);
+	}
+	worker();
+	for(std::thread &thread : pool) {
+		thread.join();
+	}
+}
+
+#endif
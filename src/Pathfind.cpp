@@ -0,0 +1,265 @@
+#include "Pathfind.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+uint64_t PathDistance(int dx, int dy) {
+	uint64_t ax = abs(dx), ay = abs(dy);
+	uint64_t diagonal = std::min(ax, ay), straight = std::max(ax, ay) - diagonal;
+	return diagonal * PATH_COST_DIAGONAL + straight * PATH_COST_STRAIGHT;
+}
+
+bool FindTile(const TileGrid &level, int tile, int &x, int &y) {
+	for(y = 0; y < level.height; y++) {
+		for(x = 0; x < level.width; x++) {
+			if(level.At(x, y) == tile) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void Pathfinder::Init(const TileGrid *level) {
+	m_level = level;
+	m_width = level->width;
+	m_nodes.assign((size_t)level->width * level->height, Node());
+	m_open.clear();
+	m_generation = 0;
+	ClearBounds();
+}
+
+void Pathfinder::SetBounds(int x0, int y0, int x1, int y1) {
+	m_x0 = std::max(0, x0);
+	m_y0 = std::max(0, y0);
+	m_x1 = std::min(m_width, x1);
+	m_y1 = std::min(m_level->height, y1);
+}
+
+void Pathfinder::NextGeneration() {
+	// Stamps from every older generation have to go before they come around again
+	if(++m_generation >= (1u << 31)) {
+		std::fill(m_nodes.begin(), m_nodes.end(), Node());
+		m_generation = 1;
+	}
+	m_open.clear();
+}
+
+uint64_t Pathfinder::Heuristic(int x, int y) const {
+	return PathDistance(m_goalX - x, m_goalY - y);
+}
+
+// A node can be on the heap more than once, only its best entry is expanded
+void Pathfinder::Open(uint32_t node, uint64_t g, uint32_t parent) {
+	Node &n = m_nodes[node];
+	uint32_t seen = m_generation << 1;
+	if(n.stamp == seen ? g >= n.g : n.stamp == (seen | 1)) {
+		return;
+	}
+	n.stamp = seen;
+	n.g = g;
+	n.parent = parent;
+
+	int x = node % m_width, y = node / m_width;
+	m_open.push_back({ g + Heuristic(x, y), node });
+	std::push_heap(m_open.begin(), m_open.end(), std::greater<PathOpenEntry>());
+	stats.pushed++;
+}
+
+bool Pathfinder::Find(PathAlgorithm algorithm, int startX, int startY, int goalX, int goalY, std::vector<PathCell> &path) {
+	stats.queries++;
+	path.clear();
+	if(!Walkable(startX, startY) || !Walkable(goalX, goalY)) {
+		return false;
+	}
+
+	NextGeneration();
+	m_goalX = goalX;
+	m_goalY = goalY;
+
+	uint32_t start = NodeIndex(startX, startY), goal = NodeIndex(goalX, goalY);
+	Open(start, 0, start);
+
+	while(!m_open.empty()) {
+		std::pop_heap(m_open.begin(), m_open.end(), std::greater<PathOpenEntry>());
+		uint32_t node = m_open.back().node;
+		m_open.pop_back();
+
+		Node &n = m_nodes[node];
+		if(n.stamp & 1) {
+			continue;		// A stale entry of a node already expanded
+		}
+		n.stamp |= 1;
+		stats.expanded++;
+
+		if(node == goal) {
+			break;
+		}
+		int x = node % m_width, y = node / m_width;
+		if(algorithm == PATH_JPS) {
+			ExpandJps(x, y, n.g, node);
+		}
+		else {
+			ExpandAStar(x, y, n.g, node);
+		}
+	}
+
+	if(m_nodes[goal].stamp != ((m_generation << 1) | 1)) {
+		return false;
+	}
+	stats.found++;
+	m_cost = m_nodes[goal].g;
+
+	// Back from the goal, filling in the cells between jump points
+	for(uint32_t node = goal;; node = m_nodes[node].parent) {
+		int x = node % m_width, y = node / m_width;
+		uint32_t parent = m_nodes[node].parent;
+		int px = parent % m_width, py = parent / m_width;
+		int dx = (px > x) - (px < x), dy = (py > y) - (py < y);
+		do {
+			path.push_back({ x, y });
+			x += dx;
+			y += dy;
+		} while(x != px || y != py);
+		if(node == start) {
+			break;
+		}
+	}
+	std::reverse(path.begin(), path.end());
+
+	return true;
+}
+
+void Pathfinder::ExpandAStar(int x, int y, uint64_t g, uint32_t node) {
+	for(int dy = -1; dy <= 1; dy++) {
+		for(int dx = -1; dx <= 1; dx++) {
+			if((dx == 0 && dy == 0) || !Walkable(x + dx, y + dy)) {
+				continue;
+			}
+			if(dx != 0 && dy != 0 && (!Walkable(x + dx, y) || !Walkable(x, y + dy))) {
+				continue;
+			}
+			Open(NodeIndex(x + dx, y + dy), g + (dx && dy ? PATH_COST_DIAGONAL : PATH_COST_STRAIGHT), node);
+		}
+	}
+}
+
+// Only the neighbours an optimal path through this node can continue to,
+// each followed to its next jump point
+void Pathfinder::ExpandJps(int x, int y, uint64_t g, uint32_t node) {
+	const Node &n = m_nodes[node];
+	int px = n.parent % m_width, py = n.parent / m_width;
+	int pdx = (x > px) - (x < px), pdy = (y > py) - (y < py);
+
+	int dirs[8][2];
+	int numDirs = 0;
+	auto add = [&](int dx, int dy) {
+		dirs[numDirs][0] = dx;
+		dirs[numDirs][1] = dy;
+		numDirs++;
+	};
+
+	if(pdx == 0 && pdy == 0) {
+		// The start, every direction
+		for(int dy = -1; dy <= 1; dy++) {
+			for(int dx = -1; dx <= 1; dx++) {
+				if(dx || dy) {
+					add(dx, dy);
+				}
+			}
+		}
+	}
+	else if(pdx != 0 && pdy != 0) {
+		add(pdx, 0);
+		add(0, pdy);
+		add(pdx, pdy);
+	}
+	else if(pdx != 0) {
+		add(pdx, 0);
+		// Turns past a wall that ended behind us
+		if(Walkable(x, y + 1)) {
+			add(0, 1);
+			add(pdx, 1);
+		}
+		if(Walkable(x, y - 1)) {
+			add(0, -1);
+			add(pdx, -1);
+		}
+	}
+	else {
+		add(0, pdy);
+		if(Walkable(x + 1, y)) {
+			add(1, 0);
+			add(1, pdy);
+		}
+		if(Walkable(x - 1, y)) {
+			add(-1, 0);
+			add(-1, pdy);
+		}
+	}
+
+	for(int i = 0; i < numDirs; i++) {
+		int dx = dirs[i][0], dy = dirs[i][1];
+		if(!Walkable(x + dx, y + dy)) {
+			continue;
+		}
+		int jump;
+		if(dx != 0 && dy != 0) {
+			if(!Walkable(x + dx, y) || !Walkable(x, y + dy)) {
+				continue;
+			}
+			jump = JumpDiagonal(x + dx, y + dy, dx, dy);
+		}
+		else {
+			jump = JumpStraight(x + dx, y + dy, dx, dy);
+		}
+		if(jump >= 0) {
+			int jx = jump % m_width, jy = jump / m_width;
+			Open(jump, g + PathDistance(jx - x, jy - y), node);
+		}
+	}
+}
+
+// Walks from (x, y) until the next jump point, -1 if a wall comes first
+int Pathfinder::JumpStraight(int x, int y, int dx, int dy) const {
+	for(;; x += dx, y += dy) {
+		if(!Walkable(x, y)) {
+			return -1;
+		}
+		if(x == m_goalX && y == m_goalY) {
+			return NodeIndex(x, y);
+		}
+
+		// A side opening that was walled off one cell back
+		if(dx != 0) {
+			if((Walkable(x, y - 1) && !Walkable(x - dx, y - 1)) || (Walkable(x, y + 1) && !Walkable(x - dx, y + 1))) {
+				return NodeIndex(x, y);
+			}
+		}
+		else {
+			if((Walkable(x - 1, y) && !Walkable(x - 1, y - dy)) || (Walkable(x + 1, y) && !Walkable(x + 1, y - dy))) {
+				return NodeIndex(x, y);
+			}
+		}
+	}
+}
+
+int Pathfinder::JumpDiagonal(int x, int y, int dx, int dy) const {
+	for(;;) {
+		if(!Walkable(x, y)) {
+			return -1;
+		}
+		if(x == m_goalX && y == m_goalY) {
+			return NodeIndex(x, y);
+		}
+		if(JumpStraight(x + dx, y, dx, 0) >= 0 || JumpStraight(x, y + dy, 0, dy) >= 0) {
+			return NodeIndex(x, y);
+		}
+		if(!Walkable(x + dx, y) || !Walkable(x, y + dy)) {
+			return -1;
+		}
+		x += dx;
+		y += dy;
+	}
+}
@@ -0,0 +1,108 @@
+#ifndef PATHFIND_INCLUDED
+#define PATHFIND_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "TileGrid.hpp"
+
+enum PathAlgorithm {
+	PATH_ASTAR,
+	PATH_JPS			// Jump point search, same paths with far fewer nodes on open ground
+};
+
+// Octile costs in integers, so both algorithms agree on them exactly
+#define PATH_COST_STRAIGHT 1000
+#define PATH_COST_DIAGONAL 1414
+
+struct PathCell {
+	int		x;
+	int		y;
+};
+
+// Open list entry, ordered by f then node; f gets 64 bits of its own since
+// long paths in PATH_COST_* units overflow 32
+struct PathOpenEntry {
+	uint64_t	f;
+	uint32_t	node;
+
+	bool operator>(const PathOpenEntry &other) const {
+		return f != other.f ? f > other.f : node > other.node;
+	}
+};
+
+struct PathStats {
+	long long	queries = 0;
+	long long	found = 0;
+	long long	expanded = 0;		// Nodes taken off the open list
+	long long	pushed = 0;
+};
+
+// Shortest paths over the walkable cells of a level, every cell that is
+// not a wall, moving to any of the eight neighbours; diagonal moves need
+// both cells beside them free, so paths never cut a wall corner
+// Node arrays are stamped with a generation per query instead of cleared,
+// so repeated queries never touch or reallocate more than they visit
+class Pathfinder {
+public:
+	Pathfinder() {}
+
+	// level is only read, and has to outlive the pathfinder
+	void Init(const TileGrid *level);
+
+	// Every cell from start to goal, both included; false if there is no path
+	bool Find(PathAlgorithm algorithm, int startX, int startY, int goalX, int goalY, std::vector<PathCell> &path);
+
+	// Of the last path found, in PATH_COST_* units
+	uint64_t Cost() const { return m_cost; }
+
+	// Searches only see the cells of [x0, x1) x [y0, y1), the whole level until set
+	void SetBounds(int x0, int y0, int x1, int y1);
+	void ClearBounds() { SetBounds(0, 0, m_width, m_level->height); }
+
+	bool Walkable(int x, int y) const {
+		return x >= m_x0 && y >= m_y0 && x < m_x1 && y < m_y1 && !m_level->IsWall(x, y);
+	}
+
+	PathStats	stats;
+
+private:
+	struct Node {
+		uint32_t	stamp;			// m_generation << 1 once seen, | 1 once closed
+		uint32_t	parent;
+		uint64_t	g;
+	};
+
+	void NextGeneration();
+	void Open(uint32_t node, uint64_t g, uint32_t parent);
+	uint64_t Heuristic(int x, int y) const;
+
+	void ExpandAStar(int x, int y, uint64_t g, uint32_t node);
+	void ExpandJps(int x, int y, uint64_t g, uint32_t node);
+	int JumpStraight(int x, int y, int dx, int dy) const;
+	int JumpDiagonal(int x, int y, int dx, int dy) const;
+
+	uint32_t NodeIndex(int x, int y) const { return (uint32_t)y * m_width + x; }
+
+	const TileGrid				*m_level = nullptr;
+	int							m_width = 0;
+	int							m_x0 = 0;
+	int							m_y0 = 0;
+	int							m_x1 = 0;
+	int							m_y1 = 0;
+	int							m_goalX = 0;
+	int							m_goalY = 0;
+	uint64_t					m_cost = 0;
+
+	std::vector<Node>			m_nodes;
+	std::vector<PathOpenEntry>	m_open;			// Binary min-heap
+	uint32_t					m_generation = 0;
+};
+
+// Octile distance in PATH_COST_* units
+uint64_t PathDistance(int dx, int dy);
+
+// First cell holding tile in row-major order, false if there is none
+bool FindTile(const TileGrid &level, int tile, int &x, int &y);
+
+#endif
@@ -0,0 +1,250 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Written by its thread, drained by the collector
+struct ProfileRing {
+	ProfileEvent			events[PROFILER_RING_EVENTS];
+	std::atomic<uint32_t>	head{0};
+	std::atomic<uint32_t>	tail{0};
+	std::atomic<uint64_t>	dropped{0};
+	std::atomic<bool>		owned{true};
+
+	int						track = 0;
+	std::string				name;
+};
+
+struct TraceEvent {
+	ProfileEvent	event;
+	int				track;
+};
+
+static const std::chrono::steady_clock::time_point profilerEpoch = std::chrono::steady_clock::now();
+static std::atomic<bool> profilerEnabled{false};
+
+// Rings outlive their threads, a thread that exits leaves its ring to the next new one
+static std::mutex profilerMutex;
+static std::vector<std::unique_ptr<ProfileRing>> profilerRings;
+static int profilerNextTrack = PROFILER_GPU_TRACK + 1;
+
+// Only touched under profilerMutex
+static std::vector<TraceEvent> traceEvents;
+static ProfilerCounts profilerCounts;
+
+// Main thread only
+static double frameTimes[PROFILER_SUMMARY_FRAMES];
+static int numFrameTimes = 0;
+static int nextFrameTime = 0;
+static uint64_t frameBegin = 0;
+static uint64_t lastFrameEnd = 0;
+
+// Hands the ring back when the thread exits
+struct RingOwner {
+	ProfileRing	*ring = nullptr;
+
+	~RingOwner() {
+		if(ring) {
+			ring->owned.store(false, std::memory_order_release);
+		}
+	}
+};
+
+static thread_local RingOwner threadRing;
+static thread_local std::string threadName;		// Set before the thread recorded anything
+
+static ProfileRing *ThreadRing() {
+	if(threadRing.ring) {
+		return threadRing.ring;
+	}
+
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	ProfileRing *ring = nullptr;
+	for(const std::unique_ptr<ProfileRing> &r : profilerRings) {
+		if(!r->owned.load(std::memory_order_acquire)
+			&& r->head.load(std::memory_order_relaxed) == r->tail.load(std::memory_order_relaxed)) {
+			ring = r.get();
+			ring->owned.store(true, std::memory_order_relaxed);
+			break;
+		}
+	}
+	if(!ring) {
+		profilerRings.emplace_back(new ProfileRing());
+		ring = profilerRings.back().get();
+	}
+	ring->track = profilerNextTrack++;
+	ring->name = threadName.empty() ? "Thread " + std::to_string(ring->track) : threadName;
+	threadRing.ring = ring;
+	return ring;
+}
+
+void ProfilerEnable(bool enable) {
+	profilerEnabled.store(enable, std::memory_order_relaxed);
+}
+
+bool ProfilerEnabled() {
+	return profilerEnabled.load(std::memory_order_relaxed);
+}
+
+uint64_t ProfilerNow() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profilerEpoch).count();
+}
+
+// Kept until the thread records its first zone, so threads that never do
+// take no ring
+void ProfilerSetThreadName(const char *name) {
+	threadName = name;
+	if(threadRing.ring) {
+		std::lock_guard<std::mutex> lock(profilerMutex);
+		threadRing.ring->name = name;
+	}
+}
+
+void ProfilerRecord(const ProfileEvent &event) {
+	ProfileRing *ring = ThreadRing();
+	uint32_t head = ring->head.load(std::memory_order_relaxed);
+	if(head - ring->tail.load(std::memory_order_acquire) >= PROFILER_RING_EVENTS) {
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	ring->events[head % PROFILER_RING_EVENTS] = event;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+static void AddTraceEvent(const ProfileEvent &event, int track) {
+	profilerCounts.zones++;
+	if(traceEvents.size() < PROFILER_MAX_TRACE_EVENTS) {
+		traceEvents.push_back({ event, track });
+	}
+	else {
+		profilerCounts.untraced++;
+	}
+}
+
+void ProfilerAddEvent(const ProfileEvent &event, int track) {
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	AddTraceEvent(event, track);
+}
+
+static void Collect() {
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	for(const std::unique_ptr<ProfileRing> &ring : profilerRings) {
+		uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+		uint32_t head = ring->head.load(std::memory_order_acquire);
+		for(; tail != head; tail++) {
+			AddTraceEvent(ring->events[tail % PROFILER_RING_EVENTS], ring->track);
+		}
+		ring->tail.store(tail, std::memory_order_release);
+		profilerCounts.dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+	}
+}
+
+void ProfilerBeginFrame() {
+	frameBegin = ProfilerNow();
+}
+
+void ProfilerEndFrame() {
+	uint64_t now = ProfilerNow();
+	if(ProfilerEnabled()) {
+		ProfilerRecord({ "Frame", frameBegin, now });
+	}
+	Collect();
+
+	// End to end, so time spent between frames is counted too
+	if(lastFrameEnd > 0) {
+		frameTimes[nextFrameTime] = (now - lastFrameEnd) / 1e6;
+		nextFrameTime = (nextFrameTime + 1) % PROFILER_SUMMARY_FRAMES;
+		numFrameTimes = std::min(numFrameTimes + 1, PROFILER_SUMMARY_FRAMES);
+	}
+	lastFrameEnd = now;
+}
+
+FrameTimeSummary ProfilerFrameSummary() {
+	FrameTimeSummary summary;
+	if(numFrameTimes == 0) {
+		return summary;
+	}
+
+	std::vector<double> times(frameTimes, frameTimes + numFrameTimes);
+	double total = 0.0;
+	for(double ms : times) {
+		total += ms;
+	}
+	summary.frames = numFrameTimes;
+	summary.avgMs = total / numFrameTimes;
+	summary.minMs = *std::min_element(times.begin(), times.end());
+	summary.maxMs = *std::max_element(times.begin(), times.end());
+
+	// Nearest rank, so a single slow frame in a hundred shows up
+	size_t rank = (times.size() * 99 + 99) / 100 - 1;
+	std::nth_element(times.begin(), times.begin() + rank, times.end());
+	summary.p99Ms = times[rank];
+	return summary;
+}
+
+ProfilerCounts ProfilerGetCounts() {
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	ProfilerCounts counts = profilerCounts;
+	for(const std::unique_ptr<ProfileRing> &ring : profilerRings) {
+		counts.dropped += ring->dropped.load(std::memory_order_relaxed);
+	}
+	return counts;
+}
+
+static void WriteJsonString(std::ostream &out, const char *s) {
+	out << '"';
+	for(; *s; s++) {
+		if(*s == '"' || *s == '\\') {
+			out << '\\';
+		}
+		if((unsigned char)*s >= 0x20) {
+			out << *s;
+		}
+	}
+	out << '"';
+}
+
+bool ProfilerWriteTrace(const char *fileName) {
+	Collect();
+
+	std::ofstream out(fileName, std::ios::trunc);
+	if(!out.is_open()) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << PROFILER_GPU_TRACK << ",\"args\":{\"name\":\"GPU\"}}";
+	for(const std::unique_ptr<ProfileRing> &ring : profilerRings) {
+		out << ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << ring->track << ",\"args\":{\"name\":";
+		WriteJsonString(out, ring->name.c_str());
+		out << "}}";
+	}
+
+	// Complete events in microseconds, nested by their times
+	char number[32];
+	for(const TraceEvent &trace : traceEvents) {
+		out << ",\n{\"ph\":\"X\",\"name\":";
+		WriteJsonString(out, trace.event.name);
+		snprintf(number, sizeof(number), "%.3f", trace.event.begin / 1e3);
+		out << ",\"pid\":1,\"tid\":" << trace.track << ",\"ts\":" << number;
+		snprintf(number, sizeof(number), "%.3f", (trace.event.end - trace.event.begin) / 1e3);
+		out << ",\"dur\":" << number << "}";
+	}
+	out << "\n]}\n";
+	return (bool)out;
+}
+
+void ProfilerClearTrace() {
+	Collect();
+	std::lock_guard<std::mutex> lock(profilerMutex);
+	traceEvents.clear();
+	profilerCounts = ProfilerCounts();
+}
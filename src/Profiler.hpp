@@ -0,0 +1,99 @@
+#ifndef PROFILER_INCLUDED
+#define PROFILER_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+
+#define PROFILER_RING_EVENTS (1 << 15)		// Per thread, zones beyond what the next collect drains are dropped
+#define PROFILER_MAX_TRACE_EVENTS (1 << 20)	// Kept for the trace, later ones are only counted
+#define PROFILER_SUMMARY_FRAMES 600			// Frame times the summary rolls over
+#define PROFILER_GPU_TRACK 0				// Track of GPU zones in the trace, threads count up from 1
+
+// One zone, times in nanoseconds on ProfilerNow's clock
+struct ProfileEvent {
+	const char	*name;		// A string literal, only the pointer is kept
+	uint64_t	begin;
+	uint64_t	end;
+};
+
+// Frame times over the last PROFILER_SUMMARY_FRAMES frames, in ms
+struct FrameTimeSummary {
+	int		frames = 0;
+	double	minMs = 0.0;
+	double	avgMs = 0.0;
+	double	p99Ms = 0.0;
+	double	maxMs = 0.0;
+};
+
+struct ProfilerCounts {
+	long long	zones = 0;			// Collected from every thread
+	long long	dropped = 0;		// Lost to full rings
+	long long	untraced = 0;		// Past PROFILER_MAX_TRACE_EVENTS
+};
+
+// Scoped CPU zones: each thread records into a ring of its own, without
+// locks, and the main thread drains every ring once a frame
+// Zones are only recorded while the profiler is enabled; frame times and
+// their summary are kept either way
+void ProfilerEnable(bool enable);
+bool ProfilerEnabled();
+
+// Nanoseconds since the profiler's clock started
+uint64_t ProfilerNow();
+
+// Runs fn once and returns how long it took, in milliseconds
+template <typename Fn>
+inline double TimeMs(Fn fn) {
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Names the calling thread's track in the trace
+void ProfilerSetThreadName(const char *name);
+
+void ProfilerRecord(const ProfileEvent &event);
+
+// A zone recorded on another clock or thread, such as the GPU
+void ProfilerAddEvent(const ProfileEvent &event, int track);
+
+// Around each frame on the main thread, ProfilerEndFrame drains the rings
+void ProfilerBeginFrame();
+void ProfilerEndFrame();
+
+FrameTimeSummary ProfilerFrameSummary();
+ProfilerCounts ProfilerGetCounts();
+
+// Every zone collected since the start or the last clear, in Chrome's
+// trace event format (chrome://tracing, Perfetto)
+bool ProfilerWriteTrace(const char *fileName);
+void ProfilerClearTrace();
+
+class ProfileScope {
+public:
+	explicit ProfileScope(const char *name) : m_name(ProfilerEnabled() ? name : nullptr) {
+		if(m_name) {
+			m_begin = ProfilerNow();
+		}
+	}
+	~ProfileScope() {
+		if(m_name) {
+			ProfilerRecord({ m_name, m_begin, ProfilerNow() });
+		}
+	}
+
+	ProfileScope(const ProfileScope &) = delete;
+	ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+	const char	*m_name;
+	uint64_t	m_begin = 0;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Times the rest of the enclosing block, name has to be a string literal
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+#endif
@@ -0,0 +1,308 @@
+#include "Pvs.hpp"
+#include "Parallel.hpp"
+#include "SceneFile.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void PutVarint(std::vector<uint8_t> &out, uint32_t value) {
+	while(value >= 0x80) {
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+// Stops at end, so a truncated varint in a damaged file reads no further
+static uint32_t GetVarint(const uint8_t *&in, const uint8_t *end) {
+	uint32_t value = 0;
+	for(int shift = 0; in < end && shift < 32; shift += 7) {
+		uint8_t byte = *in++;
+		value |= (uint32_t)(byte & 0x7f) << shift;
+		if(!(byte & 0x80)) {
+			break;
+		}
+	}
+	return value;
+}
+
+uint64_t HashLevelWalls(const TileGrid &level) {
+	uint64_t hash = 1469598103934665603ull;
+	hash = (hash ^ (uint64_t)level.width) * 1099511628211ull;
+	hash = (hash ^ (uint64_t)level.height) * 1099511628211ull;
+	for(int y = 0; y < level.height; y++) {
+		for(int x = 0; x < level.width; x++) {
+			hash = (hash ^ (uint64_t)level.IsWall(x, y)) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+std::string PvsFileName(const char *sceneFile) {
+	return SceneSideFileName(sceneFile, ".pvs");
+}
+
+Pvs::~Pvs() {
+	Release();
+}
+
+void Pvs::Release() {
+	if(m_mapping) {
+		munmap(m_mapping, m_mappingSize);
+		m_mapping = nullptr;
+		m_mappingSize = 0;
+	}
+	m_builtOffsets.clear();
+	m_builtData.clear();
+	m_offsets = nullptr;
+	m_data = nullptr;
+	m_dataSize = 0;
+}
+
+long long Pvs::RawBytes() const {
+	long long window = WindowSize();
+	return (long long)NumRegions() * ((window * window + 7) / 8);
+}
+
+void Pvs::Build(const TileGrid &level, int regionCells, int visibilityRadius, int threads) {
+	Release();
+
+	width = level.width;
+	height = level.height;
+	regionSize = regionCells;
+	radius = visibilityRadius;
+	regionsX = (width + regionSize - 1) / regionSize;
+	regionsY = (height + regionSize - 1) / regionSize;
+	levelHash = HashLevelWalls(level);
+
+	int numRegions = NumRegions();
+	int window = WindowSize();
+	std::vector<std::vector<uint8_t>> encoded(numRegions);
+
+	ParallelFor(numRegions, ResolveThreadCount(threads), [&](int region) {
+		int x0 = (region % regionsX) * regionSize;
+		int y0 = (region / regionsX) * regionSize;
+		int originX = x0 - radius, originY = y0 - radius;
+
+		// Union of the sets seen from every eye sample in the region
+		std::vector<uint8_t> visible((size_t)window * window, 0);
+		GridVisibility visibility;
+		for(int y = y0; y < std::min(y0 + regionSize, height); y++) {
+			for(int x = x0; x < std::min(x0 + regionSize, width); x++) {
+				if(level.IsWall(x, y)) {
+					continue;
+				}
+
+				for(int sy = 0; sy < PVS_SAMPLES; sy++) {
+					for(int sx = 0; sx < PVS_SAMPLES; sx++) {
+						float eyeX = x - 0.49f + 0.98f * sx / (PVS_SAMPLES - 1);
+						float eyeY = y - 0.49f + 0.98f * sy / (PVS_SAMPLES - 1);
+						visibility.Compute(level, eyeX, eyeY, radius);
+
+						int size = visibility.WindowSize();
+						for(int wy = 0; wy < size; wy++) {
+							for(int wx = 0; wx < size; wx++) {
+								int cx = visibility.OriginX() + wx, cy = visibility.OriginY() + wy;
+								if(visibility.IsVisible(cx, cy)) {
+									visible[(size_t)(cy - originY) * window + (cx - originX)] = 1;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Alternating runs, starting with an invisible one
+		std::vector<uint8_t> &out = encoded[region];
+		uint8_t current = 0;
+		uint32_t run = 0;
+		for(uint8_t bit : visible) {
+			if(bit != current) {
+				PutVarint(out, run);
+				current = bit;
+				run = 0;
+			}
+			run++;
+		}
+		if(current) {
+			PutVarint(out, run);
+		}
+	});
+
+	m_builtOffsets.resize(numRegions + 1);
+	size_t total = 0;
+	for(int i = 0; i < numRegions; i++) {
+		m_builtOffsets[i] = (uint32_t)total;
+		total += encoded[i].size();
+	}
+	m_builtOffsets[numRegions] = (uint32_t)total;
+
+	m_builtData.reserve(total);
+	for(const std::vector<uint8_t> &region : encoded) {
+		m_builtData.insert(m_builtData.end(), region.begin(), region.end());
+	}
+
+	m_offsets = m_builtOffsets.data();
+	m_data = m_builtData.data();
+	m_dataSize = m_builtData.size();
+}
+
+bool Pvs::Save(const char *fileName) const {
+	if(!Loaded() || m_dataSize > UINT32_MAX) {
+		return false;
+	}
+
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		return false;
+	}
+
+	PvsHeader header;
+	header.magic = PVS_MAGIC;
+	header.version = PVS_VERSION;
+	header.width = width;
+	header.height = height;
+	header.regionSize = regionSize;
+	header.radius = radius;
+	header.regionsX = regionsX;
+	header.regionsY = regionsY;
+	header.levelHash = levelHash;
+	header.offsetsOffset = sizeof(PvsHeader);
+	header.dataOffset = header.offsetsOffset + (NumRegions() + 1) * sizeof(uint32_t);
+	header.dataSize = m_dataSize;
+
+	out.write((const char *)&header, sizeof(header));
+	out.write((const char *)m_offsets, (NumRegions() + 1) * sizeof(uint32_t));
+	out.write((const char *)m_data, m_dataSize);
+
+	return (bool)out;
+}
+
+// Everything the header claims has to agree with itself and fit in the file
+static bool ValidLayout(const PvsHeader &header, size_t fileSize) {
+	if(header.magic != PVS_MAGIC || header.version != PVS_VERSION) {
+		return false;
+	}
+	if(header.width == 0 || header.width > INT_MAX || header.height == 0 || header.height > INT_MAX
+		|| header.regionSize == 0 || (uint64_t)header.regionSize + 2ull * header.radius > PVS_MAX_WINDOW) {
+		return false;
+	}
+	if(header.regionsX != (header.width + (uint64_t)header.regionSize - 1) / header.regionSize
+		|| header.regionsY != (header.height + (uint64_t)header.regionSize - 1) / header.regionSize) {
+		return false;
+	}
+
+	// Region counts are bounded by the file size before anything is multiplied out
+	uint64_t numRegions = (uint64_t)header.regionsX * header.regionsY;
+	if(header.offsetsOffset < sizeof(PvsHeader) || header.offsetsOffset % sizeof(uint32_t) != 0
+		|| header.offsetsOffset > fileSize || numRegions >= (fileSize - header.offsetsOffset) / sizeof(uint32_t)) {
+		return false;
+	}
+	return header.offsetsOffset + (numRegions + 1) * sizeof(uint32_t) <= header.dataOffset
+		&& header.dataOffset <= fileSize && header.dataSize <= fileSize - header.dataOffset;
+}
+
+// Each region's runs lie between its offset and the next one, inside the data
+static bool ValidOffsets(const uint32_t *offsets, uint64_t numRegions, uint64_t dataSize) {
+	for(uint64_t i = 0; i < numRegions; i++) {
+		if(offsets[i] > offsets[i + 1]) {
+			return false;
+		}
+	}
+	return offsets[numRegions] <= dataSize;
+}
+
+bool Pvs::Load(const char *fileName) {
+	Release();
+
+	int fd = open(fileName, O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(PvsHeader)) {
+		close(fd);
+		return false;
+	}
+
+	size_t fileSize = st.st_size;
+	void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED) {
+		std::cerr << "Failed to map PVS file " << fileName << std::endl;
+		return false;
+	}
+
+	const PvsHeader *header = (const PvsHeader *)mapping;
+	if(!ValidLayout(*header, fileSize)
+		|| !ValidOffsets((const uint32_t *)((const char *)mapping + header->offsetsOffset), header->regionsX * header->regionsY, header->dataSize)) {
+		std::cerr << "Invalid or outdated PVS file " << fileName << std::endl;
+		munmap(mapping, fileSize);
+		return false;
+	}
+
+	m_mapping = mapping;
+	m_mappingSize = fileSize;
+
+	width = header->width;
+	height = header->height;
+	regionSize = header->regionSize;
+	radius = header->radius;
+	regionsX = header->regionsX;
+	regionsY = header->regionsY;
+	levelHash = header->levelHash;
+
+	m_offsets = (const uint32_t *)((const char *)mapping + header->offsetsOffset);
+	m_data = (const uint8_t *)mapping + header->dataOffset;
+	m_dataSize = header->dataSize;
+
+	return true;
+}
+
+bool Pvs::Matches(const TileGrid &level) const {
+	return Loaded() && level.width == width && level.height == height && HashLevelWalls(level) == levelHash;
+}
+
+bool Pvs::Lookup(float eyeX, float eyeY, GridVisibility &visibility) const {
+	int x = (int)floorf(eyeX + 0.5f), y = (int)floorf(eyeY + 0.5f);
+	if(!Loaded() || x < 0 || y < 0 || x >= width || y >= height) {
+		return false;
+	}
+
+	int rx = x / regionSize, ry = y / regionSize;
+	int region = ry * regionsX + rx;
+	int window = WindowSize();
+	visibility.Reset(rx * regionSize - radius, ry * regionSize - radius, window);
+
+	const uint8_t *in = m_data + m_offsets[region];
+	const uint8_t *end = m_data + m_offsets[region + 1];
+	size_t pos = 0;
+	while(in < end) {
+		pos += GetVarint(in, end);
+		if(in >= end) {
+			break;
+		}
+		size_t visibleEnd = std::min(pos + GetVarint(in, end), (size_t)window * window);
+
+		// A run of visible cells can wrap over several window rows
+		while(pos < visibleEnd) {
+			int wy = pos / window, wx = pos % window;
+			int count = std::min((size_t)(window - wx), visibleEnd - pos);
+			visibility.MarkRow(visibility.OriginY() + wy, visibility.OriginX() + wx, visibility.OriginX() + wx + count);
+			pos += count;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,104 @@
+#ifndef PVS_INCLUDED
+#define PVS_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TileGrid.hpp"
+#include "GridVisibility.hpp"
+
+#define PVS_MAGIC 0x31535650		// "PVS1" in little endian
+#define PVS_VERSION 1
+#define PVS_REGION_SIZE 4			// Cells per side of a region sharing one visible set
+#define PVS_SAMPLES 3				// Eye samples per side of each cell
+#define PVS_MAX_WINDOW 4096			// Largest regionSize + 2 * radius, bounds a lookup's window
+
+// Header at the start of every .pvs file
+// offsets[regionsX * regionsY + 1] (uint32_t, relative to dataOffset) start
+// at offsetsOffset, the run-length coded sets at dataOffset
+struct PvsHeader {
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	regionSize;
+	uint32_t	radius;
+	uint32_t	regionsX;
+	uint32_t	regionsY;
+	uint64_t	levelHash;
+	uint64_t	offsetsOffset;
+	uint64_t	dataOffset;
+	uint64_t	dataSize;
+};
+
+// Precomputed potentially visible sets, one per square region of cells
+// A region's set is the union of GridVisibility from a grid of eye samples
+// in each of its open cells, over a window reaching radius cells past the
+// region. Sets are stored as alternating runs of invisible and visible
+// cells in window row-major order, each run length a LEB128 varint
+// The eye samples make the sets approximate: a cell seen only from between
+// samples can be missing, so GridVisibility stays the default at runtime
+class Pvs {
+public:
+	Pvs() {}
+	~Pvs();
+
+	Pvs(const Pvs &) = delete;
+	Pvs &operator=(const Pvs &) = delete;
+
+	// Offline, threads 0 uses every core
+	void Build(const TileGrid &level, int regionSize, int visibilityRadius, int threads);
+
+	bool Save(const char *fileName) const;
+
+	// Maps a file written by Save
+	bool Load(const char *fileName);
+	void Release();
+
+	// True if the sets were built for this exact wall layout
+	bool Matches(const TileGrid &level) const;
+
+	// Finds the eye's region in O(1) and decodes its set into visibility
+	// Fails if the eye is outside the level or nothing is loaded
+	bool Lookup(float eyeX, float eyeY, GridVisibility &visibility) const;
+
+	bool Loaded() const { return m_offsets != nullptr; }
+
+	int NumRegions() const { return regionsX * regionsY; }
+	size_t CompressedBytes() const { return m_dataSize + (NumRegions() + 1) * sizeof(uint32_t); }
+
+	// One bit per window cell per region, for comparison
+	long long RawBytes() const;
+
+	int			width = 0;
+	int			height = 0;
+	int			regionSize = 0;
+	int			radius = 0;
+	int			regionsX = 0;
+	int			regionsY = 0;
+	uint64_t	levelHash = 0;
+
+private:
+	int WindowSize() const { return regionSize + 2 * radius; }
+
+	// Built in memory, or pointing into the mapping
+	std::vector<uint32_t>	m_builtOffsets;
+	std::vector<uint8_t>	m_builtData;
+
+	const uint32_t	*m_offsets = nullptr;
+	const uint8_t	*m_data = nullptr;
+	size_t			m_dataSize = 0;
+
+	void			*m_mapping = nullptr;
+	size_t			m_mappingSize = 0;
+};
+
+// FNV-1a over the wall layout, to tell whether a .pvs is stale
+uint64_t HashLevelWalls(const TileGrid &level);
+
+// The .pvs file stored next to a scenefile ("maps/a.txt" -> "maps/a.pvs")
+std::string PvsFileName(const char *sceneFile);
+
+#endif
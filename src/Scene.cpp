@@ -1,9 +1,51 @@
 #include "Scene.hpp"
+#include "SceneFile.hpp"
+
 #include <iostream>
+#include <vector>
 
 Scene::~Scene() {
-	delete[] modelData;
-	modelData = nullptr;
-	delete[] level;
-	level = nullptr;
-}
\ No newline at end of file
+}
+
+bool Scene::LoadLevel(const char *fileName) {
+	SceneFileReader reader;
+	if(!reader.Open(fileName)) {
+		std::cerr << fileName << ": " << reader.Error() << std::endl;
+		return false;
+	}
+
+	int width = reader.width;
+	int height = reader.height;
+	level.Resize(width, height);
+
+	std::vector<char> row(width);
+	for(int i = 0; i < height; i++) {
+		if(!reader.ReadRow(row.data())) {
+			std::cerr << fileName << ": " << reader.Error() << std::endl;
+			return false;
+		}
+
+		for(int j = 0; j < width; j++) {
+			int tile = TileFromChar(row[j]);
+			if(tile == LEVEL_SPAWN) {
+				tile = LEVEL_AIR;
+				player.origin = Vec3f(j, i, 0);
+			}
+			level.Set(j, i, tile);
+		}
+	}
+
+	return true;
+}
+
+bool Scene::GenerateLevel(const MazeGenConfig &config) {
+	if(!GenerateMaze(config, level)) {
+		return false;
+	}
+
+	// GenerateMaze always puts the spawn in the first room
+	level.Set(1, 1, LEVEL_AIR);
+	player.origin = Vec3f(1, 1, 0);
+
+	return true;
+}
@@ -4,6 +4,14 @@
 #define MAX_SCENE_MODELS 5
 
 #include "Math.hpp"
+#include "MazeGen.hpp"
+#include "Mesh.hpp"
+#include "TileGrid.hpp"
+
+enum {
+	MODEL_CUBE,
+	MODEL_KEY
+};
 
 struct Player {
 	Vec3f	origin;
@@ -11,8 +19,8 @@ struct Player {
 
 	Vec3f	wishDir;
 
-	float	yaw;
-	float	pitch;
+	float	yaw = 0.f;
+	float	pitch = 0.f;
 };
 
 class Scene {
@@ -20,14 +28,19 @@ public:
 	Scene() {}
 	~Scene();
 
-	float	*modelData = nullptr;
-	int		numVerts = 0;
-	int		startVerts[MAX_SCENE_MODELS];
-	int		numModels = 0;
+	// Reads a scenefile into level
+	bool LoadLevel(const char *fileName);
+
+	// Fills level with a procedural maze
+	bool GenerateLevel(const MazeGenConfig &config);
 
-	int		width, height;
+	Mesh		models[MAX_SCENE_MODELS];
+	MeshRange	modelRanges[MAX_SCENE_MODELS];		// In the shared vertex and index buffers
+	int			numVerts = 0;
+	size_t		numIndexBytes = 0;
+	int			numModels = 0;
 
-	int		*level = nullptr;
+	TileGrid	level;
 
 	float deltaTime = 0;
 
@@ -0,0 +1,287 @@
+#include "SceneFile.hpp"
+#include "Scene.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Lookup table from cell character to tile, built once
+struct TileTable {
+	signed char tiles[256];
+
+	TileTable() {
+		memset(tiles, -1, sizeof(tiles));
+		tiles[(unsigned char)'0'] = LEVEL_AIR;
+		tiles[(unsigned char)'S'] = LEVEL_SPAWN;
+		tiles[(unsigned char)'W'] = LEVEL_WALL;
+		tiles[(unsigned char)'G'] = LEVEL_GOAL;
+		tiles[(unsigned char)'K'] = LEVEL_KEY;
+		tiles[(unsigned char)'D'] = LEVEL_DOOR;
+	}
+};
+
+static const TileTable tileTable;
+
+int TileFromChar(char c) {
+	return tileTable.tiles[(unsigned char)c];
+}
+
+char CharFromTile(int tile) {
+	static const char chars[] = { '0', 'S', 'W', 'G', 'K', 'D' };
+	return (unsigned)tile < sizeof(chars) ? chars[tile] : '0';
+}
+
+std::string SceneSideFileName(const char *sceneFile, const char *extension) {
+	std::string name = sceneFile;
+	size_t dot = name.find_last_of('.');
+	size_t slash = name.find_last_of('/');
+	if(dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+		name.resize(dot);
+	}
+	return name + extension;
+}
+
+bool WriteSceneFile(const char *fileName, const TileGrid &level) {
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		return false;
+	}
+
+	out << level.width << " " << level.height << "\n";
+
+	std::vector<char> line(level.width + 1);
+	line[level.width] = '\n';
+	for(int y = 0; y < level.height; y++) {
+		for(int x = 0; x < level.width; x++) {
+			line[x] = CharFromTile(level.At(x, y));
+		}
+		out.write(line.data(), line.size());
+	}
+
+	return (bool)out;
+}
+
+SceneFileReader::~SceneFileReader() {
+	Close();
+}
+
+void SceneFileReader::Close() {
+	if(m_fd >= 0) {
+		close(m_fd);
+		m_fd = -1;
+	}
+	delete[] m_buffer;
+	m_buffer = nullptr;
+}
+
+bool SceneFileReader::Fail(const std::string &message) {
+	m_error = message;
+	return false;
+}
+
+// Moves the unread tail to the front and tops the buffer up
+bool SceneFileReader::Refill() {
+	if(m_eof) {
+		return false;
+	}
+
+	int remaining = m_end - m_pos;
+	memmove(m_buffer, m_buffer + m_pos, remaining);
+	m_pos = 0;
+	m_end = remaining;
+
+	ssize_t n = read(m_fd, m_buffer + m_end, SCENE_FILE_BUFFER_SIZE - m_end);
+	if(n <= 0) {
+		m_eof = true;
+		return false;
+	}
+	m_end += n;
+	return true;
+}
+
+bool SceneFileReader::Open(const char *fileName) {
+	Close();
+	m_pos = m_end = 0;
+	m_eof = false;
+	m_row = 0;
+	m_consumed = 0;
+	m_error.clear();
+
+	m_fd = open(fileName, O_RDONLY);
+	if(m_fd < 0) {
+		return Fail(std::string("cannot open ") + fileName);
+	}
+	posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	m_buffer = new char[SCENE_FILE_BUFFER_SIZE];
+
+	// Header: two decimal numbers separated by spaces or tabs
+	long long dims[2] = { 0, 0 };
+	for(int i = 0; i < 2; i++) {
+		int digits = 0;
+		for(;;) {
+			if(m_pos == m_end && !Refill()) {
+				break;
+			}
+			char c = m_buffer[m_pos];
+			if(c == ' ' || c == '\t') {
+				if(digits > 0) {
+					break;
+				}
+				m_pos++;
+				continue;
+			}
+			if(c < '0' || c > '9') {
+				break;
+			}
+			dims[i] = dims[i] * 10 + (c - '0');
+			if(dims[i] > SCENE_FILE_MAX_SIDE) {
+				return Fail("scene dimensions are too large");
+			}
+			digits++;
+			m_pos++;
+		}
+		if(digits == 0) {
+			return Fail("header must be \"<width> <height>\"");
+		}
+	}
+
+	// Rest of the header line
+	for(;;) {
+		if(m_pos == m_end && !Refill()) {
+			break;
+		}
+		char c = m_buffer[m_pos++];
+		if(c == '\n') {
+			break;
+		}
+		if(c != ' ' && c != '\t' && c != '\r') {
+			return Fail("unexpected characters after the scene dimensions");
+		}
+	}
+
+	if(dims[0] <= 0 || dims[1] <= 0) {
+		return Fail("scene dimensions must be positive");
+	}
+	width = dims[0];
+	height = dims[1];
+	m_consumed = m_pos;
+
+	return true;
+}
+
+bool SceneFileReader::ReadRow(char *row) {
+	if(m_row >= height) {
+		return Fail("read past the last row");
+	}
+
+	m_rowOffset = m_consumed;
+
+	int count = 0;
+	bool sawNewline = false;
+	bool sawCR = false;		// Only allowed right before the newline
+	for(;;) {
+		if(m_pos == m_end && !Refill()) {
+			break;		// The last row may omit its newline
+		}
+
+		// Take every buffered byte up to the end of the row in one go
+		const char *start = m_buffer + m_pos;
+		const char *newline = (const char *)memchr(start, '\n', m_end - m_pos);
+		int len = newline ? newline - start : m_end - m_pos;
+
+		for(int i = 0; i < len; i++) {
+			char c = start[i];
+			if(c == '\r') {
+				sawCR = true;
+				continue;
+			}
+			if(sawCR || TileFromChar(c) < 0) {
+				return Fail("unknown cell '" + std::string(1, c) + "' in row " + std::to_string(m_row + 1));
+			}
+			if(count == width) {
+				return Fail("row " + std::to_string(m_row + 1) + " is longer than " + std::to_string(width) + " cells");
+			}
+			row[count++] = c;
+		}
+
+		m_pos += len;
+		m_consumed += len;
+		if(newline) {
+			m_pos++;
+			m_consumed++;
+			sawNewline = true;
+			break;
+		}
+	}
+
+	if(count == 0 && !sawNewline) {
+		return Fail("missing row " + std::to_string(m_row + 1) + " of " + std::to_string(height));
+	}
+	if(count != width) {
+		return Fail("row " + std::to_string(m_row + 1) + " has " + std::to_string(count) + " cells, expected " + std::to_string(width));
+	}
+
+	m_row++;
+	return true;
+}
+
+SceneFileRandomAccess::~SceneFileRandomAccess() {
+	Close();
+}
+
+void SceneFileRandomAccess::Close() {
+	if(m_fd >= 0) {
+		close(m_fd);
+		m_fd = -1;
+	}
+	m_rowOffsets.clear();
+}
+
+bool SceneFileRandomAccess::Open(const char *fileName) {
+	Close();
+	spawnX = spawnY = -1;
+
+	SceneFileReader reader;
+	if(!reader.Open(fileName)) {
+		m_error = reader.Error();
+		return false;
+	}
+	width = reader.width;
+	height = reader.height;
+
+	m_rowOffsets.resize(height);
+	std::vector<char> row(width);
+	for(int y = 0; y < height; y++) {
+		if(!reader.ReadRow(row.data())) {
+			m_error = reader.Error();
+			return false;
+		}
+		m_rowOffsets[y] = reader.RowOffset();
+
+		if(spawnX < 0) {
+			const char *spawn = (const char *)memchr(row.data(), 'S', width);
+			if(spawn) {
+				spawnX = spawn - row.data();
+				spawnY = y;
+			}
+		}
+	}
+	reader.Close();
+
+	m_fd = open(fileName, O_RDONLY);
+	if(m_fd < 0) {
+		m_error = std::string("cannot open ") + fileName;
+		return false;
+	}
+	return true;
+}
+
+bool SceneFileRandomAccess::ReadCells(int x, int y, int count, char *cells) const {
+	if(m_fd < 0 || x < 0 || y < 0 || y >= height || count < 0 || x + count > width) {
+		return false;
+	}
+	return pread(m_fd, cells, count, m_rowOffsets[y] + x) == count;
+}
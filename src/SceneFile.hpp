@@ -0,0 +1,111 @@
+#ifndef SCENE_FILE_INCLUDED
+#define SCENE_FILE_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "TileGrid.hpp"
+
+#define SCENE_FILE_BUFFER_SIZE (64 * 1024)
+
+// Largest width or height, so cell coordinates and chunk bounds stay in int
+// range; the cell count and file offsets are 64-bit
+#define SCENE_FILE_MAX_SIDE (1 << 30)
+
+// Streams a scenefile row by row through a fixed-size buffer
+// The format is a "<width> <height>" header line followed by height rows of
+// exactly width cell characters (see TileFromChar)
+class SceneFileReader {
+public:
+	SceneFileReader() {}
+	~SceneFileReader();
+
+	SceneFileReader(const SceneFileReader &) = delete;
+	SceneFileReader &operator=(const SceneFileReader &) = delete;
+
+	// Opens the file and parses the header
+	bool Open(const char *fileName);
+	void Close();
+
+	// Copies the next row's width cell characters into row
+	// Fails on short, long or missing rows and on unknown cell characters
+	bool ReadRow(char *row);
+
+	const std::string &Error() const { return m_error; }
+
+	int		width = 0;
+	int		height = 0;
+
+	long long NumCells() const { return (long long)width * height; }
+
+	// Bytes consumed so far, header included
+	long long BytesRead() const { return m_consumed; }
+
+	// File offset of the first cell of the row last returned by ReadRow
+	long long RowOffset() const { return m_rowOffset; }
+
+private:
+	bool Refill();
+	bool Fail(const std::string &message);
+
+	int			m_fd = -1;
+	char		*m_buffer = nullptr;
+	int			m_pos = 0;
+	int			m_end = 0;
+	bool		m_eof = false;
+
+	int			m_row = 0;
+	long long	m_consumed = 0;
+	long long	m_rowOffset = 0;
+	std::string	m_error;
+};
+
+// Random access to the cells of a scenefile
+// Open() streams the whole file once to validate it and index where each
+// row starts, after which any run of cells can be read with one pread
+// Safe to read from several threads at once
+class SceneFileRandomAccess {
+public:
+	SceneFileRandomAccess() {}
+	~SceneFileRandomAccess();
+
+	SceneFileRandomAccess(const SceneFileRandomAccess &) = delete;
+	SceneFileRandomAccess &operator=(const SceneFileRandomAccess &) = delete;
+
+	bool Open(const char *fileName);
+	void Close();
+
+	// Copies count cell characters of row y, starting at column x
+	bool ReadCells(int x, int y, int count, char *cells) const;
+
+	const std::string &Error() const { return m_error; }
+
+	int		width = 0;
+	int		height = 0;
+
+	long long NumCells() const { return (long long)width * height; }
+
+	// First spawn cell found while indexing, -1 if there is none
+	int		spawnX = -1;
+	int		spawnY = -1;
+
+private:
+	int						m_fd = -1;
+	std::vector<long long>	m_rowOffsets;
+	std::string				m_error;
+};
+
+// Maps a scenefile cell character to its LEVEL_* value, -1 if unknown
+int TileFromChar(char c);
+
+// Inverse of TileFromChar
+char CharFromTile(int tile);
+
+// Writes level out in the scenefile format
+bool WriteSceneFile(const char *fileName, const TileGrid &level);
+
+// A file of precomputed data kept next to a scenefile, the scenefile's name
+// with its extension swapped ("maps/a.txt", ".pvs" -> "maps/a.pvs")
+std::string SceneSideFileName(const char *sceneFile, const char *extension);
+
+#endif
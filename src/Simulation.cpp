@@ -0,0 +1,252 @@
+#include "Simulation.hpp"
+
+#include <algorithm>
+
+#include "Profiler.hpp"
+
+void StepPlayer(Player &player, const PlayerInput &input, float dt, const TileGrid *level, CollisionStats &stats) {
+	player.yaw += input.turn * PLAYER_TURN_SPEED * dt;
+	player.pitch = std::max(-PLAYER_MAX_PITCH, std::min(PLAYER_MAX_PITCH, player.pitch + input.look * PLAYER_TURN_SPEED * dt));
+
+	// Moving stays on the floor whatever the pitch, so only yaw turns the wish direction
+	player.wishDir = Vec3f(input.forward, -input.right, 0.f);
+	Quaternion yaw(Vec3f(0.f, 0.f, 1.f), player.yaw);
+	Vec3f wish = yaw.RotateVector(player.wishDir);
+	wish.Normalize();
+
+	player.vel = player.vel + wish * (PLAYER_ACCELERATION * dt);
+	player.vel = player.vel - player.vel * (PLAYER_FRICTION * dt);
+	if(level && level->width > 0) {
+		MoveCircle(*level, player.origin, player.vel, PLAYER_RADIUS, dt, stats);
+	}
+	else {
+		player.origin = player.origin + player.vel * dt;
+	}
+}
+
+Simulation::~Simulation() {
+	Stop();
+}
+
+void Simulation::Init(const Player &player, const TileGrid *level, AgentSim *agents, double tickSeconds) {
+	Stop();
+
+	m_level = level;
+	m_agents = agents;
+	m_state = player;
+	m_collision = CollisionStats();
+	m_record = nullptr;
+	m_replay.Begin(nullptr);
+	m_replaying = false;
+	m_start = std::chrono::steady_clock::now();
+	m_dt = tickSeconds;
+	m_previous = player;
+	m_current = player;
+	GatherAgents(m_agentsCurrent);
+	m_agentsPrevious = m_agentsCurrent;
+	m_agentStats = AgentTickStats();
+	m_input = PlayerInput();
+	m_step = 0;
+	m_ticks = 0;
+	m_replayedTicks = 0;
+	m_takenTicks = 0;
+	m_droppedTicks = 0;
+	m_maxLateness = 0.0;
+}
+
+void Simulation::Start() {
+	if(m_thread.joinable()) {
+		return;
+	}
+	m_quit = false;
+	m_thread = std::thread(&Simulation::ThreadMain, this);
+}
+
+void Simulation::Stop() {
+	if(!m_thread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	m_thread.join();
+}
+
+// The stepping thread is the only writer of m_step, so it reads it unlocked
+int Simulation::Advance(double now) {
+	PlayerInput input;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		input = m_input;
+	}
+
+	// Tick times are multiples of the step, summing them up would drift
+	// A replay catches up on everything, it must consume every logged tick
+	long long step = m_step;
+	int ticks = 0;
+	double lateness = 0.0;
+	while((step + 1) * m_dt <= now && (m_replaying || ticks < SIM_MAX_TICKS_PER_ADVANCE)) {
+		if(m_replaying && m_replay.Tick() + ticks >= m_replay.Length()) {
+			break;
+		}
+		lateness = std::max(lateness, now - (step + 1) * m_dt);
+		step++;
+		ticks++;
+	}
+	if(ticks == 0) {
+		return 0;
+	}
+
+	// Too far behind to catch up, carry on from now instead
+	long long dropped = 0;
+	if(!m_replaying && (step + 1) * m_dt <= now) {
+		dropped = (long long)(now / m_dt) - step;
+	}
+
+	Player previous;
+	for(int tick = 0; tick < ticks; tick++) {
+		if(tick == ticks - 1) {
+			previous = m_state;
+			GatherAgents(m_agentsBefore);
+		}
+		PROFILE_ZONE("SimTick");
+		if(m_replaying) {
+			input = m_replay.Next();
+		}
+		if(m_record) {
+			m_record->Record(m_ticks + tick, input);
+		}
+		StepPlayer(m_state, input, (float)m_dt, m_level, m_collision);
+		if(m_agents) {
+			m_agents->Tick((float)m_dt);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_previous = previous;
+	m_current = m_state;
+	m_agentsPrevious.swap(m_agentsBefore);
+	GatherAgents(m_agentsCurrent);
+	if(m_agents) {
+		m_agentStats = m_agents->stats;
+	}
+	m_step = step + dropped;
+	m_ticks += ticks;
+	m_replayedTicks = m_replay.Tick();
+	m_droppedTicks += dropped;
+	m_maxLateness = std::max(m_maxLateness, lateness);
+	return ticks;
+}
+
+void Simulation::GatherAgents(std::vector<float> &positions) const {
+	positions.clear();
+	if(!m_agents) {
+		return;
+	}
+	const AgentTransforms &transforms = m_agents->store.transforms;
+	int count = m_agents->store.Count();
+	positions.resize(2 * count);
+	for(int i = 0; i < count; i++) {
+		positions[2 * i] = transforms.x[i];
+		positions[2 * i + 1] = transforms.y[i];
+	}
+}
+
+// Sleeps until the next tick is due, a late wake up steps every tick it missed
+void Simulation::ThreadMain() {
+	ProfilerSetThreadName("Simulation");
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(!m_quit) {
+		lock.unlock();
+		Advance(Now());
+		lock.lock();
+
+		auto due = m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>((m_step + 1) * m_dt));
+		m_wake.wait_until(lock, due, [this]() { return m_quit; });
+	}
+}
+
+void Simulation::Record(InputLog *log) {
+	m_record = log;
+}
+
+void Simulation::Replay(const InputLog *log) {
+	m_replay.Begin(log);
+	m_replaying = log != nullptr;
+}
+
+bool Simulation::ReplayFinished() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_replaying && m_replayedTicks >= (long long)m_replay.Length();
+}
+
+long long Simulation::ReplayedTicks() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_replayedTicks;
+}
+
+void Simulation::SetInput(const PlayerInput &input) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_input = input;
+}
+
+Player Simulation::Interpolated(double now) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	float t = (float)std::max(0.0, std::min(1.0, now / m_dt - m_step));
+	Player player = m_current;
+	player.origin = m_previous.origin + (m_current.origin - m_previous.origin) * t;
+	player.yaw = m_previous.yaw + (m_current.yaw - m_previous.yaw) * t;
+	player.pitch = m_previous.pitch + (m_current.pitch - m_previous.pitch) * t;
+	return player;
+}
+
+void Simulation::InterpolatedAgents(double now, std::vector<float> &positions) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	float t = (float)std::max(0.0, std::min(1.0, now / m_dt - m_step));
+	size_t count = std::min(m_agentsPrevious.size(), m_agentsCurrent.size());
+	positions.resize(count);
+	for(size_t i = 0; i < count; i++) {
+		positions[i] = m_agentsPrevious[i] + (m_agentsCurrent[i] - m_agentsPrevious[i]) * t;
+	}
+}
+
+AgentTickStats Simulation::AgentStats() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_agentStats;
+}
+
+Player Simulation::Current() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_current;
+}
+
+double Simulation::Now() const {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+long long Simulation::Ticks() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_ticks;
+}
+
+long long Simulation::DroppedTicks() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_droppedTicks;
+}
+
+double Simulation::MaxLateness() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_maxLateness;
+}
+
+int Simulation::TakeTicks() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	int ticks = (int)(m_ticks - m_takenTicks);
+	m_takenTicks = m_ticks;
+	return ticks;
+}
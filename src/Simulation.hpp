@@ -0,0 +1,115 @@
+#ifndef SIMULATION_INCLUDED
+#define SIMULATION_INCLUDED
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "Agents.hpp"
+#include "Collision.hpp"
+#include "InputLog.hpp"
+#include "Scene.hpp"
+
+#define SIM_TICK_RATE 120
+#define SIM_MAX_TICKS_PER_ADVANCE 30		// A quarter second, time beyond is dropped instead of caught up
+
+#define PLAYER_ACCELERATION 20.f
+#define PLAYER_FRICTION 8.f				// Top speed is acceleration / friction
+#define PLAYER_TURN_SPEED 2.5f			// Radians per second
+#define PLAYER_MAX_PITCH 1.4f
+
+// One fixed step of player motion, colliding with the walls of level unless it is null or empty
+void StepPlayer(Player &player, const PlayerInput &input, float dt, const TileGrid *level, CollisionStats &stats);
+
+// Player and agent motion at a fixed rate on a clock of its own, either
+// stepped by the caller through Advance or by a thread of its own so a slow
+// frame never slows the simulation down
+// Ticks run outside the lock, which only guards the state published after
+// them; rendering samples it interpolated between the last two ticks
+class Simulation {
+public:
+	~Simulation();
+
+	// level and agents are only used while running, and have to outlive it
+	void Init(const Player &player, const TileGrid *level, AgentSim *agents = nullptr, double tickSeconds = 1.0 / SIM_TICK_RATE);
+
+	void Start();
+	void Stop();
+	bool Running() const { return m_thread.joinable(); }
+
+	// Steps every tick that is due by now on the calling thread, returns how many
+	int Advance(double now);
+
+	void SetInput(const PlayerInput &input);
+
+	// Appends the input of every tick stepped from now on to log, which is
+	// only touched while stepping and has to outlive the run
+	void Record(InputLog *log);
+
+	// Takes the input of every tick from log instead of SetInput, stepping
+	// no further than its last tick; Init from its StartPlayer first
+	// Replays never drop ticks, however far behind an Advance is
+	void Replay(const InputLog *log);
+	bool ReplayFinished() const;
+	long long ReplayedTicks() const;
+
+	// Player between the last two ticks at now, the view trails by up to a tick
+	Player Interpolated(double now) const;
+	Player Current() const;
+
+	// x, y pairs of every agent, interpolated the same way
+	void InterpolatedAgents(double now, std::vector<float> &positions) const;
+	AgentTickStats AgentStats() const;
+
+	// Seconds since Init
+	double Now() const;
+
+	double TickSeconds() const { return m_dt; }
+	long long Ticks() const;
+	long long DroppedTicks() const;
+
+	// Longest a tick was stepped after it came due, in seconds
+	double MaxLateness() const;
+
+	// Ticks stepped since the previous call, for per-frame stats
+	int TakeTicks();
+
+private:
+	void ThreadMain();
+	void GatherAgents(std::vector<float> &positions) const;
+
+	std::chrono::steady_clock::time_point m_start;
+	double				m_dt = 1.0 / SIM_TICK_RATE;
+	const TileGrid		*m_level = nullptr;
+
+	// Only touched by whichever thread is stepping
+	Player				m_state;
+	AgentSim			*m_agents = nullptr;
+	std::vector<float>	m_agentsBefore;		// Before the last tick of an Advance
+	CollisionStats		m_collision;
+	InputLog			*m_record = nullptr;
+	InputPlayback		m_replay;
+	bool				m_replaying = false;
+
+	// Published after every Advance that stepped
+	mutable std::mutex	m_mutex;
+	Player				m_previous;
+	Player				m_current;
+	std::vector<float>	m_agentsPrevious;
+	std::vector<float>	m_agentsCurrent;
+	AgentTickStats		m_agentStats;
+	PlayerInput			m_input;
+	long long			m_step = 0;			// m_current is at m_step * m_dt, dropped time included
+	long long			m_ticks = 0;
+	long long			m_replayedTicks = 0;
+	long long			m_takenTicks = 0;
+	long long			m_droppedTicks = 0;
+	double				m_maxLateness = 0.0;
+
+	std::thread			m_thread;
+	std::condition_variable	m_wake;
+	bool				m_quit = false;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "TileGrid.hpp"
+
+const uint8_t TileGrid::s_spread[TILE_BLOCK_SIZE] = { 0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15 };
+
+void TileGrid::Resize(int w, int h, TileLayout tileLayout) {
+	width = w;
+	height = h;
+	layout = tileLayout;
+
+	m_wordsPerRow = (w + 63) / 64;
+	m_blocksPerRow = (w + TILE_BLOCK_SIZE - 1) / TILE_BLOCK_SIZE;
+
+	// Tiled storage rounds the grid up to whole blocks
+	size_t numTiles = (size_t)w * h;
+	if(layout == TILE_LAYOUT_TILED) {
+		size_t blockRows = (h + TILE_BLOCK_SIZE - 1) / TILE_BLOCK_SIZE;
+		numTiles = blockRows * m_blocksPerRow * TILE_BLOCK_SIZE * TILE_BLOCK_SIZE;
+	}
+
+	m_tiles.assign(numTiles, LEVEL_AIR);
+	m_walls.assign((size_t)m_wordsPerRow * h, 0);
+}
+
+void TileGrid::Clear() {
+	width = height = 0;
+	m_tiles.clear();
+	m_tiles.shrink_to_fit();
+	m_walls.clear();
+	m_walls.shrink_to_fit();
+}
+
+void TileGrid::Set(int x, int y, int tile) {
+	if(!InBounds(x, y)) {
+		return;
+	}
+	m_tiles[Index(x, y)] = tile;
+
+	uint64_t &word = m_walls[(size_t)y * m_wordsPerRow + (x >> 6)];
+	uint64_t bit = 1ull << (x & 63);
+	if(tile == LEVEL_WALL) {
+		word |= bit;
+	}
+	else {
+		word &= ~bit;
+	}
+}
+
+// Edge cells, where some neighbours are out of bounds
+int TileGrid::WallNeighboursClamped(int x, int y) const {
+	int mask = 0;
+	if(IsWall(x + 1, y)) mask |= NEIGHBOUR_POS_X;
+	if(IsWall(x - 1, y)) mask |= NEIGHBOUR_NEG_X;
+	if(IsWall(x, y + 1)) mask |= NEIGHBOUR_POS_Y;
+	if(IsWall(x, y - 1)) mask |= NEIGHBOUR_NEG_Y;
+	return mask;
+}
+
+int TileGrid::CountWallsInRow(int y, int x0, int x1) const {
+	if(y < 0 || y >= height) {
+		return 0;
+	}
+	if(x0 < 0) x0 = 0;
+	if(x1 > width) x1 = width;
+
+	const uint64_t *row = &m_walls[(size_t)y * m_wordsPerRow];
+	int count = 0;
+	for(int x = x0; x < x1; ) {
+		int bit = x & 63;
+		int n = 64 - bit;
+		if(n > x1 - x) {
+			n = x1 - x;
+		}
+		uint64_t word = row[x >> 6] >> bit;
+		if(n < 64) {
+			word &= (1ull << n) - 1;
+		}
+		count += __builtin_popcountll(word);
+		x += n;
+	}
+	return count;
+}
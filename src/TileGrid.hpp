@@ -0,0 +1,114 @@
+#ifndef TILE_GRID_INCLUDED
+#define TILE_GRID_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Tile values, one per grid cell
+enum {
+	LEVEL_AIR,
+	LEVEL_SPAWN,
+	LEVEL_WALL,
+	LEVEL_GOAL,
+	LEVEL_KEY,
+	LEVEL_DOOR
+};
+
+// Storage order of the tile bytes
+enum TileLayout {
+	TILE_LAYOUT_ROW_MAJOR,
+	TILE_LAYOUT_TILED			// 8x8 blocks in row-major order, Morton order inside a block
+};
+
+#define TILE_BLOCK_SHIFT 3
+#define TILE_BLOCK_SIZE (1 << TILE_BLOCK_SHIFT)
+
+// Neighbour bits returned by TileGrid::WallNeighbours
+enum {
+	NEIGHBOUR_POS_X = 1 << 0,
+	NEIGHBOUR_NEG_X = 1 << 1,
+	NEIGHBOUR_POS_Y = 1 << 2,
+	NEIGHBOUR_NEG_Y = 1 << 3
+};
+
+// Level grid with one byte per tile (a LEVEL_* value) plus a row-major
+// bitset of wall tiles for collision and visibility queries
+// Out of bounds cells read as LEVEL_AIR and are never walls
+class TileGrid {
+public:
+	TileGrid() {}
+
+	void Resize(int w, int h, TileLayout tileLayout = TILE_LAYOUT_ROW_MAJOR);
+	void Clear();
+
+	bool InBounds(int x, int y) const {
+		return (unsigned)x < (unsigned)width && (unsigned)y < (unsigned)height;
+	}
+
+	size_t Index(int x, int y) const {
+		if(layout == TILE_LAYOUT_ROW_MAJOR) {
+			return (size_t)y * width + x;
+		}
+		size_t block = (size_t)(y >> TILE_BLOCK_SHIFT) * m_blocksPerRow + (x >> TILE_BLOCK_SHIFT);
+		return (block << (2 * TILE_BLOCK_SHIFT)) | (s_spread[x & (TILE_BLOCK_SIZE - 1)] | (s_spread[y & (TILE_BLOCK_SIZE - 1)] << 1));
+	}
+
+	int Get(int x, int y) const {
+		return InBounds(x, y) ? (int)m_tiles[Index(x, y)] : (int)LEVEL_AIR;
+	}
+
+	// Get without the bounds check, for loops that already clip to the grid
+	int At(int x, int y) const {
+		return m_tiles[Index(x, y)];
+	}
+
+	// Keeps the wall bitset in sync
+	void Set(int x, int y, int tile);
+
+	bool IsWall(int x, int y) const {
+		if(!InBounds(x, y)) {
+			return false;
+		}
+		return (m_walls[(size_t)y * m_wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+	}
+
+	// NEIGHBOUR_* bits of the four edge neighbours that are walls
+	int WallNeighbours(int x, int y) const {
+		if(x <= 0 || y <= 0 || x >= width - 1 || y >= height - 1) {
+			return WallNeighboursClamped(x, y);
+		}
+		const uint64_t *row = &m_walls[(size_t)y * m_wordsPerRow];
+		int bit = x & 63;
+		uint64_t above = row[(x >> 6) + m_wordsPerRow] >> bit;
+		uint64_t below = row[(x >> 6) - m_wordsPerRow] >> bit;
+		uint64_t right = row[(x + 1) >> 6] >> ((x + 1) & 63);
+		uint64_t left = row[(x - 1) >> 6] >> ((x - 1) & 63);
+		return (int)((right & 1) | (left & 1) << 1 | (above & 1) << 2 | (below & 1) << 3);
+	}
+
+	// Counts wall tiles in [x0, x1) of row y using the bitset
+	int CountWallsInRow(int y, int x0, int x1) const;
+
+	size_t MemoryBytes() const {
+		return m_tiles.size() * sizeof(uint8_t) + m_walls.size() * sizeof(uint64_t);
+	}
+
+	int			width = 0;
+	int			height = 0;
+	TileLayout	layout = TILE_LAYOUT_ROW_MAJOR;
+
+private:
+	std::vector<uint8_t>	m_tiles;
+	std::vector<uint64_t>	m_walls;
+
+	int		m_wordsPerRow = 0;
+	int		m_blocksPerRow = 0;
+
+	// Spreads the 3 bits of a block coordinate over every other bit
+	static const uint8_t s_spread[TILE_BLOCK_SIZE];
+
+	int WallNeighboursClamped(int x, int y) const;
+};
+
+#endif
@@ -0,0 +1,268 @@
+#include "World.hpp"
+#include "TileGrid.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+
+World::~World() {
+	Close();
+}
+
+bool World::Open(const char *fileName, const WorldStreamingConfig &streamingConfig) {
+	Close();
+
+	if(!m_file.Open(fileName)) {
+		std::cerr << fileName << ": " << m_file.Error() << std::endl;
+		return false;
+	}
+
+	config = streamingConfig;
+	width = m_file.width;
+	height = m_file.height;
+	chunksX = (width + WORLD_CHUNK_SIZE - 1) / WORLD_CHUNK_SIZE;
+	chunksY = (height + WORLD_CHUNK_SIZE - 1) / WORLD_CHUNK_SIZE;
+
+	// Chunk indices are ints, which still covers far more cells than INT_MAX
+	if((long long)chunksX * chunksY > INT_MAX) {
+		std::cerr << fileName << ": " << m_file.NumCells() << " cells is too many chunks to stream" << std::endl;
+		m_file.Close();
+		return false;
+	}
+
+	m_states.assign(NumChunks(), CHUNK_UNLOADED);
+	m_bytes.assign(NumChunks(), 0);
+	m_resident.clear();
+	m_numResident = 0;
+	m_numQueued = 0;
+	m_residentBytes = 0;
+	m_centerX = m_centerY = -1;
+	m_requestRadius = config.loadRadius;
+
+	m_quit = false;
+	m_thread = std::thread(&World::IoThreadMain, this);
+
+	return true;
+}
+
+void World::Close() {
+	if(m_thread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_wake.notify_all();
+		m_thread.join();
+	}
+
+	m_requests.clear();
+	m_finished.clear();
+	m_pending.clear();
+	m_states.clear();
+	m_bytes.clear();
+	m_resident.clear();
+	m_file.Close();
+}
+
+void World::ChunkBounds(int index, int &x0, int &y0, int &x1, int &y1) const {
+	x0 = (index % chunksX) * WORLD_CHUNK_SIZE;
+	y0 = (index / chunksX) * WORLD_CHUNK_SIZE;
+	x1 = std::min(x0 + WORLD_CHUNK_SIZE, width);
+	y1 = std::min(y0 + WORLD_CHUNK_SIZE, height);
+}
+
+int World::ChunkDistance(int index, int cx, int cy) const {
+	return std::max(abs(index % chunksX - cx), abs(index / chunksX - cy));
+}
+
+void World::Update(float x, float y, std::vector<std::unique_ptr<WorldChunk>> &ready, std::vector<int> &evicted) {
+	int cx = std::min(std::max((int)x / WORLD_CHUNK_SIZE, 0), chunksX - 1);
+	int cy = std::min(std::max((int)y / WORLD_CHUNK_SIZE, 0), chunksY - 1);
+	int keepRadius = config.loadRadius + 1;		// Hysteresis, so chunks on the edge don't flicker
+
+	// The budget may fit more chunks around another center
+	if(cx != m_centerX || cy != m_centerY) {
+		m_centerX = cx;
+		m_centerY = cy;
+		m_requestRadius = config.loadRadius;
+	}
+
+	// Chunks finished by the I/O thread
+	std::vector<std::unique_ptr<WorldChunk>> finished;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		finished.swap(m_finished);
+	}
+	for(std::unique_ptr<WorldChunk> &chunk : finished) {
+		m_numQueued--;
+		m_states[chunk->index] = CHUNK_READY;
+		m_pending.push_back(std::move(chunk));
+	}
+
+	// Hand a few over per frame, nearest first, so uploads never stall a frame
+	// They count as resident from here on, so the budget below covers them
+	std::sort(m_pending.begin(), m_pending.end(), [&](const std::unique_ptr<WorldChunk> &a, const std::unique_ptr<WorldChunk> &b) {
+		return ChunkDistance(a->index, cx, cy) < ChunkDistance(b->index, cx, cy);
+	});
+	std::vector<std::unique_ptr<WorldChunk>> waiting;
+	for(std::unique_ptr<WorldChunk> &chunk : m_pending) {
+		if(ChunkDistance(chunk->index, cx, cy) > keepRadius) {
+			m_states[chunk->index] = CHUNK_UNLOADED;
+		}
+		else if((int)ready.size() < config.maxReadyPerFrame) {
+			MarkResident(chunk->index, chunk->mesh.NumVerts() * MESH_VERTEX_STRIDE);
+			ready.push_back(std::move(chunk));
+		}
+		else {
+			waiting.push_back(std::move(chunk));
+		}
+	}
+	m_pending.swap(waiting);
+
+	// Drop what is out of range, then the farthest chunks until within budget,
+	// and stop requesting chunks that far out until the player moves on
+	for(size_t i = 0; i < m_resident.size(); ) {
+		if(ChunkDistance(m_resident[i], cx, cy) > keepRadius) {
+			Evict(m_resident[i], ready, evicted);
+		}
+		else {
+			i++;
+		}
+	}
+	while(m_residentBytes > config.memoryBudget && !m_resident.empty()) {
+		int farthest = 0;
+		for(size_t i = 1; i < m_resident.size(); i++) {
+			if(ChunkDistance(m_resident[i], cx, cy) > ChunkDistance(m_resident[farthest], cx, cy)) {
+				farthest = i;
+			}
+		}
+		m_requestRadius = std::min(m_requestRadius, ChunkDistance(m_resident[farthest], cx, cy) - 1);
+		Evict(m_resident[farthest], ready, evicted);
+	}
+
+	// Rebuilt every frame, so in-range chunks dropped while pending or
+	// evicted are asked for again
+	std::vector<int> wanted;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for(int index : m_requests) {
+		m_states[index] = CHUNK_UNLOADED;
+		m_numQueued--;
+	}
+
+	for(int j = std::max(cy - m_requestRadius, 0); j <= std::min(cy + m_requestRadius, chunksY - 1); j++) {
+		for(int i = std::max(cx - m_requestRadius, 0); i <= std::min(cx + m_requestRadius, chunksX - 1); i++) {
+			int index = j * chunksX + i;
+			if(m_states[index] == CHUNK_UNLOADED) {
+				m_states[index] = CHUNK_QUEUED;
+				wanted.push_back(index);
+			}
+		}
+	}
+	std::sort(wanted.begin(), wanted.end(), [&](int a, int b) {
+		return ChunkDistance(a, cx, cy) > ChunkDistance(b, cx, cy);
+	});
+
+	m_numQueued += wanted.size();
+	m_requests.swap(wanted);
+	if(!m_requests.empty()) {
+		m_wake.notify_one();
+	}
+}
+
+void World::MarkResident(int index, size_t bytes) {
+	m_states[index] = CHUNK_RESIDENT;
+	m_bytes[index] = bytes;
+	m_resident.push_back(index);
+	m_numResident++;
+	m_residentBytes += bytes;
+}
+
+// A chunk handed over this frame is taken back before the renderer sees it
+void World::Evict(int index, std::vector<std::unique_ptr<WorldChunk>> &ready, std::vector<int> &evicted) {
+	auto it = std::find(m_resident.begin(), m_resident.end(), index);
+	*it = m_resident.back();
+	m_resident.pop_back();
+
+	m_states[index] = CHUNK_UNLOADED;
+	m_residentBytes -= m_bytes[index];
+	m_bytes[index] = 0;
+	m_numResident--;
+
+	auto handedOver = std::find_if(ready.begin(), ready.end(), [&](const std::unique_ptr<WorldChunk> &chunk) {
+		return chunk->index == index;
+	});
+	if(handedOver != ready.end()) {
+		ready.erase(handedOver);
+	}
+	else {
+		evicted.push_back(index);
+	}
+}
+
+void World::IoThreadMain() {
+	for(;;) {
+		int index;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this]() { return m_quit || !m_requests.empty(); });
+			if(m_quit) {
+				return;
+			}
+			index = m_requests.back();
+			m_requests.pop_back();
+		}
+
+		std::unique_ptr<WorldChunk> chunk = LoadChunk(index);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_finished.push_back(std::move(chunk));
+	}
+}
+
+// Reads the chunk plus a one cell apron, so faces against walls in
+// neighbouring chunks are culled, and bakes it
+std::unique_ptr<WorldChunk> World::LoadChunk(int index) const {
+	std::unique_ptr<WorldChunk> chunk(new WorldChunk());
+	chunk->index = index;
+
+	int x0, y0, x1, y1;
+	ChunkBounds(index, x0, y0, x1, y1);
+
+	int ax0 = std::max(x0 - 1, 0), ay0 = std::max(y0 - 1, 0);
+	int ax1 = std::min(x1 + 1, width), ay1 = std::min(y1 + 1, height);
+
+	TileGrid tiles;
+	tiles.Resize(ax1 - ax0, ay1 - ay0);
+
+	std::vector<char> row(ax1 - ax0);
+	for(int y = ay0; y < ay1; y++) {
+		if(!m_file.ReadCells(ax0, y, ax1 - ax0, row.data())) {
+			std::cerr << "error reading row " << y << " of the scenefile" << std::endl;
+			continue;
+		}
+		for(int x = ax0; x < ax1; x++) {
+			int tile = TileFromChar(row[x - ax0]);
+			if(tile == LEVEL_SPAWN) {
+				tile = LEVEL_AIR;
+			}
+			tiles.Set(x - ax0, y - ay0, tile);
+
+			if(tile == LEVEL_KEY && x >= x0 && x < x1 && y >= y0 && y < y1) {
+				chunk->keys.push_back(x);
+				chunk->keys.push_back(y);
+			}
+		}
+	}
+
+	BakeWorldMesh(tiles, x0 - ax0, y0 - ay0, x1 - ax0, y1 - ay0, chunk->mesh);
+
+	// Back from apron-local to level coordinates
+	std::vector<float> &verts = chunk->mesh.vertices;
+	for(size_t i = 0; i < verts.size(); i += MESH_VERTEX_FLOATS) {
+		verts[i] += ax0;
+		verts[i + 1] += ay0;
+	}
+
+	return chunk;
+}
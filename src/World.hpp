@@ -0,0 +1,104 @@
+#ifndef WORLD_INCLUDED
+#define WORLD_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SceneFile.hpp"
+#include "WorldMesh.hpp"
+
+#define WORLD_CHUNK_SIZE 64
+
+enum ChunkState {
+	CHUNK_UNLOADED,
+	CHUNK_QUEUED,			// Requested from, or being loaded by, the I/O thread
+	CHUNK_READY,			// Loaded and baked, waiting to be made resident
+	CHUNK_RESIDENT
+};
+
+// Output of the I/O thread for one chunk
+struct WorldChunk {
+	int					index;
+	WorldMesh			mesh;
+	std::vector<int>	keys;		// x, y pairs of key cells
+};
+
+struct WorldStreamingConfig {
+	int		loadRadius = 4;					// In chunks, around the player's chunk
+	size_t	memoryBudget = 256 << 20;		// Bytes of baked geometry kept resident
+	int		maxReadyPerFrame = 2;			// Chunks handed to the renderer per Update
+};
+
+// The level split into WORLD_CHUNK_SIZE square chunks that are read from the
+// scenefile and baked on a background thread, then kept resident while they
+// are near the player and fit in the memory budget
+// Every method is meant to be called from the main thread
+class World {
+public:
+	World() {}
+	~World();
+
+	World(const World &) = delete;
+	World &operator=(const World &) = delete;
+
+	bool Open(const char *fileName, const WorldStreamingConfig &streamingConfig);
+	void Close();
+
+	// Requests the chunks around (x, y) nearest first, collects finished
+	// chunks into ready and lists the resident chunks to drop in evicted
+	// Chunks in ready are resident from this call on and must be uploaded
+	void Update(float x, float y, std::vector<std::unique_ptr<WorldChunk>> &ready, std::vector<int> &evicted);
+
+	ChunkState State(int index) const { return m_states[index]; }
+	void ChunkBounds(int index, int &x0, int &y0, int &x1, int &y1) const;
+
+	int		NumChunks() const { return chunksX * chunksY; }
+	int		NumResident() const { return m_numResident; }
+	int		NumQueued() const { return m_numQueued + m_pending.size(); }
+	size_t	ResidentBytes() const { return m_residentBytes; }
+
+	const SceneFileRandomAccess &File() const { return m_file; }
+
+	int		width = 0;
+	int		height = 0;
+	int		chunksX = 0;
+	int		chunksY = 0;
+
+	WorldStreamingConfig config;
+
+private:
+	void IoThreadMain();
+	std::unique_ptr<WorldChunk> LoadChunk(int index) const;
+
+	void MarkResident(int index, size_t bytes);
+	void Evict(int index, std::vector<std::unique_ptr<WorldChunk>> &ready, std::vector<int> &evicted);
+	int ChunkDistance(int index, int cx, int cy) const;
+
+	SceneFileRandomAccess	m_file;
+
+	// Shared with the I/O thread
+	std::thread									m_thread;
+	std::mutex									m_mutex;
+	std::condition_variable						m_wake;
+	bool										m_quit = false;
+	std::vector<int>							m_requests;		// Nearest chunk last
+	std::vector<std::unique_ptr<WorldChunk>>	m_finished;
+
+	// Main thread only
+	std::vector<std::unique_ptr<WorldChunk>>	m_pending;		// Ready, not handed over yet
+	std::vector<ChunkState>	m_states;
+	std::vector<size_t>		m_bytes;
+	std::vector<int>		m_resident;
+	int						m_numResident = 0;
+	int						m_numQueued = 0;
+	size_t					m_residentBytes = 0;
+	int						m_centerX = -1;
+	int						m_centerY = -1;
+	int						m_requestRadius = 0;		// loadRadius, or less once over budget
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "WorldMesh.hpp"
+
+#include <cstdint>
+
+// The world is two layers of unit cubes: layer 0 is the floor slab centered
+// at z = -1, layer 1 holds the walls centered at z = 0. A layer index doubles
+// as the material index
+
+struct Quad {
+	int u0, v0, u1, v1;
+};
+
+static bool IsSolid(const TileGrid &level, int layer, int x, int y) {
+	if(layer == WORLD_MATERIAL_FLOOR) {
+		return level.InBounds(x, y);
+	}
+	return layer == WORLD_MATERIAL_WALL && level.IsWall(x, y);
+}
+
+// Covers every set entry of a nu x nv mask with as few rectangles as the
+// greedy sweep finds: grow along u first, then extend the run along v
+static void GreedyQuads(std::vector<uint8_t> &mask, int nu, int nv, std::vector<Quad> &quads) {
+	for(int v = 0; v < nv; v++) {
+		for(int u = 0; u < nu; ) {
+			if(!mask[v * nu + u]) {
+				u++;
+				continue;
+			}
+
+			int w = 1;
+			while(u + w < nu && mask[v * nu + u + w]) {
+				w++;
+			}
+
+			int h = 1;
+			for(; v + h < nv; h++) {
+				bool fullRow = true;
+				for(int k = 0; k < w; k++) {
+					if(!mask[(v + h) * nu + u + k]) {
+						fullRow = false;
+						break;
+					}
+				}
+				if(!fullRow) {
+					break;
+				}
+			}
+
+			for(int j = 0; j < h; j++) {
+				for(int k = 0; k < w; k++) {
+					mask[(v + j) * nu + u + k] = 0;
+				}
+			}
+
+			quads.push_back({ u, v, u + w, v + h });
+			u += w;
+		}
+	}
+}
+
+// Appends a rectangle lying on the plane axis == plane and facing sign along
+// that axis, spanning [ua, ub] x [va, vb] on the two remaining axes
+static void EmitFace(std::vector<float> &verts, int axis, int sign, float plane, float ua, float ub, float va, float vb) {
+	int uAxis = (axis == 0) ? 1 : 0;
+	int vAxis = (axis == 2) ? 1 : 2;
+
+	// u x v points along +axis for x and z, along -axis for y
+	bool ccw = (axis == 1) ? sign < 0 : sign > 0;
+
+	float corners[4][2] = { { ua, va }, { ub, va }, { ub, vb }, { ua, vb } };
+	static const int ccwOrder[6] = { 0, 1, 2, 0, 2, 3 };
+	static const int cwOrder[6] = { 0, 2, 1, 0, 3, 2 };
+	const int *order = ccw ? ccwOrder : cwOrder;
+
+	for(int i = 0; i < 6; i++) {
+		const float *c = corners[order[i]];
+
+		float pos[3];
+		pos[axis] = plane;
+		pos[uAxis] = c[0];
+		pos[vAxis] = c[1];
+
+		float normal[3] = { 0.f, 0.f, 0.f };
+		normal[axis] = (float)sign;
+
+		verts.insert(verts.end(), { pos[0], pos[1], pos[2], c[0] - ua, c[1] - va, normal[0], normal[1], normal[2] });
+	}
+}
+
+void BakeWorldMesh(const TileGrid &level, int x0, int y0, int x1, int y1, WorldMesh &out) {
+	out.vertices.clear();
+
+	int nx = x1 - x0;
+	int ny = y1 - y0;
+
+	std::vector<uint8_t> mask;
+	std::vector<Quad> quads;
+
+	for(int layer = 0; layer < NUM_WORLD_MATERIALS; layer++) {
+		out.startVerts[layer] = out.NumVerts();
+
+		float zMin = layer - 1.5f;
+		float zMax = layer - 0.5f;
+
+		// Top and bottom faces, one slice over the whole region
+		// Nothing is ever below the floor, so it has no bottom faces
+		for(int sign = layer == WORLD_MATERIAL_FLOOR ? 1 : -1; sign <= 1; sign += 2) {
+			mask.assign(nx * ny, 0);
+			for(int y = 0; y < ny; y++) {
+				for(int x = 0; x < nx; x++) {
+					mask[y * nx + x] = IsSolid(level, layer, x0 + x, y0 + y)
+						&& !IsSolid(level, layer + sign, x0 + x, y0 + y);
+				}
+			}
+
+			quads.clear();
+			GreedyQuads(mask, nx, ny, quads);
+			for(const Quad &q : quads) {
+				EmitFace(out.vertices, 2, sign, sign > 0 ? zMax : zMin,
+					x0 + q.u0 - 0.5f, x0 + q.u1 - 0.5f, y0 + q.v0 - 0.5f, y0 + q.v1 - 0.5f);
+			}
+		}
+
+		// Side faces, one slice per column facing x and per row facing y
+		// A layer is one cell tall, so these merge into runs along the slice
+		for(int sign = -1; sign <= 1; sign += 2) {
+			for(int x = 0; x < nx; x++) {
+				mask.assign(ny, 0);
+				for(int y = 0; y < ny; y++) {
+					mask[y] = IsSolid(level, layer, x0 + x, y0 + y)
+						&& !IsSolid(level, layer, x0 + x + sign, y0 + y);
+				}
+
+				quads.clear();
+				GreedyQuads(mask, ny, 1, quads);
+				for(const Quad &q : quads) {
+					EmitFace(out.vertices, 0, sign, x0 + x + 0.5f * sign,
+						y0 + q.u0 - 0.5f, y0 + q.u1 - 0.5f, zMin, zMax);
+				}
+			}
+
+			for(int y = 0; y < ny; y++) {
+				mask.assign(nx, 0);
+				for(int x = 0; x < nx; x++) {
+					mask[x] = IsSolid(level, layer, x0 + x, y0 + y)
+						&& !IsSolid(level, layer, x0 + x, y0 + y + sign);
+				}
+
+				quads.clear();
+				GreedyQuads(mask, nx, 1, quads);
+				for(const Quad &q : quads) {
+					EmitFace(out.vertices, 1, sign, y0 + y + 0.5f * sign,
+						x0 + q.u0 - 0.5f, x0 + q.u1 - 0.5f, zMin, zMax);
+				}
+			}
+		}
+
+		out.numVerts[layer] = out.NumVerts() - out.startVerts[layer];
+	}
+}
+
+size_t UnbakedVertexCount(const TileGrid &level, int x0, int y0, int x1, int y1, int cubeVerts) {
+	size_t cubes = 0;
+	for(int y = y0; y < y1; y++) {
+		cubes += (x1 - x0) + level.CountWallsInRow(y, x0, x1);
+	}
+	return cubes * cubeVerts;
+}
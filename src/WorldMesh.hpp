@@ -0,0 +1,37 @@
+#ifndef WORLD_MESH_INCLUDED
+#define WORLD_MESH_INCLUDED
+
+#include <cstddef>
+#include <vector>
+
+#include "Mesh.hpp"
+#include "TileGrid.hpp"
+
+enum {
+	WORLD_MATERIAL_FLOOR,
+	WORLD_MATERIAL_WALL,
+	NUM_WORLD_MATERIALS
+};
+
+// Static geometry for the grid: a floor slab under every cell plus a cube on
+// every wall cell, with faces between solid neighbours and the underside of
+// the floor removed and coplanar faces merged into larger quads. Vertices
+// use the regular model layout and are grouped by material so each material
+// is one contiguous draw
+struct WorldMesh {
+	std::vector<float>	vertices;
+	size_t				startVerts[NUM_WORLD_MATERIALS];
+	size_t				numVerts[NUM_WORLD_MATERIALS];
+
+	size_t NumVerts() const { return vertices.size() / MESH_VERTEX_FLOATS; }
+	size_t NumTriangles() const { return NumVerts() / 3; }
+};
+
+// Bakes the cells in [x0, x1) x [y0, y1) of level
+// Cells outside the level count as empty, so the outer faces are kept
+void BakeWorldMesh(const TileGrid &level, int x0, int y0, int x1, int y1, WorldMesh &out);
+
+// Vertex count of drawing the same region as one cube per wall and floor cell
+size_t UnbakedVertexCount(const TileGrid &level, int x0, int y0, int x1, int y1, int cubeVerts);
+
+#endif
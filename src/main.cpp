@@ -1,13 +1,64 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
 #include "render/Application.hpp"
 
+// Usage: Maze [options] [scenefile] [agents]
+//   --headless [frames]  render offscreen along a scripted camera, then exit
+//   --timings <file>     per-frame timings of a headless run, as CSV
+//   --image <file>       the last headless frame, as a PPM
+//   --trace <file>       profile CPU and GPU zones into a Chrome trace
+//   --record <file>      log every tick's input, for --replay
+//   --replay <file> [speed]  take input from a log, at speed times real time
+//   --pvs                look visibility up in the scenefile's .pvs, faster but approximate
+int main(int argc, char **argv) {
+    ApplicationSpecification spec;
+    int positional = 0;
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--headless")) {
+            spec.headless = true;
+            if(i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9') {
+                spec.headlessFrames = atoi(argv[++i]);
+            }
+        }
+        else if(!strcmp(argv[i], "--timings") && i + 1 < argc) {
+            spec.timingsFile = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--image") && i + 1 < argc) {
+            spec.imageFile = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            spec.traceFile = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--record") && i + 1 < argc) {
+            spec.recordFile = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--replay") && i + 1 < argc) {
+            spec.replayFile = argv[++i];
+            if(i + 1 < argc && argv[i + 1][0] >= '0' && argv[i + 1][0] <= '9') {
+                spec.replaySpeed = atof(argv[++i]);
+            }
+        }
+        else if(!strcmp(argv[i], "--pvs")) {
+            spec.usePvs = true;
+        }
+        else if(argv[i][0] == '-') {
+            std::cerr << "unknown option " << argv[i] << std::endl;
+            return 1;
+        }
+        else if(positional++ == 0) {
+            spec.sceneFile = argv[i];
+        }
+        else {
+            spec.numAgents = atoi(argv[i]);
+        }
+    }
 
-int main() {
-    Application app;
+    Application app(spec);
     
     std::cout << "INITIALIZING APPLICATION..." << std::endl;
     app.Init();
 
     std::cout << "RUNNING APPLICATION..." << std::endl;
     return app.Run();
-}
\ No newline at end of file
+}
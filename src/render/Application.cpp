@@ -9,136 +9,215 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>		// For std::cerr
+#include <chrono>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 
 #include "Math.hpp"
 
-enum {
-	LEVEL_AIR,
-	LEVEL_SPAWN,
-	LEVEL_WALL,
-	LEVEL_GOAL,
-	LEVEL_KEY,
-	LEVEL_DOOR
+#define HEADLESS_FRAME_RATE 60						// Of the virtual clock headless frames run on
+
+// Walls sit at z = 0 and floors at z = -1, both unit cubes
+static const GridCullBounds cellBounds = { -1.5f, 0.5f };
+
+static const glm::vec3 worldMaterialColors[NUM_WORLD_MATERIALS] = {
+	glm::vec3(0.1f, 0.1f, 0.1f),	// Floor
+	glm::vec3(1.f, 1.f, 1.f)		// Wall
 };
 
 Application::~Application() {
 	glfwTerminate();
-	exit(0);
+	exit(m_exitCode);
 }
 
 int Application::Init() {
+	ProfilerSetThreadName("Main");
+	ProfilerEnable(m_spec.traceFile != nullptr);
+
 	LoadMap();
+	LoadReplay();
 	InitializeGL();
 
+	if(m_spec.numAgents > 0) {
+		m_agents.Init(&scene->level, m_spec.agentThreads);
+		int spawned = m_agents.Spawn(m_spec.numAgents, 1);
+		std::cout << spawned << " agents on " << m_agents.NumThreads() << " threads" << std::endl;
+
+		int goalX, goalY;
+		if(m_spec.agentsSeekGoal && FindTile(scene->level, LEVEL_GOAL, goalX, goalY)) {
+			m_goalField.Init(&scene->level, m_spec.agentThreads);
+			auto start = std::chrono::steady_clock::now();
+			m_goalField.Build();
+			std::cout << "goal flow field: " << m_goalField.levels << " steps deep, "
+				<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+			m_agents.SetFlowField(&m_goalField);
+		}
+	}
+
 	return 0;
 }
 
 void Application::LoadMap() {
-	std::ifstream modelFile;
+	PROFILE_ZONE("LoadMap");
+
+	static const char *modelNames[] = { "models/cube", "models/knot" };
 
 	scene = new Scene();
 	scene->numVerts = 0;
+	scene->numIndexBytes = 0;
 	scene->numModels = 0;
 
-	// Cube model
-	modelFile.open("models/cube.txt");
-	int numLines = 0;
-	if(modelFile.is_open()) {
-		modelFile >> numLines;
+	// Models stay mapped (or parsed) until InitializeGL uploads them
+	for(const char *modelName : modelNames) {
+		Mesh &mesh = scene->models[scene->numModels];
+		if(!mesh.Load(modelName)) {
+			std::cerr << "error loading model " << modelName << "!" << std::endl;
+		}
+		std::cout << modelName << " has: " << mesh.numVerts << " verts, " << mesh.numIndices << " indices"
+			<< (mesh.mapped ? " (binary)" : " (text)") << std::endl;
+
+		// Index ranges start 4-byte aligned whatever the size of the one before
+		MeshRange &range = scene->modelRanges[scene->numModels];
+		range.baseVertex = scene->numVerts;
+		range.numIndices = mesh.numIndices;
+		range.indexOffset = (scene->numIndexBytes + 3) & ~(size_t)3;
+		range.indexSize = mesh.indexSize;
+		scene->numVerts += mesh.numVerts;
+		scene->numIndexBytes = range.indexOffset + mesh.IndexBytes();
+		scene->numModels++;
 	}
-	float *cubeModel = new float[numLines];
-	for(int i = 0; i < numLines; i++) {
-		modelFile >> cubeModel[i];
+
+	// Indexes the scenefile for chunk streaming, and validates it
+	if(!world.Open(m_spec.sceneFile, m_spec.streaming)) {
+		std::cerr << "error opening mapfile!" << std::endl;
+		exit(-1);
 	}
-	std::cout << "Cube model has: " << numLines << " lines" << std::endl;
-	int numVertsCube = numLines/8;
-	modelFile.close();
+	std::cout << m_spec.sceneFile << " is " << world.width << "x" << world.height << ", "
+		<< world.NumChunks() << " chunks" << std::endl;
 
-	// Key Model
-	modelFile.open("models/knot.txt");
-	numLines = 0;
-	if(modelFile.is_open()) {
-		modelFile >> numLines;
+	if(world.File().NumCells() <= m_spec.maxLevelCells) {
+		if(!scene->LoadLevel(m_spec.sceneFile)) {
+			std::cerr << "error opening mapfile!" << std::endl;
+		}
+		else if(m_spec.usePvs) {
+			LoadPvs();
+		}
 	}
-	float *keyModel = new float[numLines];
-	for(int i = 0; i < numLines; i++) {
-		modelFile >> keyModel[i];
+	else {
+		std::cout << "Level is too large to keep resident, streaming it for rendering only" << std::endl;
+		const SceneFileRandomAccess &file = world.File();
+		scene->player.origin = Vec3f(file.spawnX, file.spawnY, 0);
 	}
-	std::cout << "Knot model has: " << numLines << " lines" << std::endl;
-	int numVertsKey = numLines/8;
-	modelFile.close();
-
-	scene->modelData = new float[8 * (numVertsCube + numVertsKey)];
-	std::copy(cubeModel, cubeModel + 8 * numVertsCube, (scene->modelData));
-	std::copy(keyModel, keyModel + 8 * numVertsKey, (scene->modelData) + 8 * numVertsCube);
-	scene->numVerts = numVertsCube + numVertsKey;
-	scene->startVerts[0] = 0;
-	scene->startVerts[1] = numVertsCube;
-
-	delete[] cubeModel;
-	delete[] keyModel;
+}
 
-	std::ifstream mapFile;
-	mapFile.open("scenefiles/no_doors.txt");
+// Precomputed visibility is only trusted for the walls it was built from,
+// and only if it reaches as far as the far plane
+void Application::LoadPvs() {
+	PROFILE_ZONE("LoadPvs");
 
-	if(!mapFile) {
-		std::cerr << "error opening mapfile!" << std::endl;
+	std::string pvsFile = PvsFileName(m_spec.sceneFile);
+	if(!m_pvs.Load(pvsFile.c_str())) {
+		return;
 	}
+	if(!m_pvs.Matches(scene->level) || m_pvs.radius < VISIBILITY_RADIUS) {
+		std::cout << pvsFile << " is stale, computing visibility every frame" << std::endl;
+		m_pvs.Release();
+		return;
+	}
+	std::cout << pvsFile << ": " << m_pvs.NumRegions() << " regions, " << m_pvs.CompressedBytes() / 1024 << " KiB" << std::endl;
+}
 
-	std::string line;
-	std::getline(mapFile, line);
-	scene->width = line[0] - '0';
-	scene->height = line[2] - '0';
+// Replays start where the recording did, on its tick rate
+void Application::LoadReplay() {
+	if(!m_spec.replayFile) {
+		return;
+	}
+	if(!m_inputLog.Load(m_spec.replayFile)) {
+		std::cerr << "error loading input log " << m_spec.replayFile << std::endl;
+		exit(-1);
+	}
+	if(m_inputLog.levelHash != HashLevelWalls(scene->level)) {
+		std::cout << m_spec.replayFile << " was recorded on other walls, the replay will not match it" << std::endl;
+	}
+	std::cout << m_spec.replayFile << ": " << m_inputLog.numTicks << " ticks, " << m_inputLog.changes.size()
+		<< " input changes" << std::endl;
 
-	scene->level = new int[scene->width * scene->height];
+	scene->player = m_inputLog.StartPlayer();
+	m_clockScale = m_spec.replaySpeed > 0.0 ? m_spec.replaySpeed : 1.0;
+}
 
-	int gridCount = 0;
-	for(int i = 0; i < scene->height; i++) {
-		std::getline(mapFile, line);
-		for(int j = 0; j < scene->width; j++) {
-			if(line[j] == '0') {
-				scene->level[gridCount] = LEVEL_AIR;
-			}
-			else if(line[j] == 'W') {
-				scene->level[gridCount] = LEVEL_WALL;
-			}
-			else if(line[j] == 'S') {
-				scene->level[gridCount] = LEVEL_AIR;
-				scene->player.origin = Vec3f(j, 0, i);
-			}
-			else if(line[j] == 'G') {
-				scene->level[gridCount] = LEVEL_GOAL;
-			}
+void Application::InitializeGL() {
+	PROFILE_ZONE("InitializeGL");
 
-			gridCount++;
+	if(m_spec.headless) {
+		if(!m_headless.Init(m_spec.width, m_spec.height)) {
+			exit(-1);
 		}
+		std::cout << "Rendering offscreen on " << m_headless.Renderer() << std::endl;
+	}
+	else {
+		OpenWindow();
 	}
 
-	mapFile.close();
-}
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
 
-std::string readShaderSource(const char *fileName) {
-	std::ifstream shaderFile;
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, scene->numVerts * MESH_VERTEX_STRIDE, NULL, GL_STATIC_DRAW);
+
+	// The element buffer binding is part of the VAO
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, scene->numIndexBytes, NULL, GL_STATIC_DRAW);
+
+	// Upload straight from the mapped files, then drop the CPU copies
+	for(int i = 0; i < scene->numModels; i++) {
+		Mesh &mesh = scene->models[i];
+		const MeshRange &range = scene->modelRanges[i];
+		glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * MESH_VERTEX_STRIDE, mesh.SizeBytes(), mesh.vertices);
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.indexOffset, mesh.IndexBytes(), mesh.indices);
+		mesh.Release();
+	}
 
-	shaderFile.open(fileName);
-	if(!shaderFile.is_open()) {
-		std::cerr << "Cannot open shader source file" << std::endl;
-		return NULL;
+	// Create the shader program
+	if(!shader.Load(&glState, "vertex.glsl", "fragment.glsl")) {
+		exit(-1);
 	}
 
-	std::stringstream buffer;
-	buffer << shaderFile.rdbuf();
+	// Tell OpenGL how to set fragment shader input
+	SetMeshAttributes(shader);
+
+	uniModelView = shader.Uniform("modelView");
+	uniModelViewProj = shader.Uniform("modelViewProj");
+	uniNormalMatrix = shader.Uniform("normalMatrix");
+	uniLightDir = shader.Uniform("lightDir");
+	uniTexID = shader.Uniform("texID");
+
+	// Per-instance attributes are left disabled here, single draws feed them as constants
+	colorAttrib = shader.Attrib("inColor");
+	offsetAttrib = shader.Attrib("instanceOffset");
+	glVertexAttrib3f(offsetAttrib, 0.f, 0.f, 0.f);
+
+	glBindVertexArray(0); //Unbind the VAO once we have set all the attributes
+
+	BuildInstances();
+	worldRenderer.Init(&world, vbo, ebo, shader, scene->modelRanges[MODEL_KEY]);
 
-	std::string fileContents = buffer.str();
+	// Setup bound VAOs directly, start the cache from a clean slate
+	glState.Invalidate();
 
-	return fileContents;
+	gpuTimer.Init();
+	gpuProfiler.Init();
+
+	glEnable(GL_DEPTH_TEST);
 }
 
-void Application::InitializeGL() {
+void Application::OpenWindow() {
 	glfwInit();
 
 	// Set window hints
@@ -158,159 +237,544 @@ void Application::InitializeGL() {
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
 		std::cout << "Failed to initialize GLAD" << std::endl;
 		exit(-1);
-	}   
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
-
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, 8 * (scene->numVerts) * sizeof(float), scene->modelData, GL_STATIC_DRAW);
-
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-
-	std::string vertexSourceString = readShaderSource("vertex.glsl");
-	const GLchar *vertexSource = (vertexSourceString.c_str());
-	glShaderSource(vertexShader, 1, &vertexSource, NULL);
-	glCompileShader(vertexShader);
-
-	std::string fragmentSourceString = readShaderSource("fragment.glsl");
-	const GLchar *fragmentSource = (fragmentSourceString.c_str());
-	glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-	glCompileShader(fragmentShader);
-
-	// Create the shader program
-	shaderHandle = glCreateProgram();
+	}
+}
 
-	glAttachShader(shaderHandle, vertexShader);
-	glAttachShader(shaderHandle, fragmentShader);
+// Collect every grid cell into one instance list per model
+void Application::BuildInstances() {
+	std::vector<InstanceData> cubes;
+	std::vector<InstanceData> keys;
 
-	glLinkProgram(shaderHandle); 
+	const TileGrid &level = scene->level;
+	std::vector<CellSpan> rows;
+	for(int y = 0; y < level.height; y++) {
+		rows.push_back({ y, 0, level.width });
+	}
+	BuildCellInstances(level, rows, cubes, keys);
 
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	cubeInstances.Init(vbo, ebo, shader, scene->modelRanges[MODEL_CUBE]);
+	cubeInstances.Upload(cubes);
 
-	// Tell OpenGL how to set fragment shader input
-	GLint posAttrib = glGetAttribLocation(shaderHandle, "position");
-	glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), 0);
-	glEnableVertexAttribArray(posAttrib);
+	keyInstances.Init(vbo, ebo, shader, scene->modelRanges[MODEL_KEY]);
+	keyInstances.Upload(keys);
 
-	GLint normAttrib = glGetAttribLocation(shaderHandle, "inNormal");
-	glVertexAttribPointer(normAttrib, 3, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(5*sizeof(float)));
-	glEnableVertexAttribArray(normAttrib);
-	
-	GLint texAttrib = glGetAttribLocation(shaderHandle, "inTexcoord");
-	glEnableVertexAttribArray(texAttrib);
-	glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 8*sizeof(float), (void*)(3*sizeof(float)));
+	agentInstances.Init(vbo, ebo, shader, scene->modelRanges[MODEL_KEY]);
+}
 
-	GLint uniView = glGetUniformLocation(shaderHandle, "view");
-	GLint uniProj = glGetUniformLocation(shaderHandle, "proj");
+// Same as BuildInstances, but only for the cells that survived culling
+void Application::BuildVisibleInstances() {
+	m_visibleCubes.clear();
+	m_visibleKeys.clear();
 
-	glBindVertexArray(0); //Unbind the VAO once we have set all the attributes
+	BuildCellInstances(scene->level, m_visibleSpans, m_visibleCubes, m_visibleKeys);
 
-	glEnable(GL_DEPTH_TEST);
+	cubeInstances.UploadStreaming(m_visibleCubes);
+	keyInstances.UploadStreaming(m_visibleKeys);
 }
 
 void Application::BeginRendering() {
+	PROFILE_ZONE("BeginRendering");
+
 	// Clear the frame
 	glClearColor(0.6f, 0.8f, 1.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	glUseProgram(shaderHandle);
+	shader.Use();
 
-	scene->deltaTime = glfwGetTime();
+	// Close enough to stand next to a wall without clipping into it
+	const float zNear = 0.05f;
+	const float zFar = VIEW_FAR;
 
-	glm::mat4 view = glm::lookAt(
-	glm::vec3(5.0f, 0.0f, 0.0f),
-	glm::vec3(0.0f, 0.0f, 0.0f),
+	glm::vec3 forward(cosf(m_player.yaw) * cosf(m_player.pitch), sinf(m_player.yaw) * cosf(m_player.pitch), sinf(m_player.pitch));
+	m_eye = glm::vec3(m_player.origin.x, m_player.origin.y, m_player.origin.z);
+	m_view = glm::lookAt(
+	m_eye,
+	m_eye + forward,
 	glm::vec3(0.0f, 0.0f, 1.0f)	);
-	
-	glm::mat4(1);
 
-	glm::mat4 proj = glm::perspective(glm::radians(45.0f), m_spec.width / (float) m_spec.height, 1.0f, 10.0f);
-	
-	GLuint transformView = glGetUniformLocation(shaderHandle, "view");
-	glUniformMatrix4fv(transformView, 1, GL_FALSE, glm::value_ptr(view));
+	m_proj = glm::perspective(glm::radians(45.0f), m_spec.width / (float) m_spec.height, zNear, zFar);
 
-	GLuint transformProj = glGetUniformLocation(shaderHandle, "proj");
-	glUniformMatrix4fv(transformProj, 1, GL_FALSE, glm::value_ptr(proj));
+	m_frustum.Extract(glm::value_ptr(m_proj * m_view));
 
-	glBindVertexArray(vao);
+	// Walls only hide what is behind them while the eye is below their tops
+	m_occlusion = m_spec.occlusionCulling && m_eye.z < cellBounds.zMax && scene->level.width > 0;
+	if(m_occlusion) {
+		if(!m_pvs.Lookup(m_eye.x, m_eye.y, m_visibility)) {
+			m_visibility.Compute(scene->level, m_eye.x, m_eye.y, VISIBILITY_RADIUS);
+		}
+	}
+
+	// The grid paths draw whole cells, the baked path culls its own chunks
+	m_visibleSpans.clear();
+	if(!m_spec.bakeWorld) {
+		if(m_spec.frustumCulling) {
+			CullGrid(m_frustum, cellBounds, 0, 0, scene->level.width, scene->level.height, m_visibleSpans, m_stats.cull);
+		}
+		else {
+			for(int y = 0; y < scene->level.height; y++) {
+				m_visibleSpans.push_back({ y, 0, scene->level.width });
+			}
+			m_stats.cull.cellsVisible += scene->level.width * scene->level.height;
+		}
+
+		if(m_occlusion) {
+			m_unoccludedSpans.clear();
+			m_visibility.FilterSpans(m_visibleSpans, m_unoccludedSpans, m_stats.cull);
+			m_visibleSpans.swap(m_unoccludedSpans);
+		}
+	}
+
+	// The light is directional, only the view rotation applies
+	glm::vec3 lightDir = glm::normalize(glm::vec3(-1.f, 1.f, -1.f));
+	shader.SetVec3(uniLightDir, glm::vec3(m_view * glm::vec4(lightDir, 0.f)));
+	shader.SetInt(uniTexID, -1);
+
+	glState.BindVertexArray(vao);
+}
+
+// Everything per draw that used to be derived per vertex in the shader
+void Application::SetModelMatrix(const glm::mat4 &model) {
+	glm::mat4 modelView = m_view * model;
+	shader.SetMat4(uniModelView, modelView);
+	shader.SetMat4(uniModelViewProj, m_proj * modelView);
+	shader.SetMat3(uniNormalMatrix, glm::transpose(glm::inverse(glm::mat3(modelView))));
 }
 
 void Application::RenderScene() {
+	PROFILE_ZONE("RenderScene");
+
 	BeginRendering();
 
-	int gridCount = 0;
-	for(int y = 0; y < scene->height; y++) {
-		for(int x = 0; x < scene->width; x++) {
-			if(scene->level[gridCount] == LEVEL_WALL) {
-				DrawModel(scene->startVerts[0], scene->startVerts[1], glm::vec3(x, y, 0), glm::mat4(1), glm::vec3(1.f, 1.f, 1.f));
+	if(m_spec.bakeWorld) {
+		SetModelMatrix(glm::mat4(1));
+
+		m_stats.drawCalls += worldRenderer.Draw(glState, colorAttrib, worldMaterialColors,
+			m_spec.frustumCulling ? &m_frustum : nullptr, m_occlusion ? &m_visibility : nullptr, m_stats.cull);
+		m_stats.instances += worldRenderer.NumKeys();
+		return;
+	}
+
+	if(m_spec.instancing) {
+		SetModelMatrix(glm::mat4(1));
+
+		// Occlusion narrows the spans even with frustum culling off
+		if(m_spec.frustumCulling || m_spec.occlusionCulling) {
+			BuildVisibleInstances();
+		}
+
+		cubeInstances.Draw(glState);
+		keyInstances.Draw(glState);
+
+		m_stats.drawCalls += 2;
+		m_stats.instances += cubeInstances.NumInstances() + keyInstances.NumInstances();
+		return;
+	}
+
+	const TileGrid &level = scene->level;
+	for(const CellSpan &span : m_visibleSpans) {
+		int y = span.y;
+		for(int x = span.x0; x < span.x1; x++) {
+			int tile = level.At(x, y);
+			if(tile == LEVEL_WALL) {
+				DrawModel(scene->modelRanges[MODEL_CUBE], glm::vec3(x, y, 0), glm::mat4(1), glm::vec3(1.f, 1.f, 1.f));
 			}
-			else if(scene->level[gridCount] == LEVEL_KEY) {
-				DrawModel(scene->startVerts[1], scene->startVerts[2], glm::vec3(x, y, 0), glm::mat4(1), glm::vec3(0.f, 1.f, 0.f));
+			else if(tile == LEVEL_KEY) {
+				DrawModel(scene->modelRanges[MODEL_KEY], glm::vec3(x, y, 0), glm::mat4(1), glm::vec3(0.f, 1.f, 0.f));
 			}
 
-			DrawModel(scene->startVerts[0], scene->startVerts[1], glm::vec3(x, y, -1), glm::mat4(1), glm::vec3(0.1f, 0.1f, 0.1f));
-			gridCount++;
+			DrawModel(scene->modelRanges[MODEL_CUBE], glm::vec3(x, y, -1), glm::mat4(1), glm::vec3(0.1f, 0.1f, 0.1f));
 		}
 	}
 }
 
-void Application::DrawModel(int startVert, int NumVerts, glm::vec3 pos, glm::mat4 rotatMat, glm::vec3 color) {
-	GLint uniColor = glGetUniformLocation(shaderHandle, "inColor");
-	glUniform3fv(uniColor, 1, glm::value_ptr(color));
-    GLint uniTexID = glGetUniformLocation(shaderHandle, "texID");
+// Agents are red knots, culled like cells by the frustum and the walls
+void Application::DrawAgents() {
+	PROFILE_ZONE("DrawAgents");
+
+	m_visibleAgents.clear();
+	for(size_t i = 0; i + 1 < m_agentPositions.size(); i += 2) {
+		float x = m_agentPositions[i], y = m_agentPositions[i + 1];
+		if(m_spec.frustumCulling) {
+			float boxMin[3] = { x - 0.5f, y - 0.5f, -0.5f }, boxMax[3] = { x + 0.5f, y + 0.5f, 0.5f };
+			if(m_frustum.TestBox(boxMin, boxMax) == CULL_OUTSIDE) {
+				continue;
+			}
+		}
+		if(m_occlusion && !m_visibility.IsVisible((int)floorf(x + 0.5f), (int)floorf(y + 0.5f))) {
+			continue;
+		}
+		m_visibleAgents.push_back({ { x, y, 0.f }, { 1.f, 0.2f, 0.1f } });
+	}
+	if(m_visibleAgents.empty()) {
+		return;
+	}
+
+	SetModelMatrix(glm::mat4(1));
+	agentInstances.UploadStreaming(m_visibleAgents);
+	agentInstances.Draw(glState);
+
+	m_stats.drawCalls++;
+	m_stats.instances += agentInstances.NumInstances();
+}
+
+void Application::DrawModel(const MeshRange &range, glm::vec3 pos, glm::mat4 rotatMat, glm::vec3 color) {
+	PROFILE_ZONE("DrawModel");
+
+	glState.VertexAttrib3fv(colorAttrib, glm::value_ptr(color));
 
 	glm::mat4 model = glm::mat4(1);
 	
 	model = glm::translate(model, pos);
-	GLint uniModel = glGetUniformLocation(shaderHandle, "model");
-	glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model));
-
-	glUniform1i(uniTexID, -1);
+	SetModelMatrix(model);
 	
-	glDrawArrays(GL_TRIANGLES, startVert, NumVerts);
+	glState.BindVertexArray(vao);
+	glState.DrawElements(GL_TRIANGLES, range);
+
+	m_stats.drawCalls++;
+	m_stats.instances++;
 }
 
-int Application::Run() {
-	while(!glfwWindowShouldClose(m_window)) {
-		// Process input and events
-		ProcessInput(m_window);
+void Application::DrawFrame() {
+	gpuProfiler.BeginFrame();
 
+	if(m_spec.bakeWorld) {
+		PROFILE_ZONE("StreamWorld");
+		worldRenderer.Update(glState, m_player.origin.x, m_player.origin.y);
+	}
+
+	gpuTimer.Begin();
+	{
+		GpuProfileScope gpuZone(gpuProfiler, "RenderScene");
 		RenderScene();
+	}
+	{
+		GpuProfileScope gpuZone(gpuProfiler, "DrawAgents");
+		DrawAgents();
+	}
+	gpuTimer.End();
+}
+
+int Application::Run() {
+	AgentSim *agents = m_spec.numAgents > 0 ? &m_agents : nullptr;
+	if(m_spec.replayFile) {
+		m_sim.Init(scene->player, &scene->level, agents, m_inputLog.tickSeconds);
+		m_sim.Replay(&m_inputLog);
+	}
+	else {
+		m_sim.Init(scene->player, &scene->level, agents);
+		if(m_spec.recordFile) {
+			m_inputLog.Begin(m_sim.TickSeconds(), HashLevelWalls(scene->level), scene->player);
+			m_sim.Record(&m_inputLog);
+		}
+	}
+
+	int result = 0;
+	if(m_spec.headless) {
+		result = RunHeadless();
+	}
+	else {
+		// The thread keeps to real time
+		if(m_spec.threadedSimulation && m_clockScale == 1.0) {
+			m_sim.Start();
+		}
+
+		while(!glfwWindowShouldClose(m_window)) {
+			if(m_sim.ReplayFinished()) {
+				glfwSetWindowShouldClose(m_window, true);
+			}
+
+			ProfilerBeginFrame();
+
+			// Process input and events
+			ProcessInput(m_window);
+			UpdateSimulation();
+
+			DrawFrame();
+
+			// glfwSetInputMode(m_window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+			// glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+			// Diplay the frame
+			{
+				PROFILE_ZONE("SwapBuffers");
+				glfwSwapBuffers(m_window);
+			}
+
+			UpdateFrameStats();
+
+			// Poll IO
+			{
+				PROFILE_ZONE("PollEvents");
+				glfwPollEvents();
+			}
+
+			ProfilerEndFrame();
+		}
+	}
 
-		// glfwSetInputMode(m_window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
-		// glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	m_sim.Stop();
+	scene->player = m_sim.Current();
 
-		// Diplay the frame
-		glfwSwapBuffers(m_window);
+	if(m_spec.recordFile) {
+		m_inputLog.Finish(m_sim.Ticks(), scene->player);
+		if(m_inputLog.Save(m_spec.recordFile)) {
+			std::cout << "Recorded " << m_inputLog.numTicks << " ticks, " << m_inputLog.changes.size() << " input changes to "
+				<< m_spec.recordFile << std::endl;
+		}
+		else {
+			std::cerr << "error writing " << m_spec.recordFile << std::endl;
+		}
+	}
 
-		// Poll IO
-		glfwPollEvents();
+	// Same build, same level and same log have to end in the same place
+	if(m_spec.replayFile && !m_sim.ReplayFinished()) {
+		std::cout << "Replay STOPPED after " << m_sim.ReplayedTicks() << " of " << m_inputLog.numTicks << " ticks" << std::endl;
+		result = 1;
+	}
+	else if(m_sim.ReplayFinished()) {
+		bool same = m_inputLog.EndsAt(scene->player);
+		std::cout << "Replay " << (same ? "ends where the recording did" : "DIVERGED from the recording") << std::endl;
+		if(!same) {
+			result = 1;
+		}
+	}
+	m_exitCode = result;
+
+	if(m_spec.traceFile) {
+		gpuProfiler.Flush();
+		if(ProfilerWriteTrace(m_spec.traceFile)) {
+			ProfilerCounts counts = ProfilerGetCounts();
+			std::cout << "Trace of " << counts.zones << " zones written to " << m_spec.traceFile << " (" << counts.dropped
+				<< " dropped, " << counts.untraced << " past the limit, " << gpuProfiler.Dropped() << " GPU zones dropped)"
+				<< std::endl;
+		}
+		else {
+			std::cerr << "error writing " << m_spec.traceFile << std::endl;
+		}
 	}
 
 	// De-allocations
 	scene->~Scene();
 
-	glDeleteProgram(shaderHandle);
+	cubeInstances.Destroy();
+	keyInstances.Destroy();
+	agentInstances.Destroy();
+	worldRenderer.Destroy();
+	world.Close();
+	gpuTimer.Destroy();
+	gpuProfiler.Destroy();
+
+	shader.Destroy();
 	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ebo);
 	glDeleteVertexArrays(1, &vao);
 
+	if(m_spec.headless) {
+		m_headless.Destroy();
+		return result;
+	}
+
 	glfwTerminate();
 
 	std::cout << "Window sucessfully closed" << std::endl;
 
+	return result;
+}
+
+// Frames follow the camera script, or the replayed player, on a virtual
+// clock, so every run draws the same frames with the agents in the same places
+// Each frame is waited for before the next, so its GPU time is its own
+int Application::RunHeadless() {
+	CameraScript camera;
+	camera.Init(scene->level, scene->player);
+
+	// A replay runs to its end, the camera is the player's
+	int frames = std::max(1, m_spec.headlessFrames);
+	if(m_spec.replayFile) {
+		double seconds = m_inputLog.numTicks * m_inputLog.tickSeconds / m_clockScale;
+		frames = (int)ceil(seconds * HEADLESS_FRAME_RATE) + 1;
+		std::cout << "Rendering " << frames << " frames at " << m_spec.width << "x" << m_spec.height << " replaying "
+			<< m_spec.replayFile << std::endl;
+	}
+	else {
+		std::cout << "Rendering " << frames << " frames at " << m_spec.width << "x" << m_spec.height << " along a "
+			<< camera.Length() << " cell route" << std::endl;
+	}
+
+	std::ofstream csv(m_spec.timingsFile, std::ios::trunc);
+	if(!csv.is_open()) {
+		std::cerr << "error writing " << m_spec.timingsFile << std::endl;
+		return 1;
+	}
+	csv << "frame,cpu_ms,gpu_ms,frame_ms,draw_calls,instances,gl_calls,cells_visible,sim_ticks" << std::endl;
+
+	std::vector<double> frameTimes;
+	for(int frame = 0; frame < frames; frame++) {
+		ProfilerBeginFrame();
+		auto start = std::chrono::steady_clock::now();
+
+		// The last frame of a replay reaches the log's end exactly, whatever the rounding
+		double now = frame * m_clockScale / HEADLESS_FRAME_RATE;
+		if(m_spec.replayFile && frame == frames - 1) {
+			now = std::max(now, m_inputLog.numTicks * m_inputLog.tickSeconds);
+		}
+		m_stats.simTicks = m_sim.Advance(now);
+		m_sim.InterpolatedAgents(now, m_agentPositions);
+		m_player = m_spec.replayFile ? m_sim.Interpolated(now) : camera.At(frames > 1 ? frame / (double)(frames - 1) : 0.0);
+
+		DrawFrame();
+		double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		{
+			PROFILE_ZONE("Finish");
+			glFinish();
+		}
+		double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		double gpuMs = 0.0;
+		bool gpuTimed = gpuTimer.Collect(gpuMs) > 0;
+		frameTimes.push_back(frameMs);
+
+		// No GPU time without timer queries, the column is left empty
+		csv << frame << "," << cpuMs << ",";
+		if(gpuTimed) {
+			csv << gpuMs;
+		}
+		csv << "," << frameMs << "," << m_stats.drawCalls << "," << m_stats.instances << "," << glState.counts.issued << ","
+			<< m_stats.cull.cellsVisible << "," << m_stats.simTicks << "\n";
+
+		m_stats.drawCalls = 0;
+		m_stats.instances = 0;
+		m_stats.cull = CullStats();
+		glState.counts = GLCallCounts();
+
+		ProfilerEndFrame();
+	}
+
+	if(m_spec.imageFile && !m_headless.SaveImage(m_spec.imageFile)) {
+		std::cerr << "error writing " << m_spec.imageFile << std::endl;
+	}
+
+	double total = 0.0;
+	for(double ms : frameTimes) {
+		total += ms;
+	}
+	std::sort(frameTimes.begin(), frameTimes.end());
+	std::cout << "frame " << total / frames << " ms mean, " << frameTimes[frames / 2] << " median, "
+		<< frameTimes[(frames - 1) * 95 / 100] << " 95th percentile, " << frameTimes.back() << " max; timings in "
+		<< m_spec.timingsFile << std::endl;
+
+	csv.close();
+	if(!csv) {
+		std::cerr << "error writing " << m_spec.timingsFile << std::endl;
+		return 1;
+	}
 	return 0;
 }
 
 // Process all input
 void Application::ProcessInput(GLFWwindow *window) {
+	PROFILE_ZONE("ProcessInput");
+
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {	// Close on escape
         glfwSetWindowShouldClose(window, true);
 	}
 
-	if(glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) {	// Close on escape
+	// WASD moves, the arrows turn and look
+	PlayerInput input;
+	input.forward = (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) - (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS);
+	input.right = (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) - (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS);
+	input.turn = (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) - (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS);
+	input.look = (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) - (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS);
+	m_sim.SetInput(input);
+}
+
+// Without the thread the frame steps the ticks that came due since the last one
+void Application::UpdateSimulation() {
+	PROFILE_ZONE("UpdateSimulation");
+
+	double now = m_sim.Now() * m_clockScale;
+	if(!m_sim.Running()) {
+		m_sim.Advance(now);
+	}
+	m_player = m_sim.Interpolated(now);
+	m_sim.InterpolatedAgents(now, m_agentPositions);
+	m_stats.simTicks = m_sim.TakeTicks();
+
+	scene->deltaTime = m_lastTime > 0.0 ? (float)(now - m_lastTime) : 0.f;
+	m_lastTime = now;
+}
+
+void Application::UpdateFrameStats() {
+	double now = glfwGetTime();
+	if(m_stats.lastFrame > 0.0) {
+		double frameTime = now - m_stats.lastFrame;
+		m_stats.frameTime += frameTime;
+		m_stats.frameTimeSq += frameTime * frameTime;
+		m_stats.maxFrameTime = std::max(m_stats.maxFrameTime, frameTime);
+		m_stats.minSimTicks = m_stats.frames ? std::min(m_stats.minSimTicks, m_stats.simTicks) : m_stats.simTicks;
+		m_stats.maxSimTicks = m_stats.frames ? std::max(m_stats.maxSimTicks, m_stats.simTicks) : m_stats.simTicks;
+		m_stats.totalSimTicks += m_stats.simTicks;
+		m_stats.frames++;
+		m_stats.totalDrawCalls += m_stats.drawCalls;
+		m_stats.totalInstances += m_stats.instances;
+		m_stats.totalCull += m_stats.cull;
+		m_stats.totalGLIssued += glState.counts.issued;
+		m_stats.totalGLSkipped += glState.counts.skipped;
+	}
+	m_stats.lastFrame = now;
+	m_stats.gpuFrames += gpuTimer.Collect(m_stats.gpuTime);
+
+	if(now - m_stats.lastReport >= 1.0 && m_stats.frames > 0) {
+		double mean = m_stats.frameTime / m_stats.frames;
+		double jitter = sqrt(std::max(0.0, m_stats.frameTimeSq / m_stats.frames - mean * mean));
+		std::cout << "frame " << 1000.0 * mean << " ms (jitter " << 1000.0 * jitter << ", max " << 1000.0 * m_stats.maxFrameTime
+			<< ", gpu "
+			<< (m_stats.gpuFrames ? m_stats.gpuTime / m_stats.gpuFrames : 0.0) << " ms), "
+			<< m_stats.totalDrawCalls / m_stats.frames << " draw calls, "
+			<< m_stats.totalInstances / m_stats.frames << " instances"
+			<< (m_spec.bakeWorld ? " (baked)" : m_spec.instancing ? " (instanced)" : "") << ", GL calls "
+			<< m_stats.totalGLIssued / m_stats.frames << " issued / "
+			<< m_stats.totalGLSkipped / m_stats.frames << " skipped";
+		if(m_spec.frustumCulling || m_spec.occlusionCulling) {
+			const CullStats &cull = m_stats.totalCull;
+			int frames = m_stats.frames;
+			std::cout << ", cull " << cull.nodesTested / frames << " nodes, " << cull.cellsTested / frames << " cells tested, "
+				<< cull.cellsCulled / frames << " culled, " << cull.cellsOccluded / frames << " occluded, "
+				<< cull.cellsVisible / frames << " drawn";
+		}
+		std::cout << ", sim " << (double)m_stats.totalSimTicks / m_stats.frames << " ticks/frame ("
+			<< m_stats.minSimTicks << "-" << m_stats.maxSimTicks << (m_spec.threadedSimulation ? ", threaded)" : ")");
+		FrameTimeSummary summary = ProfilerFrameSummary();
+		std::cout << ", last " << summary.frames << " frames " << summary.minMs << " min / " << summary.avgMs << " avg / "
+			<< summary.p99Ms << " p99 / " << summary.maxMs << " max ms";
+		if(m_spec.numAgents > 0) {
+			AgentTickStats agentStats = m_sim.AgentStats();
+			std::cout << ", agents " << m_agentPositions.size() / 2 << " (think " << agentStats.thinkMs << " ms, move "
+				<< agentStats.moveMs << " ms per tick)";
+		}
+		if(m_spec.bakeWorld) {
+			std::cout << ", chunks " << world.NumResident() << " resident / " << world.NumQueued() << " queued ("
+				<< world.ResidentBytes() / (1024 * 1024) << " MiB)";
+		}
+		std::cout << std::endl;
+
+		m_stats.frames = 0;
+		m_stats.totalDrawCalls = 0;
+		m_stats.totalInstances = 0;
+		m_stats.totalCull = CullStats();
+		m_stats.totalGLIssued = 0;
+		m_stats.totalGLSkipped = 0;
+		m_stats.frameTime = 0.0;
+		m_stats.frameTimeSq = 0.0;
+		m_stats.maxFrameTime = 0.0;
+		m_stats.totalSimTicks = 0;
+		m_stats.gpuFrames = 0;
+		m_stats.gpuTime = 0.0;
+		m_stats.lastReport = now;
 	}
 
+	m_stats.drawCalls = 0;
+	m_stats.instances = 0;
+	m_stats.cull = CullStats();
+	glState.counts = GLCallCounts();
 }
\ No newline at end of file
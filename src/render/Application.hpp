@@ -1,19 +1,96 @@
 #ifndef APPLICATION_INCLUDED
 #define APPLICATION_INCLUDED
 
+// GLAD has to come before GLFW
+#include "glad/glad.h"
 #include <GLFW/glfw3.h>
 #include "Scene.hpp"
+#include "GLState.hpp"
+#include "ShaderProgram.hpp"
+#include "InstanceBatch.hpp"
+#include "GpuTimer.hpp"
+#include "GpuProfiler.hpp"
+#include "HeadlessContext.hpp"
+#include "StaticMesh.hpp"
+#include "WorldMesh.hpp"
+#include "World.hpp"
+#include "WorldRenderer.hpp"
+#include "Frustum.hpp"
+#include "GridCuller.hpp"
+#include "GridVisibility.hpp"
+#include "Pvs.hpp"
+#include "Simulation.hpp"
+#include "Profiler.hpp"
+#include "CameraScript.hpp"
 #include <glm/glm.hpp>
 
 struct ApplicationSpecification {
 	int width = 1200;
 	int height = 900;
 	const char *title = "Maze";
+	const char *sceneFile = "scenefiles/no_doors.txt";
+
+	bool instancing = true;		// One instanced draw per model instead of one draw per cell
+	bool bakeWorld = true;		// Draw walls and floors from baked, streamed world chunks
+	bool frustumCulling = true;	// Skip cells and chunks outside the view frustum
+	bool occlusionCulling = true;	// Skip cells and chunks hidden behind maze walls
+	bool usePvs = false;		// Look visibility up in the scenefile's .pvs when there is a matching one (approximate)
+	bool threadedSimulation = true;	// Step player motion on its own thread instead of between frames
+
+	int numAgents = 0;				// Wandering AI agents, for load testing
+	int agentThreads = 0;			// Workers that step them, 0 uses every core
+	bool agentsSeekGoal = true;		// Follow a flow field to the goal instead of wandering
+
+	// Renders offscreen without a window, headlessFrames frames along a
+	// scripted camera, and writes what each one took to timingsFile
+	bool headless = false;
+	int headlessFrames = 600;
+	const char *timingsFile = "frame_timings.csv";
+	const char *imageFile = nullptr;	// The last headless frame as a PPM, when set
+
+	// Turns the profiler on and writes its zones there on exit, as a Chrome trace
+	const char *traceFile = nullptr;
+
+	// Input log written on exit, or replayed instead of reading the keyboard
+	const char *recordFile = nullptr;
+	const char *replayFile = nullptr;
+	double replaySpeed = 1.0;		// Times real time, other speeds step the simulation between frames
+
+	WorldStreamingConfig streaming;
+
+	// Larger levels are only streamed for rendering, Scene::level stays empty
+	long long maxLevelCells = 64 << 20;
+};
+
+// Per-frame counters, averaged and printed about once a second
+struct FrameStats {
+	int		drawCalls = 0;
+	int		instances = 0;
+	CullStats	cull;
+	int		simTicks = 0;
+
+	int		frames = 0;
+	int		totalDrawCalls = 0;
+	int		totalInstances = 0;
+	CullStats	totalCull;
+	int		totalGLIssued = 0;
+	int		totalGLSkipped = 0;
+	int		gpuFrames = 0;
+	double	gpuTime = 0.0;
+	double	frameTime = 0.0;
+	double	frameTimeSq = 0.0;		// For the jitter, the deviation of frame times
+	double	maxFrameTime = 0.0;
+	int		totalSimTicks = 0;
+	int		minSimTicks = 0;
+	int		maxSimTicks = 0;
+	double	lastFrame = 0.0;
+	double	lastReport = 0.0;
 };
 
 class Application {
 public:
 	Application() {}
+	Application(const ApplicationSpecification &spec) : m_spec(spec) {}
 	~Application();
 
 	int Init();
@@ -22,25 +99,91 @@ public:
 
 private: 
 	void InitializeGL();
+	void OpenWindow();
 	void LoadMap();
+	void LoadPvs();
+	void LoadReplay();
+
 
+	void BuildInstances();
+	void BuildVisibleInstances();
 
 	void BeginRendering();
+	void SetModelMatrix(const glm::mat4 &model);
 	void RenderScene();
-	void DrawModel(int startVert, int NumVerts, glm::vec3 pos, glm::mat4 rotatMat, glm::vec3 color);
+	void DrawAgents();
+	void DrawModel(const MeshRange &range, glm::vec3 pos, glm::mat4 rotatMat, glm::vec3 color);
+	void DrawFrame();
+
+	int RunHeadless();
 
 	void ProcessInput(GLFWwindow *window);
+	void UpdateSimulation();
+	void UpdateFrameStats();
 	
 private:
 
 	ApplicationSpecification m_spec;
 	GLFWwindow *m_window;
+	HeadlessContext m_headless;
 
 	Scene *scene;
-	GLuint shaderHandle;
+
+	// Owns the player while running, rendering only sees the interpolated copy
+	Simulation m_sim;
+	Player m_player;
+	InputLog m_inputLog;
+	double m_clockScale = 1.0;		// Simulation seconds per real second
+	AgentSim m_agents;
+	FlowField m_goalField;
+	std::vector<float> m_agentPositions;
+	double m_lastTime = 0.0;
+	GLState glState;
+	ShaderProgram shader;
+
+	// Resolved once when the shader is linked
+	GLint uniModelView;
+	GLint uniModelViewProj;
+	GLint uniNormalMatrix;
+	GLint uniLightDir;
+	GLint uniTexID;
+	GLint colorAttrib;
+	GLint offsetAttrib;
 
 	GLuint vbo;
+	GLuint ebo;
 	GLuint vao;
+
+	glm::mat4 m_view;
+	glm::mat4 m_proj;
+
+	glm::vec3 m_eye;
+	Frustum m_frustum;
+	std::vector<CellSpan> m_visibleSpans;
+
+	// Walls as occluders, computed from the eye cell each frame
+	bool m_occlusion = false;
+	GridVisibility m_visibility;
+	std::vector<CellSpan> m_unoccludedSpans;
+	Pvs m_pvs;
+
+	GpuTimer gpuTimer;
+	GpuProfiler gpuProfiler;
+
+	InstanceBatch cubeInstances;
+	InstanceBatch keyInstances;
+	InstanceBatch agentInstances;
+	std::vector<InstanceData> m_visibleAgents;
+	std::vector<InstanceData> m_visibleCubes;
+	std::vector<InstanceData> m_visibleKeys;
+
+	World world;
+	WorldRenderer worldRenderer;
+
+	FrameStats m_stats;
+
+	// The destructor exits the process, with this
+	int m_exitCode = 0;
 };
 
 #endif
\ No newline at end of file
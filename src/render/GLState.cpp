@@ -0,0 +1,73 @@
+#include "GLState.hpp"
+
+#include <cstring>
+
+void GLState::UseProgram(GLuint program) {
+	if(program == m_program) {
+		counts.skipped++;
+		return;
+	}
+	glUseProgram(program);
+	m_program = program;
+	counts.issued++;
+}
+
+void GLState::BindVertexArray(GLuint vao) {
+	if(vao == m_vao) {
+		counts.skipped++;
+		return;
+	}
+	glBindVertexArray(vao);
+	m_vao = vao;
+	counts.issued++;
+}
+
+void GLState::VertexAttrib3fv(GLint location, const float *value) {
+	if(location < 0) {
+		return;
+	}
+	if(location < GL_STATE_MAX_ATTRIBS) {
+		if(m_attribValid[location] && memcmp(m_attribs[location], value, sizeof(m_attribs[location])) == 0) {
+			counts.skipped++;
+			return;
+		}
+		memcpy(m_attribs[location], value, sizeof(m_attribs[location]));
+		m_attribValid[location] = true;
+	}
+	glVertexAttrib3fv(location, value);
+	counts.issued++;
+}
+
+void GLState::DrawArrays(GLenum mode, int first, int count) {
+	glDrawArrays(mode, first, count);
+	counts.issued++;
+}
+
+void GLState::DrawArraysInstanced(GLenum mode, int first, int count, int instances) {
+	glDrawArraysInstanced(mode, first, count, instances);
+	counts.issued++;
+}
+
+static GLenum IndexType(const MeshRange &range) {
+	return range.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+void GLState::DrawElements(GLenum mode, const MeshRange &range) {
+	glDrawElementsBaseVertex(mode, range.numIndices, IndexType(range), (void*)range.indexOffset, range.baseVertex);
+	counts.issued++;
+}
+
+void GLState::DrawElementsInstanced(GLenum mode, const MeshRange &range, int instances) {
+	glDrawElementsInstancedBaseVertex(mode, range.numIndices, IndexType(range), (void*)range.indexOffset, instances,
+		range.baseVertex);
+	counts.issued++;
+}
+
+// Unknown state never matches, so the next call of each kind goes through
+void GLState::Invalidate() {
+	m_program = ~0u;
+	m_vao = ~0u;
+	for(int i = 0; i < GL_STATE_MAX_ATTRIBS; i++) {
+		m_attribValid[i] = false;
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef GL_STATE_INCLUDED
+#define GL_STATE_INCLUDED
+
+#include "glad/glad.h"
+#include "Mesh.hpp"
+
+#define GL_STATE_MAX_ATTRIBS 16
+
+// GL calls made through the state cache in the current frame
+struct GLCallCounts {
+	int		issued = 0;
+	int		skipped = 0;
+};
+
+// Shadows the bits of GL state we change every frame and drops calls that
+// would set them to the value they already have
+// Anything that changes this state behind the cache's back must call Invalidate()
+class GLState {
+public:
+	GLState() { Invalidate(); }
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vao);
+	void VertexAttrib3fv(GLint location, const float *value);
+
+	// Draw calls can't be skipped, they are only counted
+	void DrawArrays(GLenum mode, int first, int count);
+	void DrawArraysInstanced(GLenum mode, int first, int count, int instances);
+
+	// Indexed draws of a model in the bound VAO's element buffer
+	void DrawElements(GLenum mode, const MeshRange &range);
+	void DrawElementsInstanced(GLenum mode, const MeshRange &range, int instances);
+
+	void Invalidate();
+
+	GLCallCounts counts;
+
+private:
+	GLuint	m_program;
+	GLuint	m_vao;
+
+	float	m_attribs[GL_STATE_MAX_ATTRIBS][3];
+	bool	m_attribValid[GL_STATE_MAX_ATTRIBS];
+};
+
+#endif
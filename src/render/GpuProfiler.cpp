@@ -0,0 +1,139 @@
+#include "GpuProfiler.hpp"
+
+#include "Profiler.hpp"
+
+void GpuProfiler::Init() {
+	for(QuerySet &set : m_sets) {
+		glGenQueries(2 * GPU_PROFILER_ZONES, set.queries);
+		set.numZones = 0;
+		set.numQueries = 0;
+	}
+	m_current = 0;
+	m_depth = 0;
+	m_active = false;
+	m_dropped = 0;
+	m_initialized = true;
+}
+
+void GpuProfiler::Destroy() {
+	if(!m_initialized) {
+		return;
+	}
+	for(QuerySet &set : m_sets) {
+		glDeleteQueries(2 * GPU_PROFILER_ZONES, set.queries);
+	}
+	m_initialized = false;
+}
+
+void GpuProfiler::ReadBack(QuerySet &set) {
+	if(set.numQueries == 0) {
+		return;
+	}
+
+	// Counters finish in order, the last one stands for the whole set
+	GLint available = 0;
+	glGetQueryObjectiv(set.queries[set.numQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if(!available) {
+		m_dropped += set.numZones;
+		return;
+	}
+
+	for(int i = 0; i < set.numZones; i++) {
+		const Zone &zone = set.zones[i];
+		if(zone.endQuery < 0) {
+			continue;
+		}
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(set.queries[zone.beginQuery], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(set.queries[zone.endQuery], GL_QUERY_RESULT, &end);
+		ProfilerAddEvent({ zone.name, (uint64_t)(begin + m_clockOffset), (uint64_t)(end + m_clockOffset) }, PROFILER_GPU_TRACK);
+	}
+}
+
+void GpuProfiler::BeginFrame() {
+	if(!m_initialized) {
+		return;
+	}
+
+	m_current = (m_current + 1) % GPU_PROFILER_FRAMES;
+	QuerySet &set = m_sets[m_current];
+	ReadBack(set);
+	set.numZones = 0;
+	set.numQueries = 0;
+	m_depth = 0;
+	m_overflow = 0;
+
+	m_active = ProfilerEnabled();
+	if(m_active) {
+		// Does not wait for earlier commands to finish
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		m_clockOffset = (long long)ProfilerNow() - gpuNow;
+	}
+}
+
+void GpuProfiler::Flush() {
+	if(!m_initialized) {
+		return;
+	}
+
+	// Oldest first, the current frame last
+	glFinish();
+	for(int i = 1; i <= GPU_PROFILER_FRAMES; i++) {
+		QuerySet &set = m_sets[(m_current + i) % GPU_PROFILER_FRAMES];
+		ReadBack(set);
+		set.numZones = 0;
+		set.numQueries = 0;
+	}
+	m_depth = 0;
+	m_overflow = 0;
+}
+
+void GpuProfiler::Begin(const char *name) {
+	if(!m_active) {
+		return;
+	}
+
+	// Nested deeper than the stack, only counted so End stays paired
+	if(m_depth == GPU_PROFILER_ZONES) {
+		m_overflow++;
+		m_dropped++;
+		return;
+	}
+
+	QuerySet &set = m_sets[m_current];
+	if(set.numZones == GPU_PROFILER_ZONES) {
+		m_open[m_depth++] = -1;
+		m_dropped++;
+		return;
+	}
+
+	Zone &zone = set.zones[set.numZones];
+	zone.name = name;
+	zone.beginQuery = set.numQueries++;
+	zone.endQuery = -1;
+	glQueryCounter(set.queries[zone.beginQuery], GL_TIMESTAMP);
+	m_open[m_depth++] = set.numZones++;
+}
+
+void GpuProfiler::End() {
+	if(!m_active) {
+		return;
+	}
+	if(m_overflow > 0) {
+		m_overflow--;
+		return;
+	}
+	if(m_depth == 0) {
+		return;
+	}
+
+	int index = m_open[--m_depth];
+	if(index < 0) {
+		return;
+	}
+	QuerySet &set = m_sets[m_current];
+	Zone &zone = set.zones[index];
+	zone.endQuery = set.numQueries++;
+	glQueryCounter(set.queries[zone.endQuery], GL_TIMESTAMP);
+}
@@ -0,0 +1,76 @@
+#ifndef GPU_PROFILER_INCLUDED
+#define GPU_PROFILER_INCLUDED
+
+#include "glad/glad.h"
+
+#define GPU_PROFILER_FRAMES 2		// Query sets in flight, a frame's results are read when its set comes round again
+#define GPU_PROFILER_ZONES 32		// Per frame, later zones are dropped
+
+// GPU zones for the profiler's trace, timed with GL_TIMESTAMP counters so
+// they can nest and run alongside GpuTimer's GL_TIME_ELAPSED query
+// Each frame writes its own query set, read back once the set is reused;
+// a set the GPU has not finished is dropped instead of waited on
+// Zones are placed on the CPU clock by the GPU clock's offset from it
+class GpuProfiler {
+public:
+	GpuProfiler() {}
+
+	void Init();
+	void Destroy();
+
+	// Hands the finished zones of an earlier frame to the profiler
+	void BeginFrame();
+
+	// name has to be a string literal
+	void Begin(const char *name);
+	void End();
+
+	// Waits for every frame still in flight and hands its zones over,
+	// for the end of a run
+	void Flush();
+
+	long long Dropped() const { return m_dropped; }
+
+private:
+	struct Zone {
+		const char	*name;
+		int			beginQuery;
+		int			endQuery;
+	};
+
+	struct QuerySet {
+		GLuint		queries[2 * GPU_PROFILER_ZONES];
+		Zone		zones[GPU_PROFILER_ZONES];
+		int			numZones = 0;
+		int			numQueries = 0;
+	};
+
+	void ReadBack(QuerySet &set);
+
+	QuerySet	m_sets[GPU_PROFILER_FRAMES];
+	int			m_current = 0;
+	bool		m_active = false;		// Profiler enabled when the frame began
+
+	int			m_open[GPU_PROFILER_ZONES];		// Zones begun and not ended, -1 for a dropped one
+	int			m_depth = 0;
+	int			m_overflow = 0;
+
+	long long	m_clockOffset = 0;		// CPU minus GPU nanoseconds
+	long long	m_dropped = 0;
+	bool		m_initialized = false;
+};
+
+// Times the rest of the enclosing block on the GPU
+class GpuProfileScope {
+public:
+	GpuProfileScope(GpuProfiler &profiler, const char *name) : m_profiler(profiler) { profiler.Begin(name); }
+	~GpuProfileScope() { m_profiler.End(); }
+
+	GpuProfileScope(const GpuProfileScope &) = delete;
+	GpuProfileScope &operator=(const GpuProfileScope &) = delete;
+
+private:
+	GpuProfiler	&m_profiler;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "GpuTimer.hpp"
+
+void GpuTimer::Init() {
+	glGenQueries(GPU_TIMER_QUERIES, m_queries);
+	m_next = 0;
+	m_pending = 0;
+}
+
+void GpuTimer::Destroy() {
+	glDeleteQueries(GPU_TIMER_QUERIES, m_queries);
+	m_pending = 0;
+}
+
+void GpuTimer::Begin() {
+	// Every query is in flight, drop the oldest result rather than stall on it
+	if(m_pending == GPU_TIMER_QUERIES) {
+		m_pending--;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[m_next]);
+}
+
+void GpuTimer::End() {
+	glEndQuery(GL_TIME_ELAPSED);
+	m_next = (m_next + 1) % GPU_TIMER_QUERIES;
+	m_pending++;
+}
+
+int GpuTimer::Collect(double &totalMs) {
+	int collected = 0;
+	while(m_pending > 0) {
+		GLuint query = m_queries[(m_next - m_pending + GPU_TIMER_QUERIES) % GPU_TIMER_QUERIES];
+
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if(!available) {
+			break;
+		}
+
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+		totalMs += ns / 1e6;
+
+		m_pending--;
+		collected++;
+	}
+	return collected;
+}
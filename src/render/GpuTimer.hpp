@@ -0,0 +1,30 @@
+#ifndef GPU_TIMER_INCLUDED
+#define GPU_TIMER_INCLUDED
+
+#include "glad/glad.h"
+
+#define GPU_TIMER_QUERIES 4
+
+// GL_TIME_ELAPSED queries over a small ring, so a result is only read back
+// a few frames after it was issued and the CPU never waits on the GPU
+class GpuTimer {
+public:
+	GpuTimer() {}
+
+	void Init();
+	void Destroy();
+
+	void Begin();
+	void End();
+
+	// Adds up the queries that have finished since the last call
+	// Returns how many were collected
+	int Collect(double &totalMs);
+
+private:
+	GLuint	m_queries[GPU_TIMER_QUERIES];
+	int		m_next = 0;
+	int		m_pending = 0;
+};
+
+#endif
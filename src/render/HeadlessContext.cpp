@@ -0,0 +1,150 @@
+#include "HeadlessContext.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <EGL/eglext.h>
+
+static EGLDisplay OpenDisplay() {
+	// Client extensions are queried without a display
+	const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	if(extensions && strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+		auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if(getPlatformDisplay) {
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if(display != EGL_NO_DISPLAY) {
+				return display;
+			}
+		}
+	}
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool HeadlessContext::Init(int width, int height) {
+	m_width = width;
+	m_height = height;
+
+	m_display = OpenDisplay();
+	EGLint major, minor;
+	if(m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, &major, &minor)) {
+		std::cerr << "Failed to open an EGL display" << std::endl;
+		return false;
+	}
+	if(!eglBindAPI(EGL_OPENGL_API)) {
+		std::cerr << "EGL " << major << "." << minor << " has no desktop OpenGL" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	const EGLint configAttribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if(!eglChooseConfig(m_display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+		std::cerr << "No EGL config renders OpenGL" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	const EGLint contextAttribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttribs);
+	if(m_context == EGL_NO_CONTEXT) {
+		std::cerr << "Failed to create an OpenGL 3.3 core context" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	// Rendering goes to our own framebuffer, the surface is only there for
+	// drivers that cannot make a context current without one
+	if(!eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_context)) {
+		const EGLint surfaceAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		m_surface = eglCreatePbufferSurface(m_display, config, surfaceAttribs);
+		if(m_surface == EGL_NO_SURFACE || !eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+			std::cerr << "Failed to make the headless context current" << std::endl;
+			Destroy();
+			return false;
+		}
+	}
+
+	if(!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+		std::cerr << "Failed to initialize GLAD" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	glGenRenderbuffers(1, &m_colorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "Headless framebuffer is incomplete" << std::endl;
+		Destroy();
+		return false;
+	}
+	glViewport(0, 0, width, height);
+
+	return true;
+}
+
+void HeadlessContext::Destroy() {
+	if(m_context != EGL_NO_CONTEXT && eglGetCurrentContext() == m_context) {
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteRenderbuffers(1, &m_colorBuffer);
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+	}
+	m_framebuffer = m_colorBuffer = m_depthBuffer = 0;
+
+	if(m_display != EGL_NO_DISPLAY) {
+		eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if(m_surface != EGL_NO_SURFACE) {
+			eglDestroySurface(m_display, m_surface);
+		}
+		if(m_context != EGL_NO_CONTEXT) {
+			eglDestroyContext(m_display, m_context);
+		}
+		eglTerminate(m_display);
+	}
+	m_display = EGL_NO_DISPLAY;
+	m_context = EGL_NO_CONTEXT;
+	m_surface = EGL_NO_SURFACE;
+}
+
+bool HeadlessContext::SaveImage(const char *fileName) const {
+	std::vector<unsigned char> pixels((size_t)m_width * m_height * 3);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if(!out.is_open()) {
+		return false;
+	}
+	out << "P6\n" << m_width << " " << m_height << "\n255\n";
+
+	// GL rows run bottom up
+	for(int y = m_height - 1; y >= 0; y--) {
+		out.write((const char *)&pixels[(size_t)y * m_width * 3], m_width * 3);
+	}
+	return (bool)out;
+}
+
+const char *HeadlessContext::Renderer() const {
+	return (const char *)glGetString(GL_RENDERER);
+}
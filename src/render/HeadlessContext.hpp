@@ -0,0 +1,36 @@
+#ifndef HEADLESS_CONTEXT_INCLUDED
+#define HEADLESS_CONTEXT_INCLUDED
+
+#include "glad/glad.h"
+#include <EGL/egl.h>
+
+// An OpenGL 3.3 core context without a window or display, through EGL on
+// Mesa's surfaceless platform when it has one, so a software rasterizer
+// such as llvmpipe can render on machines without a GPU
+// Frames go to a framebuffer object that stays bound
+class HeadlessContext {
+public:
+	HeadlessContext() {}
+
+	// Makes the context current and loads GL through GLAD
+	bool Init(int width, int height);
+	void Destroy();
+
+	// The color buffer as a binary PPM, top row first
+	bool SaveImage(const char *fileName) const;
+
+	const char *Renderer() const;
+
+private:
+	EGLDisplay	m_display = EGL_NO_DISPLAY;
+	EGLContext	m_context = EGL_NO_CONTEXT;
+	EGLSurface	m_surface = EGL_NO_SURFACE;
+
+	GLuint		m_framebuffer = 0;
+	GLuint		m_colorBuffer = 0;
+	GLuint		m_depthBuffer = 0;
+	int			m_width = 0;
+	int			m_height = 0;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "InstanceBatch.hpp"
+#include "StaticMesh.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+void InstanceBatch::Init(GLuint modelVbo, GLuint modelEbo, const ShaderProgram &shader, const MeshRange &model) {
+	m_model = model;
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	// Per-vertex stream, same layout as the main VAO
+	glBindBuffer(GL_ARRAY_BUFFER, modelVbo);
+
+	SetMeshAttributes(shader);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, modelEbo);
+
+	// Per-instance stream, advanced once per instance
+	glGenBuffers(1, &m_instanceVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+
+	GLint offsetAttrib = shader.Attrib("instanceOffset");
+	glVertexAttribPointer(offsetAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, offset));
+	glEnableVertexAttribArray(offsetAttrib);
+	glVertexAttribDivisor(offsetAttrib, 1);
+
+	GLint colorAttrib = shader.Attrib("inColor");
+	glVertexAttribPointer(colorAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, color));
+	glEnableVertexAttribArray(colorAttrib);
+	glVertexAttribDivisor(colorAttrib, 1);
+
+	glBindVertexArray(0);
+}
+
+void InstanceBatch::Upload(const std::vector<InstanceData> &instances) {
+	m_numInstances = instances.size();
+
+	m_capacity = instances.size();
+	m_streaming = false;
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData), instances.data(), GL_STATIC_DRAW);
+}
+
+void InstanceBatch::UploadStreaming(const std::vector<InstanceData> &instances) {
+	m_numInstances = instances.size();
+
+	// Orphaning hands the driver a fresh store while the GPU may still read the old one
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+	if(!m_streaming || instances.size() > m_capacity) {
+		m_capacity = std::max(instances.size(), 2 * m_capacity);
+		m_streaming = true;
+	}
+	glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+	if(!instances.empty()) {
+		glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(InstanceData), instances.data());
+	}
+}
+
+void InstanceBatch::Draw(GLState &state) const {
+	if(m_numInstances == 0) {
+		return;
+	}
+	state.BindVertexArray(m_vao);
+	state.DrawElementsInstanced(GL_TRIANGLES, m_model, m_numInstances);
+}
+
+void InstanceBatch::Destroy() {
+	glDeleteBuffers(1, &m_instanceVbo);
+	glDeleteVertexArrays(1, &m_vao);
+	m_instanceVbo = 0;
+	m_vao = 0;
+	m_numInstances = 0;
+	m_capacity = 0;
+	m_streaming = false;
+}
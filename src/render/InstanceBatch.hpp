@@ -0,0 +1,41 @@
+#ifndef INSTANCE_BATCH_INCLUDED
+#define INSTANCE_BATCH_INCLUDED
+
+#include "glad/glad.h"
+#include "GLState.hpp"
+#include "ShaderProgram.hpp"
+#include "CellInstances.hpp"
+
+#include <vector>
+
+// Many copies of one model drawn with a single glDrawElementsInstancedBaseVertex call
+// Owns a VAO that shares the model vertex and index buffers and adds a per-instance stream
+class InstanceBatch {
+public:
+	InstanceBatch() {}
+
+	void Init(GLuint modelVbo, GLuint modelEbo, const ShaderProgram &shader, const MeshRange &model);
+
+	// Instances written once and drawn for many frames
+	void Upload(const std::vector<InstanceData> &instances);
+
+	// Instances rewritten every frame: the buffer is orphaned and refilled,
+	// and only reallocated when the count outgrows it
+	void UploadStreaming(const std::vector<InstanceData> &instances);
+
+	void Draw(GLState &state) const;
+	void Destroy();
+
+	int NumInstances() const { return m_numInstances; }
+
+private:
+	GLuint	m_vao = 0;
+	GLuint	m_instanceVbo = 0;
+
+	MeshRange	m_model;
+	int			m_numInstances = 0;
+	size_t		m_capacity = 0;			// Instances the buffer holds
+	bool		m_streaming = false;	// Allocated as GL_STREAM_DRAW
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "ShaderProgram.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+static std::string ReadShaderSource(const char *fileName) {
+	std::ifstream shaderFile;
+
+	shaderFile.open(fileName);
+	if(!shaderFile.is_open()) {
+		std::cerr << "Cannot open shader source file " << fileName << std::endl;
+		return "";
+	}
+
+	std::stringstream buffer;
+	buffer << shaderFile.rdbuf();
+
+	return buffer.str();
+}
+
+static GLuint CompileShader(GLenum type, const char *fileName) {
+	GLuint shader = glCreateShader(type);
+
+	std::string sourceString = ReadShaderSource(fileName);
+	const GLchar *source = sourceString.c_str();
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	GLint status;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if(!status) {
+		char log[1024];
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		std::cerr << "Failed to compile " << fileName << ":\n" << log << std::endl;
+	}
+
+	return shader;
+}
+
+// Strips the "[0]" GL appends to the names of array uniforms
+static std::string BaseName(const char *name) {
+	std::string s = name;
+	size_t bracket = s.find('[');
+	if(bracket != std::string::npos) {
+		s.resize(bracket);
+	}
+	return s;
+}
+
+bool ShaderProgram::Load(GLState *state, const char *vertexFile, const char *fragmentFile) {
+	m_state = state;
+
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexFile);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentFile);
+
+	m_handle = glCreateProgram();
+	glAttachShader(m_handle, vertexShader);
+	glAttachShader(m_handle, fragmentShader);
+	glLinkProgram(m_handle);
+
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint status;
+	glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+	if(!status) {
+		char log[1024];
+		glGetProgramInfoLog(m_handle, sizeof(log), NULL, log);
+		std::cerr << "Failed to link shader program:\n" << log << std::endl;
+		return false;
+	}
+
+	// Resolve everything the program uses up front
+	char name[256];
+	GLint count, size, maxLocation = -1;
+	GLenum type;
+
+	glGetProgramiv(m_handle, GL_ACTIVE_UNIFORMS, &count);
+	for(GLint i = 0; i < count; i++) {
+		glGetActiveUniform(m_handle, i, sizeof(name), NULL, &size, &type, name);
+		GLint location = glGetUniformLocation(m_handle, name);
+		m_uniforms[BaseName(name)] = location;
+		if(location > maxLocation) {
+			maxLocation = location;
+		}
+	}
+	m_values.assign(maxLocation + 1, CachedValue());
+
+	glGetProgramiv(m_handle, GL_ACTIVE_ATTRIBUTES, &count);
+	for(GLint i = 0; i < count; i++) {
+		glGetActiveAttrib(m_handle, i, sizeof(name), NULL, &size, &type, name);
+		m_attribs[BaseName(name)] = glGetAttribLocation(m_handle, name);
+	}
+
+	return true;
+}
+
+void ShaderProgram::Destroy() {
+	glDeleteProgram(m_handle);
+	m_handle = 0;
+	m_uniforms.clear();
+	m_attribs.clear();
+	m_values.clear();
+}
+
+void ShaderProgram::Use() {
+	m_state->UseProgram(m_handle);
+}
+
+GLint ShaderProgram::Uniform(const char *name) const {
+	auto it = m_uniforms.find(name);
+	return it == m_uniforms.end() ? -1 : it->second;
+}
+
+GLint ShaderProgram::Attrib(const char *name) const {
+	auto it = m_attribs.find(name);
+	return it == m_attribs.end() ? -1 : it->second;
+}
+
+bool ShaderProgram::Update(GLint location, const void *value, size_t size) {
+	if(location < 0) {
+		return false;
+	}
+
+	CachedValue &cached = m_values[location];
+	if(cached.valid && memcmp(cached.data, value, size) == 0) {
+		m_state->counts.skipped++;
+		return false;
+	}
+
+	memcpy(cached.data, value, size);
+	cached.valid = true;
+	m_state->counts.issued++;
+	return true;
+}
+
+// Uniform setters expect the program to be current
+
+void ShaderProgram::SetInt(GLint location, int value) {
+	if(Update(location, &value, sizeof(value))) {
+		glUniform1i(location, value);
+	}
+}
+
+void ShaderProgram::SetVec3(GLint location, const glm::vec3 &value) {
+	if(Update(location, glm::value_ptr(value), 3 * sizeof(float))) {
+		glUniform3fv(location, 1, glm::value_ptr(value));
+	}
+}
+
+void ShaderProgram::SetMat3(GLint location, const glm::mat3 &value) {
+	if(Update(location, glm::value_ptr(value), 9 * sizeof(float))) {
+		glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
+
+void ShaderProgram::SetMat4(GLint location, const glm::mat4 &value) {
+	if(Update(location, glm::value_ptr(value), 16 * sizeof(float))) {
+		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
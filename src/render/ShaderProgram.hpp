@@ -0,0 +1,53 @@
+#ifndef SHADER_PROGRAM_INCLUDED
+#define SHADER_PROGRAM_INCLUDED
+
+#include "glad/glad.h"
+#include "GLState.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A linked vertex + fragment program
+// Every active uniform and attribute location is resolved once at link time,
+// and uniform values are cached so setting an unchanged value costs no GL call
+class ShaderProgram {
+public:
+	ShaderProgram() {}
+
+	bool Load(GLState *state, const char *vertexFile, const char *fragmentFile);
+	void Destroy();
+
+	void Use();
+
+	GLuint Handle() const { return m_handle; }
+
+	// Location lookups, -1 for names that are not active in the program
+	GLint Uniform(const char *name) const;
+	GLint Attrib(const char *name) const;
+
+	void SetInt(GLint location, int value);
+	void SetVec3(GLint location, const glm::vec3 &value);
+	void SetMat3(GLint location, const glm::mat3 &value);
+	void SetMat4(GLint location, const glm::mat4 &value);
+
+private:
+	// Returns false if location already holds value, else stores it
+	bool Update(GLint location, const void *value, size_t size);
+
+	GLState	*m_state = nullptr;
+	GLuint	m_handle = 0;
+
+	std::unordered_map<std::string, GLint>	m_uniforms;
+	std::unordered_map<std::string, GLint>	m_attribs;
+
+	struct CachedValue {
+		bool	valid = false;
+		float	data[16];
+	};
+	std::vector<CachedValue>	m_values;	// Indexed by uniform location
+};
+
+#endif
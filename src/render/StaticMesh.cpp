@@ -0,0 +1,47 @@
+#include "StaticMesh.hpp"
+#include "Mesh.hpp"
+
+static void SetAttribute(GLint location, int size, size_t offset) {
+	if(location < 0) {
+		return;
+	}
+	glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, MESH_VERTEX_STRIDE, (void*)offset);
+	glEnableVertexAttribArray(location);
+}
+
+void SetMeshAttributes(const ShaderProgram &shader) {
+	SetAttribute(shader.Attrib("position"), 3, 0);
+	SetAttribute(shader.Attrib("inTexcoord"), 2, 3*sizeof(float));
+	SetAttribute(shader.Attrib("inNormal"), 3, 5*sizeof(float));
+}
+
+void StaticMesh::Init(const ShaderProgram &shader, const float *vertices, int numVerts) {
+	m_numVerts = numVerts;
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+	glBufferData(GL_ARRAY_BUFFER, numVerts * MESH_VERTEX_STRIDE, vertices, GL_STATIC_DRAW);
+
+	SetMeshAttributes(shader);
+
+	glBindVertexArray(0);
+}
+
+void StaticMesh::Draw(GLState &state, int startVert, int numVerts) const {
+	if(numVerts == 0) {
+		return;
+	}
+	state.BindVertexArray(m_vao);
+	state.DrawArrays(GL_TRIANGLES, startVert, numVerts);
+}
+
+void StaticMesh::Destroy() {
+	glDeleteBuffers(1, &m_vbo);
+	glDeleteVertexArrays(1, &m_vao);
+	m_vbo = 0;
+	m_vao = 0;
+	m_numVerts = 0;
+}
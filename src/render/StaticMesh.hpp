@@ -0,0 +1,30 @@
+#ifndef STATIC_MESH_INCLUDED
+#define STATIC_MESH_INCLUDED
+
+#include "glad/glad.h"
+#include "GLState.hpp"
+#include "ShaderProgram.hpp"
+
+// Points the position/texcoord/normal attributes of shader at the
+// buffer bound to GL_ARRAY_BUFFER, using the model vertex layout
+void SetMeshAttributes(const ShaderProgram &shader);
+
+// Geometry uploaded once into its own VAO and VBO, drawn in vertex ranges
+class StaticMesh {
+public:
+	StaticMesh() {}
+
+	void Init(const ShaderProgram &shader, const float *vertices, int numVerts);
+	void Draw(GLState &state, int startVert, int numVerts) const;
+	void Destroy();
+
+	int NumVerts() const { return m_numVerts; }
+
+private:
+	GLuint	m_vao = 0;
+	GLuint	m_vbo = 0;
+
+	int		m_numVerts = 0;
+};
+
+#endif
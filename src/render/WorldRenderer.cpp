@@ -0,0 +1,124 @@
+#include "WorldRenderer.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+
+void WorldRenderer::Init(World *streamedWorld, GLuint modelVbo, GLuint modelEbo, const ShaderProgram &shader, const MeshRange &keyModel) {
+	m_world = streamedWorld;
+	m_shader = &shader;
+
+	m_chunks.clear();
+	m_chunks.resize(m_world->NumChunks());
+	m_resident.clear();
+
+	m_keys.Init(modelVbo, modelEbo, shader, keyModel);
+	m_keysDirty = false;
+}
+
+void WorldRenderer::Destroy() {
+	for(int index : m_resident) {
+		m_chunks[index]->mesh.Destroy();
+	}
+	m_chunks.clear();
+	m_resident.clear();
+	m_keys.Destroy();
+}
+
+void WorldRenderer::Update(GLState &state, float x, float y) {
+	m_ready.clear();
+	m_evicted.clear();
+	m_world->Update(x, y, m_ready, m_evicted);
+
+	for(int index : m_evicted) {
+		m_chunks[index]->mesh.Destroy();
+		m_keysDirty |= !m_chunks[index]->keys.empty();
+		m_chunks[index].reset();
+		m_resident.erase(std::find(m_resident.begin(), m_resident.end(), index));
+	}
+
+	for(std::unique_ptr<WorldChunk> &ready : m_ready) {
+		std::unique_ptr<ResidentChunk> chunk(new ResidentChunk());
+		const WorldMesh &mesh = ready->mesh;
+
+		// A chunk is at most WORLD_CHUNK_SIZE^2 cells, far below int range in vertices
+		chunk->mesh.Init(*m_shader, mesh.vertices.data(), (int)mesh.NumVerts());
+		for(int i = 0; i < NUM_WORLD_MATERIALS; i++) {
+			chunk->startVerts[i] = (int)mesh.startVerts[i];
+			chunk->numVerts[i] = (int)mesh.numVerts[i];
+		}
+		chunk->keys.swap(ready->keys);
+		m_keysDirty |= !chunk->keys.empty();
+
+		m_chunks[ready->index] = std::move(chunk);
+		m_resident.push_back(ready->index);
+	}
+
+	if(!m_ready.empty()) {
+		state.Invalidate();		// StaticMesh::Init binds its VAO directly
+	}
+	m_ready.clear();
+
+	if(m_keysDirty) {
+		RebuildKeys();
+	}
+}
+
+void WorldRenderer::RebuildKeys() {
+	std::vector<InstanceData> keys;
+	for(int index : m_resident) {
+		const std::vector<int> &cells = m_chunks[index]->keys;
+		for(size_t i = 0; i < cells.size(); i += 2) {
+			keys.push_back({ { (float)cells[i], (float)cells[i + 1], 0.f }, { 0.f, 1.f, 0.f } });
+		}
+	}
+	m_keys.Upload(keys);
+	m_keysDirty = false;
+}
+
+int WorldRenderer::Draw(GLState &state, GLint colorAttrib, const glm::vec3 *materialColors,
+	const Frustum *frustum, const GridVisibility *visibility, CullStats &stats) {
+	int drawCalls = 0;
+
+	// Floors sit at z = -1 and walls at z = 0, both unit cubes
+	m_visible.clear();
+	for(int index : m_resident) {
+		int x0, y0, x1, y1;
+		m_world->ChunkBounds(index, x0, y0, x1, y1);
+		int cells = (x1 - x0) * (y1 - y0);
+
+		if(frustum) {
+			float boxMin[3] = { x0 - 0.5f, y0 - 0.5f, -1.5f };
+			float boxMax[3] = { x1 - 0.5f, y1 - 0.5f, 0.5f };
+			stats.nodesTested++;
+			if(frustum->TestBox(boxMin, boxMax) == CULL_OUTSIDE) {
+				stats.cellsCulled += cells;
+				continue;
+			}
+		}
+		if(visibility && !visibility->AnyVisible(x0, y0, x1, y1)) {
+			stats.cellsOccluded += cells;
+			continue;
+		}
+		stats.cellsVisible += cells;
+		m_visible.push_back(index);
+	}
+
+	for(int i = 0; i < NUM_WORLD_MATERIALS; i++) {
+		state.VertexAttrib3fv(colorAttrib, glm::value_ptr(materialColors[i]));
+		for(int index : m_visible) {
+			const ResidentChunk &chunk = *m_chunks[index];
+			if(chunk.numVerts[i] > 0) {
+				chunk.mesh.Draw(state, chunk.startVerts[i], chunk.numVerts[i]);
+				drawCalls++;
+			}
+		}
+	}
+
+	if(m_keys.NumInstances() > 0) {
+		m_keys.Draw(state);
+		drawCalls++;
+	}
+
+	return drawCalls;
+}
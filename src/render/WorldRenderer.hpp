@@ -0,0 +1,65 @@
+#ifndef WORLD_RENDERER_INCLUDED
+#define WORLD_RENDERER_INCLUDED
+
+#include "glad/glad.h"
+#include "GLState.hpp"
+#include "ShaderProgram.hpp"
+#include "StaticMesh.hpp"
+#include "InstanceBatch.hpp"
+#include "World.hpp"
+#include "Frustum.hpp"
+#include "GridCuller.hpp"
+#include "GridVisibility.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+// GPU side of the streamed world: one static mesh per resident chunk,
+// plus an instance batch for the keys found in resident chunks
+class WorldRenderer {
+public:
+	WorldRenderer() {}
+
+	void Init(World *streamedWorld, GLuint modelVbo, GLuint modelEbo, const ShaderProgram &shader, const MeshRange &keyModel);
+	void Destroy();
+
+	// Streams around (x, y): uploads chunks the world has ready, frees evicted ones
+	void Update(GLState &state, float x, float y);
+
+	// Draws every resident chunk whose bounds touch the frustum and that has
+	// a visible cell (either test is skipped when null), one material at a
+	// time, then the keys
+	// Chunks count as nodes in stats, their cells as culled, occluded or visible
+	// Returns the number of draw calls
+	int Draw(GLState &state, GLint colorAttrib, const glm::vec3 *materialColors,
+		const Frustum *frustum, const GridVisibility *visibility, CullStats &stats);
+
+	int NumKeys() const { return m_keys.NumInstances(); }
+
+private:
+	struct ResidentChunk {
+		StaticMesh			mesh;
+		int					startVerts[NUM_WORLD_MATERIALS];
+		int					numVerts[NUM_WORLD_MATERIALS];
+		std::vector<int>	keys;
+	};
+
+	void RebuildKeys();
+
+	World				*m_world = nullptr;
+	const ShaderProgram	*m_shader = nullptr;
+
+	std::vector<std::unique_ptr<ResidentChunk>>	m_chunks;		// Indexed by chunk
+	std::vector<int>							m_resident;
+	std::vector<int>							m_visible;
+
+	InstanceBatch	m_keys;
+	bool			m_keysDirty = false;
+
+	std::vector<std::unique_ptr<WorldChunk>>	m_ready;
+	std::vector<int>							m_evicted;
+};
+
+#endif
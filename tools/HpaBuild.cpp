@@ -0,0 +1,43 @@
+// Precomputes the cluster graph of a scenefile for hierarchical pathfinding
+// and stores it next to it (maps/a.txt -> maps/a.hpa)
+// Usage: HpaBuild <scene.txt> [clusterSize] [threads]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "Hpa.hpp"
+#include "Scene.hpp"
+
+int main(int argc, char **argv) {
+	if(argc < 2 || argc > 4) {
+		std::cerr << "usage: " << argv[0] << " <scene.txt> [clusterSize] [threads]" << std::endl;
+		return 1;
+	}
+
+	int clusterSize = argc > 2 ? atoi(argv[2]) : HPA_CLUSTER_SIZE;
+	int threads = argc > 3 ? atoi(argv[3]) : 0;
+	if(clusterSize < 2) {
+		std::cerr << "cluster size must be at least 2" << std::endl;
+		return 1;
+	}
+
+	Scene scene;
+	if(!scene.LoadLevel(argv[1])) {
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Hpa hpa;
+	hpa.Build(&scene.level, clusterSize, threads);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::string outFile = HpaFileName(argv[1]);
+	if(!hpa.Save(outFile.c_str())) {
+		std::cerr << "error writing " << outFile << std::endl;
+		return 1;
+	}
+
+	std::cout << argv[1] << " -> " << outFile << ": " << hpa.NumClusters() << " clusters of " << clusterSize << "x" << clusterSize
+		<< ", " << hpa.NumNodes() << " entrance nodes, built in " << seconds << " s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,56 @@
+// Writes a procedural maze out as a scenefile
+// Eller's algorithm is streamed row by row in O(width) memory, so it can
+// produce levels far taller than would fit in memory; the others are
+// generated in memory in parallel bands
+// Usage: MazeGen <algorithm> <roomsX> <roomsY> <seed> <out.txt> [threads]
+#include <cstdlib>
+#include <iostream>
+
+#include "MazeGen.hpp"
+#include "SceneFile.hpp"
+
+int main(int argc, char **argv) {
+	if(argc != 6 && argc != 7) {
+		std::cerr << "usage: " << argv[0] << " <algorithm> <roomsX> <roomsY> <seed> <out.txt> [threads]" << std::endl;
+		std::cerr << "algorithms:";
+		for(int i = 0; i < NUM_MAZE_ALGORITHMS; i++) {
+			std::cerr << " " << MazeAlgorithmName((MazeAlgorithm)i);
+		}
+		std::cerr << std::endl;
+		return 1;
+	}
+
+	int algorithm = MazeAlgorithmFromName(argv[1]);
+	if(algorithm < 0) {
+		std::cerr << "unknown algorithm " << argv[1] << std::endl;
+		return 1;
+	}
+
+	MazeGenConfig config;
+	config.algorithm = (MazeAlgorithm)algorithm;
+	config.roomsX = atoi(argv[2]);
+	config.roomsY = atoi(argv[3]);
+	config.seed = strtoull(argv[4], nullptr, 10);
+	config.threads = argc > 6 ? atoi(argv[6]) : 0;
+	const char *outFile = argv[5];
+
+	if(config.algorithm == MAZE_ELLER) {
+		if(!WriteEllerSceneFile(outFile, config.roomsX, config.roomsY, config.seed)) {
+			std::cerr << "error writing " << outFile << std::endl;
+			return 1;
+		}
+	}
+	else {
+		TileGrid level;
+		if(!GenerateMaze(config, level)) {
+			return 1;
+		}
+		if(!WriteSceneFile(outFile, level)) {
+			std::cerr << "error writing " << outFile << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << argv[1] << " " << config.roomsX << "x" << config.roomsY << " rooms -> " << outFile << std::endl;
+	return 0;
+}
@@ -0,0 +1,50 @@
+// Precomputes the potentially visible sets of a scenefile and stores them
+// next to it, where the renderer picks them up (maps/a.txt -> maps/a.pvs)
+// The radius has to cover the renderer's far plane, VISIBILITY_RADIUS by default
+// Usage: PvsBuild <scene.txt> [radius] [regionSize] [threads]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "Pvs.hpp"
+#include "Scene.hpp"
+
+int main(int argc, char **argv) {
+	if(argc < 2 || argc > 5) {
+		std::cerr << "usage: " << argv[0] << " <scene.txt> [radius] [regionSize] [threads]" << std::endl;
+		return 1;
+	}
+
+	int radius = argc > 2 ? atoi(argv[2]) : VISIBILITY_RADIUS;
+	int regionSize = argc > 3 ? atoi(argv[3]) : PVS_REGION_SIZE;
+	int threads = argc > 4 ? atoi(argv[4]) : 0;
+	if(radius <= 0 || regionSize <= 0) {
+		std::cerr << "radius and region size must be positive" << std::endl;
+		return 1;
+	}
+	if((long long)regionSize + 2LL * radius > PVS_MAX_WINDOW) {
+		std::cerr << "region size + 2 * radius must be at most " << PVS_MAX_WINDOW << std::endl;
+		return 1;
+	}
+
+	Scene scene;
+	if(!scene.LoadLevel(argv[1])) {
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	Pvs pvs;
+	pvs.Build(scene.level, regionSize, radius, threads);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::string outFile = PvsFileName(argv[1]);
+	if(!pvs.Save(outFile.c_str())) {
+		std::cerr << "error writing " << outFile << std::endl;
+		return 1;
+	}
+
+	std::cout << argv[1] << " -> " << outFile << ": " << pvs.NumRegions() << " regions of " << regionSize << "x" << regionSize
+		<< ", radius " << radius << ", built in " << seconds << " s, " << pvs.CompressedBytes() / 1024 << " KiB ("
+		<< pvs.RawBytes() / 1024 << " KiB as plain bitsets)" << std::endl;
+	return 0;
+}